@@ -1,10 +1,29 @@
 LOCAL_PATH := $(call my-dir)
 
+# Hook telemetry and phase tracing for `mockgpsconf stats`; 0 compiles them out
+MOCKGPS_TELEMETRY ?= 1
+
 include $(CLEAR_VARS)
 LOCAL_MODULE    := mockgps
 LOCAL_SRC_FILES := module.cpp
-LOCAL_LDLIBS    := -llog -ldl
-LOCAL_CFLAGS    := -Os -fvisibility=hidden -ffunction-sections -fdata-sections -Wall -Wextra
+LOCAL_LDLIBS    := -llog -ldl -landroid
+LOCAL_CFLAGS    := -Os -fvisibility=hidden -ffunction-sections -fdata-sections -Wall -Wextra -DMOCKGPS_TELEMETRY=$(MOCKGPS_TELEMETRY)
 LOCAL_LDFLAGS   := -Wl,--gc-sections
 LOCAL_CPP_FEATURES := exceptions
 include $(BUILD_SHARED_LIBRARY)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE    := mockgpsconf
+LOCAL_SRC_FILES := mockgpsconf.cpp
+LOCAL_CFLAGS    := -Os -ffunction-sections -fdata-sections -Wall -Wextra -DMOCKGPS_TELEMETRY=$(MOCKGPS_TELEMETRY)
+LOCAL_LDFLAGS   := -Wl,--gc-sections
+LOCAL_CPP_FEATURES := exceptions
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE    := mockgpsctl
+LOCAL_SRC_FILES := mockgpsctl.cpp
+LOCAL_CFLAGS    := -Os -ffunction-sections -fdata-sections -Wall -Wextra -DMOCKGPS_TELEMETRY=$(MOCKGPS_TELEMETRY)
+LOCAL_LDFLAGS   := -Wl,--gc-sections
+LOCAL_CPP_FEATURES := exceptions
+include $(BUILD_EXECUTABLE)
@@ -14,16 +14,21 @@ import android.webkit.WebViewClient;
 import android.webkit.GeolocationPermissions;
 import android.widget.Toast;
 
-import java.io.BufferedReader;
-import java.io.DataOutputStream;
-import java.io.InputStreamReader;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
 
 public class MainActivity extends Activity {
 
     private WebView webView;
     private Handler handler = new Handler(Looper.getMainLooper());
 
-    private static final String CONFIG_PATH = "/data/adb/modules/mockgps/location.conf";
+    // Validates changes, writes location.bin and has the companion apply them at once;
+    // runs as the activity's one root helper
+    private static final String CONTROL_TOOL = "/data/adb/modules/mockgps/bin/mockgpsctl";
+
+    // Every root call runs here in order, the session start first
+    private final ExecutorService rootThread = Executors.newSingleThreadExecutor();
+    private volatile RootSession session;
 
     @Override
     protected void onCreate(Bundle savedInstanceState) {
@@ -42,6 +47,9 @@ public class MainActivity extends Activity {
 
         setContentView(R.layout.activity_main);
 
+        // su once per activity, before the page can ask for anything
+        rootThread.execute(() -> session = RootSession.start(CONTROL_TOOL));
+
         webView = findViewById(R.id.webView);
         WebSettings ws = webView.getSettings();
         ws.setJavaScriptEnabled(true);
@@ -68,51 +76,40 @@ public class MainActivity extends Activity {
     }
 
     private void loadCurrentConfig() {
-        new Thread(() -> {
-            String config = rootExec("cat " + CONFIG_PATH + " 2>/dev/null");
-            if (config != null && !config.isEmpty()) {
-                // Parse config to JSON
-                StringBuilder json = new StringBuilder("{");
-                String[] lines = config.split("\n");
-                boolean first = true;
-                for (String line : lines) {
-                    String[] parts = line.split("=", 2);
-                    if (parts.length == 2) {
-                        if (!first) json.append(",");
-                        first = false;
-                        String key = parts[0].trim();
-                        String val = parts[1].trim();
-                        if (key.equals("enabled") || key.equals("hidedev")) {
-                            json.append("\"").append(key).append("\":").append(val);
-                        } else {
-                            json.append("\"").append(key).append("\":").append(val);
-                        }
-                    }
-                }
-                json.append("}");
+        rootThread.execute(() -> {
+            RootSession s = session;
+            if (s == null) return;
+            // Changes saved from here, the KernelSU page or a script all come back
+            // through the subscription; they update the controls but leave the map
+            RootSession.Config cfg = s.subscribe(changed -> pushConfig("configChanged", changed));
+            if (cfg != null) pushConfig("loadConfig", cfg);
+        });
+    }
 
-                String js = "if(typeof loadConfig==='function')loadConfig(" + json + ");";
-                handler.post(() -> webView.evaluateJavascript(js, null));
-            }
-        }).start();
+    private void pushConfig(String function, RootSession.Config cfg) {
+        String js = "if(typeof " + function + "==='function')" + function + "(" + cfg.toJson() + ");";
+        handler.post(() -> webView.evaluateJavascript(js, null));
     }
 
     class WebBridge {
         @JavascriptInterface
         public void saveConfig(String configText) {
-            new Thread(() -> {
-                // Write config via su
-                String escaped = configText.replace("'", "'\\''");
-                String cmd = "echo '" + escaped + "' > " + CONFIG_PATH + " && chmod 644 " + CONFIG_PATH;
-                String result = rootExec(cmd);
+            rootThread.execute(() -> {
+                // Keeps per-app profiles and returns once every hooked app sees the change
+                RootSession s = session;
+                RootSession.Reply reply = s != null ? s.set(configText) : null;
                 handler.post(() -> {
-                    if (result != null) {
+                    if (reply == null) {
+                        Toast.makeText(MainActivity.this, "Root access required!", Toast.LENGTH_LONG).show();
+                    } else if (reply.status == 0) {
                         Toast.makeText(MainActivity.this, "Config saved ✓", Toast.LENGTH_SHORT).show();
+                    } else if (reply.status == 1) {
+                        Toast.makeText(MainActivity.this, "Config rejected: " + reply.message(), Toast.LENGTH_LONG).show();
                     } else {
-                        Toast.makeText(MainActivity.this, "Root access required!", Toast.LENGTH_LONG).show();
+                        Toast.makeText(MainActivity.this, "Config save failed", Toast.LENGTH_LONG).show();
                     }
                 });
-            }).start();
+            });
         }
 
         @JavascriptInterface
@@ -122,31 +119,20 @@ public class MainActivity extends Activity {
 
         @JavascriptInterface
         public String readConfig() {
-            String result = rootExec("cat " + CONFIG_PATH + " 2>/dev/null");
-            return result != null ? result : "";
+            RootSession s = session;
+            RootSession.Config cfg = s != null ? s.get() : null;
+            return cfg != null ? cfg.toText() : "";
         }
     }
 
-    private String rootExec(String cmd) {
-        try {
-            Process su = Runtime.getRuntime().exec("su");
-            DataOutputStream out = new DataOutputStream(su.getOutputStream());
-            out.writeBytes(cmd + "\n");
-            out.writeBytes("exit\n");
-            out.flush();
-
-            BufferedReader reader = new BufferedReader(new InputStreamReader(su.getInputStream()));
-            StringBuilder sb = new StringBuilder();
-            String line;
-            while ((line = reader.readLine()) != null) {
-                sb.append(line).append("\n");
-            }
-            su.waitFor();
-            return sb.toString().trim();
-        } catch (Exception e) {
-            e.printStackTrace();
-            return null;
-        }
+    @Override
+    protected void onDestroy() {
+        rootThread.execute(() -> {
+            RootSession s = session;
+            if (s != null) s.close();
+        });
+        rootThread.shutdown();
+        super.onDestroy();
     }
 
     @Override
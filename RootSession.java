@@ -0,0 +1,211 @@
+package com.mockgps.app;
+
+import org.json.JSONException;
+import org.json.JSONObject;
+
+import java.io.DataInputStream;
+import java.io.File;
+import java.io.IOException;
+import java.io.OutputStream;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.charset.StandardCharsets;
+import java.util.concurrent.BlockingQueue;
+import java.util.concurrent.LinkedBlockingQueue;
+
+// One `mockgpsctl serve` running as root for the life of the activity. Requests and
+// replies are small binary frames over its stdin and stdout (the protocol is
+// described in mockgpsctl.cpp), so reading or saving the config spawns nothing.
+// Calls block until the reply; make them off the main thread.
+final class RootSession {
+
+    // Frame ops, as CtlOp in mockgpsctl.cpp
+    private static final int GET = 1;
+    private static final int SET = 2;
+    private static final int SUBSCRIBE = 4;
+    private static final int CHANGED = 5;
+
+    private static final int RECORD_SIZE = 48;   // ConfigRecord in config_file.hpp
+
+    interface Listener {
+        // On the session's reader thread
+        void onConfigChanged(Config cfg);
+    }
+
+    // The defaults as the hooks see them, decoded from a ConfigRecord
+    static final class Config {
+        final boolean enabled;
+        final double lat, lng, altitude;
+        final float accuracy, speed, bearing;
+        final boolean hideDev;
+        final boolean route;
+
+        private Config(ByteBuffer r) {
+            lat = r.getDouble();
+            lng = r.getDouble();
+            altitude = r.getDouble();
+            accuracy = r.getFloat();
+            speed = r.getFloat();
+            bearing = r.getFloat();
+            enabled = r.get() != 0;
+            hideDev = r.get() != 0;
+            r.getShort();   // passthrough
+            route = r.get() != 0;
+        }
+
+        static Config parse(byte[] record) {
+            if (record.length != RECORD_SIZE) return null;
+            return new Config(ByteBuffer.wrap(record).order(ByteOrder.LITTLE_ENDIAN));
+        }
+
+        // What map.html's loadConfig() takes
+        String toJson() {
+            try {
+                return new JSONObject()
+                    .put("enabled", enabled ? 1 : 0)
+                    .put("lat", lat)
+                    .put("lng", lng)
+                    .put("accuracy", (double) accuracy)
+                    .put("altitude", altitude)
+                    .put("speed", (double) speed)
+                    .put("bearing", (double) bearing)
+                    .put("hidedev", hideDev ? 1 : 0)
+                    .put("route", route ? 1 : 0)
+                    .toString();
+            } catch (JSONException e) {
+                return "{}";
+            }
+        }
+
+        // KEY=VALUE lines, as `mockgpsctl get` prints them
+        String toText() {
+            return "enabled=" + (enabled ? 1 : 0) + "\n"
+                + "lat=" + lat + "\n"
+                + "lng=" + lng + "\n"
+                + "accuracy=" + accuracy + "\n"
+                + "altitude=" + altitude + "\n"
+                + "speed=" + speed + "\n"
+                + "bearing=" + bearing + "\n"
+                + "hidedev=" + (hideDev ? 1 : 0) + "\n"
+                + "route=" + (route ? 1 : 0) + "\n";
+        }
+    }
+
+    static final class Reply {
+        final int op;
+        final int status;       // the tool's exit status: 0 ok, 1 invalid, 2 I/O
+        final byte[] payload;   // a ConfigRecord, or the error text when status != 0
+
+        Reply(int op, int status, byte[] payload) {
+            this.op = op;
+            this.status = status;
+            this.payload = payload;
+        }
+
+        String message() {
+            return new String(payload, StandardCharsets.UTF_8).trim();
+        }
+    }
+
+    // What a call gets once the helper is gone
+    private static final Reply CLOSED = new Reply(0, 2, "root helper exited".getBytes(StandardCharsets.UTF_8));
+
+    private final Process process;
+    private final OutputStream out;
+    private final BlockingQueue<Reply> replies = new LinkedBlockingQueue<>();
+    private volatile Listener listener;
+    private volatile boolean closed;
+
+    private RootSession(Process process) {
+        this.process = process;
+        this.out = process.getOutputStream();
+        Thread reader = new Thread(this::readFrames, "mockgps-root");
+        reader.setDaemon(true);
+        reader.start();
+    }
+
+    // Start the helper; null without root or without the module
+    static RootSession start(String tool) {
+        RootSession session;
+        try {
+            Process su = new ProcessBuilder("su", "-c", tool + " serve")
+                .redirectError(new File("/dev/null"))
+                .start();
+            session = new RootSession(su);
+        } catch (IOException e) {
+            e.printStackTrace();
+            return null;
+        }
+        if (session.call(GET, new byte[0]) == CLOSED) {
+            session.close();
+            return null;
+        }
+        return session;
+    }
+
+    Config get() {
+        Reply r = call(GET, new byte[0]);
+        return r.status == 0 ? Config.parse(r.payload) : null;
+    }
+
+    // Merge config text into location.bin; returns once every hooked app sees it
+    Reply set(String text) {
+        return call(SET, text.getBytes(StandardCharsets.UTF_8));
+    }
+
+    // The current config; from then on `l` gets every change to it, whoever made it
+    Config subscribe(Listener l) {
+        listener = l;
+        Reply r = call(SUBSCRIBE, new byte[0]);
+        return r.status == 0 ? Config.parse(r.payload) : null;
+    }
+
+    void close() {
+        closed = true;
+        listener = null;
+        process.destroy();
+    }
+
+    private synchronized Reply call(int op, byte[] payload) {
+        if (closed) return CLOSED;
+        if (payload.length > 0xffff) {
+            return new Reply(op, 1, "request too large".getBytes(StandardCharsets.UTF_8));
+        }
+        ByteBuffer frame = ByteBuffer.allocate(4 + payload.length).order(ByteOrder.LITTLE_ENDIAN);
+        frame.put((byte) op).put((byte) 0).putShort((short) payload.length).put(payload);
+        try {
+            out.write(frame.array());
+            out.flush();
+            return replies.take();
+        } catch (IOException e) {
+            return CLOSED;
+        } catch (InterruptedException e) {
+            Thread.currentThread().interrupt();
+            return CLOSED;
+        }
+    }
+
+    private void readFrames() {
+        try (DataInputStream in = new DataInputStream(process.getInputStream())) {
+            byte[] header = new byte[4];
+            for (;;) {
+                in.readFully(header);
+                int op = header[0] & 0xff;
+                int status = header[1] & 0xff;
+                byte[] payload = new byte[(header[2] & 0xff) | (header[3] & 0xff) << 8];
+                in.readFully(payload);
+                if (op != CHANGED) {
+                    replies.add(new Reply(op, status, payload));
+                    continue;
+                }
+                Listener l = listener;
+                Config cfg = Config.parse(payload);
+                if (l != null && cfg != null) l.onConfigChanged(cfg);
+            }
+        } catch (IOException e) {
+            // EOF: the helper exited or close() ended it
+        }
+        closed = true;
+        replies.add(CLOSED);
+    }
+}
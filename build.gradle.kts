@@ -20,6 +20,17 @@ tasks.register("copyZygiskFiles") {
                 val destination = moduleFolder.resolve("zygisk/$abiFolder.so")
                 soFile.copyTo(destination, overwrite = true)
             }
+
+        // AGP packages only shared libraries; take the executables from the CMake output
+        for (tool in listOf("mockgpsconf", "mockgpsctl")) {
+            zygiskBuildDir.resolve("intermediates/cxx").walk()
+                .filter { it.isFile && it.name == tool && it.parentFile.parentFile.name == "obj" }
+                .forEach { exe ->
+                    val abiFolder = exe.parentFile.name
+                    val destination = moduleFolder.resolve("bin/$abiFolder/$tool")
+                    exe.copyTo(destination, overwrite = true)
+                }
+        }
     }
 }
 
@@ -40,6 +40,12 @@ for abi in arm64-v8a armeabi-v7a; do
         cp "$BUILD_DIR/libs/$abi/libmockgps.so" "$MODULE_DIR/zygisk/$abi.so"
         echo "  ✓ $abi"
     fi
+    for tool in mockgpsconf mockgpsctl; do
+        if [ -f "$BUILD_DIR/libs/$abi/$tool" ]; then
+            mkdir -p "$MODULE_DIR/bin/$abi"
+            cp "$BUILD_DIR/libs/$abi/$tool" "$MODULE_DIR/bin/$abi/$tool"
+        fi
+    done
 done
 
 # Create flashable zip
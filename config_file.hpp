@@ -0,0 +1,842 @@
+// MockGPS - On-disk config: binary location.bin plus the text format for humans
+//
+// A config is a set of defaults plus optional per-app profiles, each keyed by a
+// process name, package name or "uid:<n>" and overriding some of the keys.
+//
+// location.bin holds it in fixed-layout records, read with a header check and no
+// parsing:
+//
+//   offset  size  field
+//        0     4  magic     "MGPS"
+//        4     2  version   kConfigFileVersion; bumped on any layout change
+//        6     2  reserved  0
+//        8     4  size      total bytes, header included
+//       12     4  crc       CRC-32 (IEEE) of all `size` bytes with this field zeroed
+//       16    48  defaults  ConfigRecord
+//       64     4  profiles  number of ProfileRecords
+//       68     4  keyBytes  length of the key area
+//       72  56*n  ProfileRecord[profiles]
+//        .    ..  key area  profile keys, not terminated
+//
+// Version 2 files (the same with 40-byte ConfigRecords, which end before `route`) and
+// version 1 files (header + defaults, 56 bytes) are still read. Little-endian, as on
+// every ABI the module ships for. Writers replace the file with a temp file +
+// rename(), so readers see either the old or the new file; anything else (short,
+// foreign, corrupted, unknown version) is rejected whole.
+//
+// The text format (key=value lines, [profile] sections, see README) stays for hand
+// edits and UIs; the mockgpsconf tool converts between the two. Its parser does not
+// depend on the C locale and allocates only for profiles (and numbers of 64 characters
+// or more).
+
+#pragma once
+
+#include <cerrno>
+#include <charconv>
+#include <climits>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <locale.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "config.hpp"
+
+static constexpr uint32_t kConfigFileMagic   = 0x5350474d;  // "MGPS"
+static constexpr uint16_t kConfigFileVersion = 3;
+
+static constexpr size_t kMaxProfiles    = 255;
+static constexpr size_t kProfileKeyMax  = 128;   // bytes including a terminating NUL
+
+// ═══════════════════════════════════════════════════════════════════
+// Keys and Profiles
+// ═══════════════════════════════════════════════════════════════════
+
+enum ConfigKey : uint8_t {
+    kKeyEnabled,
+    kKeyLat,
+    kKeyLng,
+    kKeyAccuracy,
+    kKeyAltitude,
+    kKeySpeed,
+    kKeyBearing,
+    kKeyHideDev,
+    kKeyOverride,
+    kKeyRoute,
+    kConfigKeyCount
+};
+
+static constexpr const char* kConfigKeyNames[kConfigKeyCount] = {
+    "enabled", "lat", "lng", "accuracy", "altitude", "speed", "bearing", "hidedev", "override", "route",
+};
+
+// Values of the override key: a comma list of these, "all" or "none"
+static constexpr const char* kLocationFieldNames[] = {
+    "lat", "lng", "accuracy", "altitude", "speed", "bearing", "time",
+};
+static_assert(1u << (sizeof(kLocationFieldNames) / sizeof(*kLocationFieldNames)) == kAllLocationFields + 1,
+              "one name per LocationField");
+
+static constexpr uint16_t kAllConfigKeys = (1u << kConfigKeyCount) - 1;
+
+// One [section]: `mask` has bit (1 << ConfigKey) set for each key the section sets;
+// the other fields of `cfg` are unused and the defaults apply
+struct ConfigProfile {
+    std::string key;
+    MockConfig  cfg;
+    uint16_t    mask = 0;
+};
+
+struct ConfigSet {
+    MockConfig                 defaults;
+    uint16_t                   defaultsMask = 0;   // keys present in parsed text; not stored
+    std::vector<ConfigProfile> profiles;
+};
+
+inline void copyConfigKey(MockConfig* dst, const MockConfig& src, int key) {
+    switch (key) {
+    case kKeyEnabled:  dst->enabled  = src.enabled;  break;
+    case kKeyLat:      dst->lat      = src.lat;      break;
+    case kKeyLng:      dst->lng      = src.lng;      break;
+    case kKeyAccuracy: dst->accuracy = src.accuracy; break;
+    case kKeyAltitude: dst->altitude = src.altitude; break;
+    case kKeySpeed:    dst->speed    = src.speed;    break;
+    case kKeyBearing:  dst->bearing  = src.bearing;  break;
+    case kKeyHideDev:  dst->hideDev  = src.hideDev;  break;
+    case kKeyOverride: dst->overrides = src.overrides; break;
+    case kKeyRoute:    dst->route    = src.route;    break;
+    }
+}
+
+inline void copyConfigKeys(MockConfig* dst, const MockConfig& src, uint16_t mask) {
+    for (int k = 0; k < kConfigKeyCount; k++) {
+        if (mask & (1u << k)) copyConfigKey(dst, src, k);
+    }
+}
+
+inline MockConfig resolveProfile(const MockConfig& defaults, const ConfigProfile& p) {
+    MockConfig cfg = defaults;
+    copyConfigKeys(&cfg, p.cfg, p.mask);
+    return cfg;
+}
+
+inline const ConfigProfile* findProfile(const ConfigSet& set, std::string_view key) {
+    for (const auto& p : set.profiles) {
+        if (p.key == key) return &p;
+    }
+    return nullptr;
+}
+
+// Profile keys: "uid:<n>" (stored without leading zeros) or a process/package name
+// of [A-Za-z0-9._:-]. Writes the canonical form to `out`; false if invalid.
+inline bool canonicalProfileKey(std::string_view key, std::string* out) {
+    if (key.empty() || key.size() >= kProfileKeyMax) return false;
+    if (key.substr(0, 4) == "uid:") {
+        std::string_view digits = key.substr(4);
+        uint32_t uid;
+        auto r = std::from_chars(digits.data(), digits.data() + digits.size(), uid);
+        if (digits.empty() || r.ec != std::errc() || r.ptr != digits.data() + digits.size() || uid > INT32_MAX) {
+            return false;
+        }
+        *out = "uid:" + std::to_string(uid);
+        return true;
+    }
+    for (char c : key) {
+        bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '.' ||
+                  c == '_' || c == ':' || c == '-';
+        if (!ok) return false;
+    }
+    out->assign(key);
+    return true;
+}
+
+// Apply `update` on top of `base`: keys `update` sets replace those in `base`, other
+// keys and profiles stay. Used to change some settings without restating the rest.
+inline bool mergeConfigSet(ConfigSet* base, const ConfigSet& update) {
+    copyConfigKeys(&base->defaults, update.defaults, update.defaultsMask);
+    base->defaultsMask |= update.defaultsMask;
+    for (const auto& u : update.profiles) {
+        ConfigProfile* p = nullptr;
+        for (auto& b : base->profiles) {
+            if (b.key == u.key) p = &b;
+        }
+        if (!p) {
+            if (base->profiles.size() >= kMaxProfiles) return false;
+            base->profiles.push_back(ConfigProfile{u.key, base->defaults, 0});
+            p = &base->profiles.back();
+        }
+        copyConfigKeys(&p->cfg, u.cfg, u.mask);
+        p->mask |= u.mask;
+    }
+    return true;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Binary Records
+// ═══════════════════════════════════════════════════════════════════
+
+struct ConfigFileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t size;
+    uint32_t crc;
+};
+
+struct ConfigRecord {
+    double   lat;
+    double   lng;
+    double   altitude;
+    float    accuracy;
+    float    speed;
+    float    bearing;
+    uint8_t  enabled;
+    uint8_t  hideDev;
+    uint16_t passthrough;   // LocationFields not overridden; 0 (all overridden) in v1 files
+    uint8_t  route;         // v3; v1 and v2 records end before it
+    uint8_t  reserved[7];
+};
+
+struct ConfigFileV3 {
+    ConfigFileHeader header;
+    ConfigRecord     defaults;
+    uint32_t         profileCount;
+    uint32_t         keyBytes;
+};
+
+struct ProfileRecord {
+    uint32_t     keyOffset;   // into the key area
+    uint16_t     keyLength;
+    uint16_t     mask;        // keys this profile sets; bit (1 << ConfigKey)
+    ConfigRecord config;      // fields outside `mask` hold the defaults
+};
+
+// Records are a prefix of their v3 form in older files
+static constexpr size_t kConfigRecordV2Size = offsetof(ConfigRecord, route);
+static constexpr size_t kConfigFileV1Size   = sizeof(ConfigFileHeader) + kConfigRecordV2Size;
+
+static_assert(sizeof(ConfigFileHeader) == 16, "location.bin header layout");
+static_assert(sizeof(ConfigRecord) == 48, "location.bin config record layout");
+static_assert(kConfigRecordV2Size == 40, "location.bin v1/v2 config record layout");
+static_assert(sizeof(ConfigFileV3) == 72, "location.bin v3 layout");
+static_assert(sizeof(ProfileRecord) == 56, "location.bin profile record layout");
+
+static constexpr size_t kConfigFileMaxSize =
+    sizeof(ConfigFileV3) + kMaxProfiles * (sizeof(ProfileRecord) + kProfileKeyMax - 1);
+
+struct Crc32Table {
+    uint32_t v[256];
+    constexpr Crc32Table() : v() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            v[i] = c;
+        }
+    }
+};
+
+inline uint32_t crc32(const void* data, size_t len, uint32_t crc = 0) {
+    static constexpr Crc32Table table;
+    const auto* p = (const uint8_t*)data;
+    crc = ~crc;
+    while (len--) crc = table.v[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+inline uint32_t configFileCrc(const void* data, size_t size) {
+    static constexpr uint32_t zero = 0;
+    constexpr size_t at = offsetof(ConfigFileHeader, crc);
+    uint32_t crc = crc32(data, at);
+    crc = crc32(&zero, sizeof(zero), crc);
+    return crc32((const uint8_t*)data + at + sizeof(zero), size - at - sizeof(zero), crc);
+}
+
+inline ConfigRecord toConfigRecord(const MockConfig& cfg) {
+    ConfigRecord rec = {};
+    rec.lat      = cfg.lat;
+    rec.lng      = cfg.lng;
+    rec.altitude = cfg.altitude;
+    rec.accuracy = cfg.accuracy;
+    rec.speed    = cfg.speed;
+    rec.bearing  = cfg.bearing;
+    rec.enabled  = cfg.enabled ? 1 : 0;
+    rec.hideDev  = cfg.hideDev ? 1 : 0;
+    rec.passthrough = ~cfg.overrides & kAllLocationFields;
+    rec.route    = cfg.route ? 1 : 0;
+    return rec;
+}
+
+inline MockConfig fromConfigRecord(const ConfigRecord& rec) {
+    MockConfig cfg;
+    cfg.lat      = rec.lat;
+    cfg.lng      = rec.lng;
+    cfg.altitude = rec.altitude;
+    cfg.accuracy = rec.accuracy;
+    cfg.speed    = rec.speed;
+    cfg.bearing  = rec.bearing;
+    cfg.enabled  = rec.enabled != 0;
+    cfg.hideDev  = rec.hideDev != 0;
+    cfg.overrides = ~rec.passthrough & kAllLocationFields;
+    cfg.route    = rec.route != 0;
+    return cfg;
+}
+
+// Whole file image; empty if the set exceeds the format's limits
+inline std::vector<uint8_t> encodeConfigFile(const ConfigSet& set) {
+    std::vector<uint8_t> out;
+    if (set.profiles.size() > kMaxProfiles) return out;
+
+    size_t keyBytes = 0;
+    for (const auto& p : set.profiles) {
+        if (p.key.empty() || p.key.size() >= kProfileKeyMax) return out;
+        keyBytes += p.key.size();
+    }
+    size_t recordsEnd = sizeof(ConfigFileV3) + set.profiles.size() * sizeof(ProfileRecord);
+    out.resize(recordsEnd + keyBytes);
+
+    ConfigFileV3 head = {};
+    head.header.magic   = kConfigFileMagic;
+    head.header.version = kConfigFileVersion;
+    head.header.size    = (uint32_t)out.size();
+    head.defaults       = toConfigRecord(set.defaults);
+    head.profileCount   = (uint32_t)set.profiles.size();
+    head.keyBytes       = (uint32_t)keyBytes;
+
+    uint8_t* records = out.data() + sizeof(ConfigFileV3);
+    size_t keyOffset = 0;
+    for (const auto& p : set.profiles) {
+        // Keys outside the mask are stored as the defaults, like a freshly parsed section
+        MockConfig masked = set.defaults;
+        copyConfigKeys(&masked, p.cfg, p.mask);
+        ProfileRecord rec = {};
+        rec.keyOffset = (uint32_t)keyOffset;
+        rec.keyLength = (uint16_t)p.key.size();
+        rec.mask      = p.mask & kAllConfigKeys;
+        rec.config    = toConfigRecord(masked);
+        memcpy(records, &rec, sizeof(rec));
+        records += sizeof(rec);
+        memcpy(out.data() + recordsEnd + keyOffset, p.key.data(), p.key.size());
+        keyOffset += p.key.size();
+    }
+
+    memcpy(out.data(), &head, sizeof(head));
+    uint32_t crc = configFileCrc(out.data(), out.size());
+    memcpy(out.data() + offsetof(ConfigFileHeader, crc), &crc, sizeof(crc));
+    return out;
+}
+
+// Header and checksum check, then record copies; `len` is the number of bytes available
+inline bool decodeConfigFile(const void* data, size_t len, ConfigSet* out) {
+    ConfigFileHeader header;
+    if (len < kConfigFileV1Size) return false;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != kConfigFileMagic || header.size != len || configFileCrc(data, len) != header.crc) {
+        return false;
+    }
+
+    // Older layouts differ only in the record size; their records are copied into
+    // zeroed v3 records
+    const auto* bytes = (const uint8_t*)data;
+    size_t recordSize = header.version == 3 ? sizeof(ConfigRecord) : kConfigRecordV2Size;
+    size_t countsAt   = sizeof(ConfigFileHeader) + recordSize;
+    ConfigRecord defaults = {};
+    uint32_t counts[2] = {};   // profileCount, keyBytes
+    if (header.version == 1 && len == kConfigFileV1Size) {
+        memcpy(&defaults, bytes + sizeof(header), recordSize);
+    } else if ((header.version == 2 || header.version == 3) && len >= countsAt + sizeof(counts)) {
+        memcpy(&defaults, bytes + sizeof(header), recordSize);
+        memcpy(counts, bytes + countsAt, sizeof(counts));
+    } else {
+        return false;
+    }
+
+    uint32_t profileCount = counts[0], keyBytes = counts[1];
+    if (profileCount > kMaxProfiles) return false;
+    size_t profileSize = offsetof(ProfileRecord, config) + recordSize;
+    size_t recordsAt   = countsAt + sizeof(counts);
+    size_t recordsEnd  = recordsAt + profileCount * profileSize;
+    if (header.version != 1 && recordsEnd + keyBytes != len) return false;
+
+    ConfigSet set;
+    set.defaults = fromConfigRecord(defaults);
+    set.profiles.resize(profileCount);
+    for (uint32_t i = 0; i < profileCount; i++) {
+        ProfileRecord rec = {};
+        memcpy(&rec, bytes + recordsAt + i * profileSize, profileSize);
+        if (!rec.keyLength || rec.keyLength >= kProfileKeyMax || rec.keyOffset > keyBytes ||
+            rec.keyLength > keyBytes - rec.keyOffset) {
+            return false;
+        }
+        auto& p = set.profiles[i];
+        p.key.assign((const char*)bytes + recordsEnd + rec.keyOffset, rec.keyLength);
+        p.cfg  = fromConfigRecord(rec.config);
+        p.mask = rec.mask & kAllConfigKeys;
+        for (uint32_t j = 0; j < i; j++) {
+            if (set.profiles[j].key == p.key) return false;
+        }
+    }
+    *out = std::move(set);
+    return true;
+}
+
+enum class ConfigLoad { kOk, kMissing, kInvalid };
+
+// One read of the whole file: at these sizes cheaper than mmap + munmap (see
+// host/bench/module_bench.cpp), and the layout needs no parsing either way. One byte
+// more than the file is requested to catch a concurrent append.
+inline ConfigLoad loadConfigFile(const char* path, ConfigSet* out) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return errno == ENOENT ? ConfigLoad::kMissing : ConfigLoad::kInvalid;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)kConfigFileV1Size || st.st_size > (off_t)kConfigFileMaxSize) {
+        close(fd);
+        return ConfigLoad::kInvalid;
+    }
+    std::vector<uint8_t> buf(st.st_size + 1);
+    ssize_t n = read(fd, buf.data(), buf.size());
+    close(fd);
+    return n > 0 && decodeConfigFile(buf.data(), (size_t)n, out) ? ConfigLoad::kOk : ConfigLoad::kInvalid;
+}
+
+// Write to "<path>.tmp", fsync, rename over `path`. Returns false with errno set.
+inline bool writeFileAtomic(const char* path, const std::vector<uint8_t>& image) {
+    char tmp[PATH_MAX];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+
+    bool ok = write(fd, image.data(), image.size()) == (ssize_t)image.size() && fsync(fd) == 0;
+    int err = errno;
+    ok = (close(fd) == 0) && ok;
+    if (ok && rename(tmp, path) == 0) return true;
+
+    err = ok ? errno : err;
+    unlink(tmp);
+    errno = err;
+    return false;
+}
+
+inline bool writeConfigFileAtomic(const char* path, const ConfigSet& set) {
+    std::vector<uint8_t> image = encodeConfigFile(set);
+    if (image.empty()) {
+        errno = EINVAL;
+        return false;
+    }
+    return writeFileAtomic(path, image);
+}
+
+inline bool writeConfigFileAtomic(const char* path, const MockConfig& cfg) {
+    ConfigSet set;
+    set.defaults = cfg;
+    return writeConfigFileAtomic(path, set);
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Text Format
+// ═══════════════════════════════════════════════════════════════════
+
+enum class ConfigError : uint8_t {
+    kNone,
+    kBadValue,     // not a number (or integer, for flags), or trailing characters
+    kOutOfRange,   // a number, but not finite or outside the field's range
+};
+
+inline const char* configErrorName(ConfigError e) {
+    switch (e) {
+    case ConfigError::kNone:       return "ok";
+    case ConfigError::kBadValue:   return "bad value";
+    case ConfigError::kOutOfRange: return "out of range";
+    }
+    return "?";
+}
+
+// Outcome of one parse, per key. A rejected value leaves the field at its previous
+// value (the default unless an earlier line set it). The first rejected line of each
+// key is reported; line numbers are 1-based, 0 when nothing was rejected.
+struct ConfigErrors {
+    ConfigError key[kConfigKeyCount] = {};
+    uint32_t    line[kConfigKeyCount] = {};
+    uint32_t    unknownKeys = 0;       // key=value lines with other keys (ignored)
+    uint32_t    malformed = 0;         // non-blank, non-comment lines without '='
+    uint32_t    firstMalformedLine = 0;
+    uint32_t    badSections = 0;       // [headers] with an invalid key, or past kMaxProfiles
+    uint32_t    firstBadSectionLine = 0;
+
+    bool any() const {
+        if (malformed || badSections) return true;
+        for (ConfigError e : key) if (e != ConfigError::kNone) return true;
+        return false;
+    }
+};
+
+inline std::string_view trimConfigField(std::string_view s) {
+    size_t b = 0, e = s.size();
+    while (b < e && (s[b] == ' ' || s[b] == '\t')) b++;
+    while (e > b && (s[e - 1] == ' ' || s[e - 1] == '\t' || s[e - 1] == '\r')) e--;
+    return s.substr(b, e - b);
+}
+
+inline int configKeyIndex(std::string_view key) {
+    for (int i = 0; i < kConfigKeyCount; i++) {
+        if (key == kConfigKeyNames[i]) return i;
+    }
+    return -1;
+}
+
+// Whole-token integer: from_chars is locale-independent and never allocates
+template <class T>
+inline bool parseConfigNumber(std::string_view v, T* out) {
+    static_assert(std::is_integral<T>::value, "real numbers go through parseConfigReal");
+    if (!v.empty() && v[0] == '+') v.remove_prefix(1);
+    const char* end = v.data() + v.size();
+    auto r = std::from_chars(v.data(), end, *out);
+    return r.ec == std::errc() && r.ptr == end;
+}
+
+// Whole-token real number in the "C" locale, with the syntax from_chars accepts. The
+// libc++ in the NDK has no floating-point from_chars, so this goes through
+// strtod_l/strtof_l on a NUL-terminated copy (on the stack below 64 characters).
+template <class T>
+inline bool parseConfigReal(std::string_view v, T* out) {
+    static_assert(std::is_same<T, double>::value || std::is_same<T, float>::value, "double or float");
+    static const locale_t cLocale = newlocale(LC_ALL_MASK, "C", (locale_t)0);
+    if (!v.empty() && v[0] == '+') v.remove_prefix(1);
+    // strtod also takes leading blanks, a second sign and hex floats; from_chars does not
+    if (v.empty() || !cLocale || v[0] == ' ' || v[0] == '\t' || v[0] == '+' ||
+        v.find_first_of("xX") != std::string_view::npos) {
+        return false;
+    }
+    char stack[64];
+    std::string heap;
+    const char* s = stack;
+    if (v.size() < sizeof(stack)) {
+        memcpy(stack, v.data(), v.size());
+        stack[v.size()] = '\0';
+    } else {
+        heap.assign(v);
+        s = heap.c_str();
+    }
+    char* end;
+    errno = 0;
+    if constexpr (std::is_same<T, double>::value) {
+        *out = strtod_l(s, &end, cLocale);
+    } else {
+        *out = strtof_l(s, &end, cLocale);
+    }
+    return errno != ERANGE && end == s + v.size();
+}
+
+template <class T>
+inline ConfigError setConfigNumber(std::string_view v, T* field, double lo, double hi) {
+    T x;
+    if (!parseConfigReal(v, &x)) return ConfigError::kBadValue;
+    if (!std::isfinite(x) || x < lo || x > hi) return ConfigError::kOutOfRange;
+    *field = x;
+    return ConfigError::kNone;
+}
+
+inline ConfigError setConfigFlag(std::string_view v, bool* field) {
+    long x;
+    if (!parseConfigNumber(v, &x)) return ConfigError::kBadValue;
+    *field = x != 0;
+    return ConfigError::kNone;
+}
+
+inline ConfigError setConfigOverrides(std::string_view v, uint16_t* field) {
+    if (v == "all") {
+        *field = kAllLocationFields;
+        return ConfigError::kNone;
+    }
+    if (v == "none") {
+        *field = 0;
+        return ConfigError::kNone;
+    }
+    uint16_t mask = 0;
+    while (true) {
+        size_t comma = v.find(',');
+        std::string_view name = trimConfigField(v.substr(0, comma));
+        uint16_t bit = 0;
+        for (size_t i = 0; i < sizeof(kLocationFieldNames) / sizeof(*kLocationFieldNames); i++) {
+            if (name == kLocationFieldNames[i]) bit = 1u << i;
+        }
+        if (!bit) return ConfigError::kBadValue;
+        mask |= bit;
+        if (comma == std::string_view::npos) break;
+        v.remove_prefix(comma + 1);
+    }
+    *field = mask;
+    return ConfigError::kNone;
+}
+
+inline ConfigError setConfigValue(MockConfig* cfg, int key, std::string_view v) {
+    constexpr double kAny = 1e300;
+    switch (key) {
+    case kKeyEnabled:  return setConfigFlag(v, &cfg->enabled);
+    case kKeyLat:      return setConfigNumber(v, &cfg->lat, -90, 90);
+    case kKeyLng:      return setConfigNumber(v, &cfg->lng, -180, 180);
+    case kKeyAccuracy: return setConfigNumber(v, &cfg->accuracy, 0, kAny);
+    case kKeyAltitude: return setConfigNumber(v, &cfg->altitude, -kAny, kAny);
+    case kKeySpeed:    return setConfigNumber(v, &cfg->speed, 0, kAny);
+    case kKeyBearing:  return setConfigNumber(v, &cfg->bearing, -kAny, kAny);
+    case kKeyHideDev:  return setConfigFlag(v, &cfg->hideDev);
+    case kKeyOverride: return setConfigOverrides(v, &cfg->overrides);
+    case kKeyRoute:    return setConfigFlag(v, &cfg->route);
+    }
+    return ConfigError::kBadValue;
+}
+
+// One pass over `text`, which need not be NUL-terminated (an mmapped file works as
+// is). Lines may be any length and end in \n or \r\n; blank lines and lines starting
+// with '#' are skipped, spaces around keys and values ignored. Keys go to `*cfg`
+// (bits set in `*mask`) until a "[name]" line, which calls onSection(name, line) for
+// the next target; a null target ends the parse.
+template <class OnSection>
+inline void parseConfigLines(std::string_view text, MockConfig* cfg, uint16_t* mask, ConfigErrors& err,
+                             OnSection onSection) {
+    uint32_t lineNo = 0;
+    const char* p   = text.data();
+    const char* end = p + text.size();
+    while (p < end) {
+        const char* nl = (const char*)memchr(p, '\n', end - p);
+        const char* eol = nl ? nl : end;
+        std::string_view line = trimConfigField(std::string_view(p, eol - p));
+        p = eol + 1;
+        lineNo++;
+
+        if (line.empty() || line[0] == '#') continue;
+        if (line[0] == '[' && line.back() == ']') {
+            if (!onSection(trimConfigField(line.substr(1, line.size() - 2)), lineNo, &cfg, &mask)) return;
+            continue;
+        }
+        size_t eq = line.find('=');
+        if (eq == std::string_view::npos) {
+            if (!err.malformed++) err.firstMalformedLine = lineNo;
+            continue;
+        }
+        int key = configKeyIndex(trimConfigField(line.substr(0, eq)));
+        if (key < 0) {
+            err.unknownKeys++;
+            continue;
+        }
+        ConfigError e = setConfigValue(cfg, key, trimConfigField(line.substr(eq + 1)));
+        if (e == ConfigError::kNone) {
+            *mask |= 1u << key;
+        } else if (err.key[key] == ConfigError::kNone) {
+            err.key[key]  = e;
+            err.line[key] = lineNo;
+        }
+    }
+}
+
+// The defaults only: parsing stops at the first [section]. Allocation-free.
+inline MockConfig parseConfig(std::string_view text, ConfigErrors* errors = nullptr) {
+    MockConfig cfg;
+    uint16_t mask = 0;
+    ConfigErrors local;
+    ConfigErrors& err = errors ? *errors : local;
+    err = ConfigErrors();
+    parseConfigLines(text, &cfg, &mask, err, [](std::string_view, uint32_t, MockConfig**, uint16_t**) {
+        return false;
+    });
+    return cfg;
+}
+
+// Defaults and profiles. A section's keys override the defaults for that profile;
+// a section seen twice continues the first one.
+inline void parseConfigSet(std::string_view text, ConfigSet* out, ConfigErrors* errors = nullptr) {
+    ConfigErrors local;
+    ConfigErrors& err = errors ? *errors : local;
+    err = ConfigErrors();
+    *out = ConfigSet();
+
+    MockConfig discard;
+    uint16_t discardMask = 0;
+    std::string key;
+    auto onSection = [&](std::string_view name, uint32_t lineNo, MockConfig** cfg, uint16_t** mask) {
+        ConfigProfile* p = nullptr;
+        if (canonicalProfileKey(name, &key)) {
+            for (auto& existing : out->profiles) {
+                if (existing.key == key) p = &existing;
+            }
+            if (!p && out->profiles.size() < kMaxProfiles) {
+                out->profiles.push_back(ConfigProfile{key, out->defaults, 0});
+                p = &out->profiles.back();
+            }
+        }
+        if (p) {
+            *cfg  = &p->cfg;
+            *mask = &p->mask;
+        } else {
+            // Keys under a rejected header are checked but go nowhere
+            if (!err.badSections++) err.firstBadSectionLine = lineNo;
+            *cfg  = &discard;
+            *mask = &discardMask;
+        }
+        return true;
+    };
+    parseConfigLines(text, &out->defaults, &out->defaultsMask, err, onSection);
+}
+
+// Print one line per problem, prefixed with `name`; returns whether there was any
+inline bool printConfigErrors(FILE* out, const char* name, const ConfigErrors& err) {
+    for (int i = 0; i < kConfigKeyCount; i++) {
+        if (err.key[i] == ConfigError::kNone) continue;
+        fprintf(out, "%s:%u: %s: %s\n", name, err.line[i], kConfigKeyNames[i], configErrorName(err.key[i]));
+    }
+    if (err.malformed) {
+        fprintf(out, "%s:%u: missing '=' (%u line(s))\n", name, err.firstMalformedLine, err.malformed);
+    }
+    if (err.badSections) {
+        fprintf(out, "%s:%u: invalid profile name or more than %zu profiles (%u section(s))\n", name,
+                err.firstBadSectionLine, kMaxProfiles, err.badSections);
+    }
+    return err.any();
+}
+
+// Parse a text config through a read-only mapping. Only for files nothing truncates
+// while we read (the mapping faults past a new EOF): the tool and host harness.
+inline ConfigLoad loadConfigText(const char* path, ConfigSet* out, ConfigErrors* errors = nullptr) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return errno == ENOENT ? ConfigLoad::kMissing : ConfigLoad::kInvalid;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return ConfigLoad::kInvalid;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        parseConfigSet(std::string_view(), out, errors);
+        return ConfigLoad::kOk;
+    }
+    void* mem = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) return ConfigLoad::kInvalid;
+    parseConfigSet(std::string_view((const char*)mem, st.st_size), out, errors);
+    munmap(mem, st.st_size);
+    return ConfigLoad::kOk;
+}
+
+// The config the companion would publish: `bin`, else the text file while `bin` is
+// missing, else the defaults. kInvalid only for a `bin` that fails its header check.
+inline ConfigLoad loadCurrentConfig(const char* bin, const char* text, ConfigSet* out) {
+    ConfigLoad r = loadConfigFile(bin, out);
+    if (r != ConfigLoad::kMissing) return r;
+    if (loadConfigText(text, out) != ConfigLoad::kOk) *out = ConfigSet();
+    return ConfigLoad::kOk;
+}
+
+// Exclusive flock on "<path>.lock" for a read-modify-write of `path`, so writers
+// that each merge into the current file do not lose each other's changes. Held
+// until the returned fd is closed; -1 with errno set. Readers need no lock.
+inline int lockConfigFile(const char* path) {
+    std::string lock = std::string(path) + ".lock";
+    int fd = open(lock.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) return -1;
+    while (flock(fd, LOCK_EX) < 0) {
+        if (errno != EINTR) {
+            int saved = errno;
+            close(fd);
+            errno = saved;
+            return -1;
+        }
+    }
+    return fd;
+}
+
+// Value of the override key: "all", "none" or the field names joined by ','
+inline std::to_chars_result formatConfigOverrides(char* p, char* end, uint16_t mask) {
+    auto put = [&](const char* s) {
+        size_t n = strlen(s);
+        if (end - p < (ptrdiff_t)n) return false;
+        memcpy(p, s, n);
+        p += n;
+        return true;
+    };
+    mask &= kAllLocationFields;
+    bool ok = true;
+    if (mask == kAllLocationFields) {
+        ok = put("all");
+    } else if (!mask) {
+        ok = put("none");
+    } else {
+        const char* sep = "";
+        for (size_t i = 0; i < sizeof(kLocationFieldNames) / sizeof(*kLocationFieldNames) && ok; i++) {
+            if (!(mask & (1u << i))) continue;
+            ok = put(sep) && put(kLocationFieldNames[i]);
+            sep = ",";
+        }
+    }
+    if (!ok) return {end, std::errc::value_too_large};
+    return {p, std::errc()};
+}
+
+// "key=value\n" with the shortest digits that round-trip (to_chars); returns the
+// bytes written, or -1 if they do not fit before `end`
+inline int formatConfigKey(char* p, char* end, int key, const MockConfig& cfg) {
+    size_t len = strlen(kConfigKeyNames[key]);
+    if (end - p < (ptrdiff_t)len + 1) return -1;
+    char* start = p;
+    memcpy(p, kConfigKeyNames[key], len);
+    p += len;
+    *p++ = '=';
+    std::to_chars_result r;
+    switch (key) {
+    case kKeyEnabled:  r = std::to_chars(p, end, cfg.enabled ? 1 : 0); break;
+    case kKeyLat:      r = std::to_chars(p, end, cfg.lat);              break;
+    case kKeyLng:      r = std::to_chars(p, end, cfg.lng);              break;
+    case kKeyAccuracy: r = std::to_chars(p, end, cfg.accuracy);         break;
+    case kKeyAltitude: r = std::to_chars(p, end, cfg.altitude);         break;
+    case kKeySpeed:    r = std::to_chars(p, end, cfg.speed);            break;
+    case kKeyBearing:  r = std::to_chars(p, end, cfg.bearing);          break;
+    case kKeyHideDev:  r = std::to_chars(p, end, cfg.hideDev ? 1 : 0); break;
+    case kKeyRoute:    r = std::to_chars(p, end, cfg.route ? 1 : 0);   break;
+    default:           r = formatConfigOverrides(p, end, cfg.overrides); break;
+    }
+    if (r.ec != std::errc() || r.ptr == end) return -1;
+    *r.ptr = '\n';
+    return (int)(r.ptr + 1 - start);
+}
+
+// Inverse of parseConfig for every key, so parseConfig(formatConfig(cfg)) == cfg.
+// NUL-terminates; returns the length, or -1 when `size` is too small.
+inline int formatConfig(const MockConfig& cfg, char* buf, size_t size) {
+    char* p   = buf;
+    char* end = buf + size;
+    for (int k = 0; k < kConfigKeyCount; k++) {
+        int n = formatConfigKey(p, end, k, cfg);
+        if (n < 0) return -1;
+        p += n;
+    }
+    if (p == end) return -1;
+    *p = 0;
+    return (int)(p - buf);
+}
+
+// Inverse of parseConfigSet: every default, then each profile with only its own keys
+inline std::string formatConfigSet(const ConfigSet& set) {
+    char buf[512];
+    std::string out(buf, formatConfig(set.defaults, buf, sizeof(buf)));
+    for (const auto& p : set.profiles) {
+        out += "\n[" + p.key + "]\n";
+        for (int k = 0; k < kConfigKeyCount; k++) {
+            if (!(p.mask & (1u << k))) continue;
+            int n = formatConfigKey(buf, buf + sizeof(buf), k, p.cfg);
+            out.append(buf, n);
+        }
+    }
+    return out;
+}
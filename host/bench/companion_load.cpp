@@ -0,0 +1,129 @@
+// MockGPS host load generator - companion under a boot-time launch storm
+//
+// Starts N client threads that connect to the companion at the same instant, as the
+// processes specializing at boot do, and times each one from connectCompanion() to
+// the last byte of its reply (what preAppSpecialize blocks on). Every connection
+// gets a Zygisk-style handler thread. Spoofing is on and the runtime entry cached,
+// so every client takes the full reply. Handlers compared:
+//   handler  companion_handler: answer on the handler thread, park only waiting clients
+//   inline   every connection served to completion on its handler thread
+//   epoll    every connection handed to the epoll thread
+//
+//   companion_load [rounds=20] [clients...]     (default clients: 32 128 256)
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "fake_jni.hpp"
+#include "fake_zygisk.hpp"
+#include "module.cpp"
+
+#include "companion_client.hpp"
+
+namespace {
+
+uint64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+double cpuSeconds() {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+void inlineHandler(int fd) {
+    pthread_once(&g_companionOnce, companionInit);
+    CompanionConn conn = {};
+    conn.fd = fd;
+    serveCompanionInline(&conn);
+}
+
+void epollHandler(int fd) {
+    pthread_once(&g_companionOnce, companionInit);
+    CompanionConn conn = {};
+    conn.fd = fd;
+    if (!parkCompanionConn(conn)) serveCompanionInline(&conn);
+}
+
+// One storm: all clients released together; returns per-client latency in ns
+std::vector<uint64_t> storm(void (*handler)(int), const RuntimeKey& key, int clients, long* failures) {
+    std::vector<uint64_t> latency(clients);
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    std::atomic<long> failed{0};
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < clients; i++) {
+        threads.emplace_back([&, i] {
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            uint64_t t0 = nowNs();
+            int fd = fakezygisk::connectCompanion(handler);
+            if (fd < 0 || !companionExchange(fd, key, true)) failed++;
+            latency[i] = nowNs() - t0;
+            if (fd >= 0) close(fd);
+        });
+    }
+    while (ready.load() < clients) std::this_thread::yield();
+    go.store(true, std::memory_order_release);
+    for (auto& t : threads) t.join();
+
+    *failures += failed.load();
+    return latency;
+}
+
+void run(const char* name, void (*handler)(int), const RuntimeKey& key, int clients, int rounds) {
+    std::vector<uint64_t> all;
+    long failures = 0;
+    double cpu0 = cpuSeconds();
+    for (int r = 0; r < rounds; r++) {
+        std::vector<uint64_t> l = storm(handler, key, clients, &failures);
+        all.insert(all.end(), l.begin(), l.end());
+    }
+    double cpu = cpuSeconds() - cpu0;
+
+    std::sort(all.begin(), all.end());
+    auto pct = [&](double p) { return all[std::min(all.size() - 1, (size_t)(p * all.size()))] / 1e3; };
+    printf("%-9s %7d %8.1f %8.1f %8.1f %9.1f %10.2f %6ld\n", name, clients, pct(0.50), pct(0.90), pct(0.99),
+           all.back() / 1e3, cpu * 1e6 / all.size(), failures);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 20;
+    std::vector<int> clientCounts;
+    for (int i = 2; i < argc; i++) clientCounts.push_back(atoi(argv[i]));
+    if (clientCounts.empty()) clientCounts = {32, 128, 256};
+
+    MockConfig cfg = parseConfig("enabled=1\nlat=10.7769\nlng=106.7009\nhidedev=1\n");
+    if (!writeConfigFileAtomic(CONFIG_BIN_PATH, cfg)) {
+        fprintf(stderr, "cannot write %s\n", CONFIG_BIN_PATH);
+        return 2;
+    }
+
+    // Seed the companion with this zygote's detection results
+    pthread_once(&g_companionOnce, companionInit);
+    RuntimeCache cache = {};
+    cache.key   = runtimeKey(fakejni::env());
+    cache.valid = 1;
+    storeRuntimeCache(cache);
+
+    printf("%d rounds per row, latency in us\n", rounds);
+    printf("%-9s %7s %8s %8s %8s %9s %10s %6s\n", "handler", "clients", "p50", "p90", "p99", "max",
+           "cpu/conn", "fail");
+    for (int clients : clientCounts) {
+        run("handler", companion_handler, cache.key, clients, rounds);
+        run("inline", inlineHandler, cache.key, clients, rounds);
+        run("epoll", epollHandler, cache.key, clients, rounds);
+    }
+    return 0;
+}
@@ -0,0 +1,165 @@
+// MockGPS host benchmark - config publication
+//
+// Compares the old layout (one std::atomic per field, seq_cst loads) with the
+// seqlock-protected ConfigSnapshot, loaded once per getter, and with the
+// ConfigPair the hooks answer lat and lng from. Each iteration models one
+// hook_getLatitude + hook_getLongitude pair: two separate reads, as an app makes
+// two calls, each checking enabled.
+//
+// The "_UnderWrite" variants run a writer thread that keeps publishing configs
+// where lng == -lat; the "torn" counter reports how many pairs mixed two configs.
+// A snapshot alone only keeps each call consistent: a publish between the two
+// calls still tears the pair. "expired" counts pairs whose calls were further apart
+// than ConfigPair::kHoldNs (the reader was descheduled); only those may tear.
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <thread>
+#include <time.h>
+
+#include "config.hpp"
+
+namespace {
+
+// Layout before the snapshot: eight independent atomics
+struct PerFieldConfig {
+    std::atomic<bool>   enabled{false};
+    std::atomic<double> lat{0.0};
+    std::atomic<double> lng{0.0};
+    std::atomic<float>  accuracy{5.0f};
+    std::atomic<double> altitude{0.0};
+    std::atomic<float>  speed{0.0f};
+    std::atomic<float>  bearing{0.0f};
+    std::atomic<bool>   hideDev{true};
+
+    void store(const MockConfig& cfg) {
+        enabled.store(cfg.enabled);
+        lat.store(cfg.lat);
+        lng.store(cfg.lng);
+        accuracy.store(cfg.accuracy);
+        altitude.store(cfg.altitude);
+        speed.store(cfg.speed);
+        bearing.store(cfg.bearing);
+        hideDev.store(cfg.hideDev);
+    }
+};
+
+MockConfig makeConfig(uint64_t i) {
+    MockConfig cfg;
+    cfg.enabled = true;
+    cfg.lat = (double)(i % 90);
+    cfg.lng = -cfg.lat;
+    return cfg;
+}
+
+uint64_t coarseNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// Publishes configs as fast as possible until destroyed
+template <class Store>
+class BackgroundWriter {
+public:
+    explicit BackgroundWriter(Store store)
+        : thread_([this, store] {
+              for (uint64_t i = 1; !stop_.load(std::memory_order_relaxed); i++) store(makeConfig(i));
+          }) {}
+    ~BackgroundWriter() {
+        stop_.store(true);
+        thread_.join();
+    }
+
+private:
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+};
+
+void BM_PerFieldAtomics(benchmark::State& state) {
+    static PerFieldConfig cfg;
+    cfg.store(makeConfig(1));
+    for (auto _ : state) {
+        if (cfg.enabled.load()) {
+            double lat = cfg.lat.load();
+            double lng = cfg.lng.load();
+            benchmark::DoNotOptimize(lat);
+            benchmark::DoNotOptimize(lng);
+        }
+    }
+}
+BENCHMARK(BM_PerFieldAtomics);
+
+void BM_Snapshot(benchmark::State& state) {
+    static ConfigSnapshot snap;
+    snap.store(makeConfig(1));
+    for (auto _ : state) {
+        MockConfig latCfg = snap.load();
+        if (latCfg.enabled) benchmark::DoNotOptimize(latCfg.lat);
+        MockConfig lngCfg = snap.load();
+        if (lngCfg.enabled) benchmark::DoNotOptimize(lngCfg.lng);
+    }
+}
+BENCHMARK(BM_Snapshot);
+
+void BM_SnapshotPair(benchmark::State& state) {
+    static ConfigSnapshot snap;
+    snap.store(makeConfig(1));
+    ConfigPair pair;
+    for (auto _ : state) {
+        const MockConfig& latCfg = pair.get(snap, kFieldLat, coarseNs());
+        if (latCfg.enabled) benchmark::DoNotOptimize(latCfg.lat);
+        const MockConfig& lngCfg = pair.get(snap, kFieldLng, coarseNs());
+        if (lngCfg.enabled) benchmark::DoNotOptimize(lngCfg.lng);
+    }
+}
+BENCHMARK(BM_SnapshotPair);
+
+void BM_PerFieldAtomics_UnderWrite(benchmark::State& state) {
+    static PerFieldConfig cfg;
+    BackgroundWriter writer([](const MockConfig& c) { cfg.store(c); });
+    uint64_t torn = 0;
+    for (auto _ : state) {
+        if (cfg.enabled.load()) {
+            double lat = cfg.lat.load();
+            double lng = cfg.lng.load();
+            torn += (lng != -lat);
+        }
+    }
+    state.counters["torn"] = benchmark::Counter((double)torn);
+}
+BENCHMARK(BM_PerFieldAtomics_UnderWrite)->UseRealTime();
+
+void BM_Snapshot_UnderWrite(benchmark::State& state) {
+    static ConfigSnapshot snap;
+    BackgroundWriter writer([](const MockConfig& c) { snap.store(c); });
+    uint64_t torn = 0;
+    for (auto _ : state) {
+        MockConfig latCfg = snap.load();
+        MockConfig lngCfg = snap.load();
+        if (latCfg.enabled && lngCfg.enabled) torn += (lngCfg.lng != -latCfg.lat);
+    }
+    state.counters["torn"] = benchmark::Counter((double)torn);
+}
+BENCHMARK(BM_Snapshot_UnderWrite)->UseRealTime();
+
+void BM_SnapshotPair_UnderWrite(benchmark::State& state) {
+    static ConfigSnapshot snap;
+    BackgroundWriter writer([](const MockConfig& c) { snap.store(c); });
+    ConfigPair pair;
+    uint64_t torn = 0, expired = 0;
+    for (auto _ : state) {
+        uint64_t t0 = coarseNs();
+        double lat = pair.get(snap, kFieldLat, t0).lat;
+        uint64_t t1 = coarseNs();
+        const MockConfig& lngCfg = pair.get(snap, kFieldLng, t1);
+        if (lngCfg.enabled) torn += (lngCfg.lng != -lat);
+        expired += t1 - t0 >= ConfigPair::kHoldNs;
+    }
+    state.counters["torn"] = benchmark::Counter((double)torn);
+    state.counters["expired"] = benchmark::Counter((double)expired);
+}
+BENCHMARK(BM_SnapshotPair_UnderWrite)->UseRealTime();
+
+} // namespace
@@ -0,0 +1,125 @@
+// MockGPS host benchmark - config text parsing throughput
+//
+// Compares the previous parser (each line copied into a 256-byte stack buffer, atof,
+// strcmp chain; longer lines silently dropped) with the in-place parser over a
+// string_view. Inputs:
+//   Small     the 8-key config the UIs write
+//   Large/N   N bytes of key=value lines: the 8 keys plus prefixed preset keys, as
+//             profile, preset or route data would add
+//   LongLine  the 8 keys, each value padded past the old 255-character limit
+//
+// The legacy parser needs a NUL-terminated buffer; the new one parses in place.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <string>
+
+#include "config_file.hpp"
+
+namespace {
+
+MockConfig legacyParseConfig(const char* data) {
+    MockConfig cfg;
+    const char* p = data;
+    while (p && *p) {
+        const char* nl = strchr(p, '\n');
+        int len = nl ? (int)(nl - p) : (int)strlen(p);
+        char line[256];
+        if (len < (int)sizeof(line)) {
+            memcpy(line, p, len);
+            line[len] = 0;
+            char* eq = strchr(line, '=');
+            if (eq) {
+                *eq = 0;
+                const char* key = line;
+                const char* val = eq + 1;
+                if (!strcmp(key, "enabled"))  cfg.enabled  = atoi(val) != 0;
+                else if (!strcmp(key, "lat"))      cfg.lat      = atof(val);
+                else if (!strcmp(key, "lng"))      cfg.lng      = atof(val);
+                else if (!strcmp(key, "accuracy")) cfg.accuracy = (float)atof(val);
+                else if (!strcmp(key, "altitude")) cfg.altitude = atof(val);
+                else if (!strcmp(key, "speed"))    cfg.speed    = (float)atof(val);
+                else if (!strcmp(key, "bearing"))  cfg.bearing  = (float)atof(val);
+                else if (!strcmp(key, "hidedev"))  cfg.hideDev  = atoi(val) != 0;
+            }
+        }
+        p = nl ? nl + 1 : nullptr;
+    }
+    return cfg;
+}
+
+const char* const kSmall =
+    "enabled=1\nlat=10.776900\nlng=106.700900\naccuracy=3.0\naltitude=10\nspeed=0\nbearing=0\nhidedev=1\n";
+
+std::string largeConfig(size_t bytes) {
+    std::string s = kSmall;
+    char line[96];
+    for (unsigned i = 0; s.size() < bytes; i++) {
+        double lat = -90 + (i * 7919 % 180000) / 1000.0;
+        double lng = -180 + (i * 104729 % 360000) / 1000.0;
+        snprintf(line, sizeof(line), "preset.%u.lat=%.8f\npreset.%u.lng=%.8f\nlat=%.8f\nlng=%.8f\n", i, lat, i, lng,
+                 lat, lng);
+        s += line;
+    }
+    return s;
+}
+
+std::string longLineConfig() {
+    std::string pad(300, '0');
+    return "enabled=1\nlat=10.7769" + pad + "\nlng=106.7009" + pad + "\naccuracy=3" + pad.substr(1) +
+           ".0\naltitude=10\nspeed=0\nbearing=0\nhidedev=1\n";
+}
+
+void run(benchmark::State& state, const std::string& text, bool legacy) {
+    for (auto _ : state) {
+        if (legacy) {
+            benchmark::DoNotOptimize(legacyParseConfig(text.c_str()));
+        } else {
+            ConfigErrors errors;
+            benchmark::DoNotOptimize(parseConfig(text, &errors));
+        }
+    }
+    state.SetBytesProcessed((int64_t)state.iterations() * (int64_t)text.size());
+}
+
+void BM_Parse_Small(benchmark::State& state, bool legacy) {
+    run(state, kSmall, legacy);
+}
+BENCHMARK_CAPTURE(BM_Parse_Small, Legacy, true);
+BENCHMARK_CAPTURE(BM_Parse_Small, InPlace, false);
+
+void BM_Parse_Large(benchmark::State& state, bool legacy) {
+    run(state, largeConfig((size_t)state.range(0)), legacy);
+}
+BENCHMARK_CAPTURE(BM_Parse_Large, Legacy, true)->RangeMultiplier(16)->Range(1 << 10, 1 << 24);
+BENCHMARK_CAPTURE(BM_Parse_Large, InPlace, false)->RangeMultiplier(16)->Range(1 << 10, 1 << 24);
+
+// Legacy drops the long lines (lat/lng/accuracy keep their defaults); the new parser
+// reads them
+void BM_Parse_LongLine(benchmark::State& state, bool legacy) {
+    run(state, longLineConfig(), legacy);
+}
+BENCHMARK_CAPTURE(BM_Parse_LongLine, Legacy, true);
+BENCHMARK_CAPTURE(BM_Parse_LongLine, InPlace, false);
+
+// Whole file from disk: mapped and parsed in place
+void BM_LoadConfigText(benchmark::State& state) {
+    std::string text = largeConfig((size_t)state.range(0));
+    char path[] = "/tmp/mockgps_parse_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0 || write(fd, text.data(), text.size()) != (ssize_t)text.size()) {
+        state.SkipWithError("cannot write scratch file");
+        return;
+    }
+    close(fd);
+    for (auto _ : state) {
+        ConfigSet set;
+        benchmark::DoNotOptimize(loadConfigText(path, &set));
+    }
+    unlink(path);
+    state.SetBytesProcessed((int64_t)state.iterations() * (int64_t)text.size());
+}
+BENCHMARK(BM_LoadConfigText)->RangeMultiplier(16)->Range(1 << 10, 1 << 24);
+
+} // namespace
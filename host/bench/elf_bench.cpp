@@ -0,0 +1,84 @@
+// MockGPS host benchmark - symbol resolution
+//
+// Old findJniTrampoline() strategy 2 (scan /proc/self/maps with fgets/strstr, then
+// dlopen(RTLD_NOLOAD) + dlsym) against elf::Image, on an exported libc symbol and
+// on a hidden symbol that only MiniDebugInfo carries (which dlsym cannot find).
+// Each iteration is a cold lookup: open, resolve, unmap.
+
+#include <benchmark/benchmark.h>
+
+#include <dlfcn.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include "elf_resolver.hpp"
+
+namespace {
+
+void* mapsScanDlsym(const char* lib, const char* sym) {
+    void* result = nullptr;
+    FILE* maps = fopen("/proc/self/maps", "r");
+    if (!maps) return nullptr;
+    char line[512];
+    char path[256] = {};
+    while (fgets(line, sizeof(line), maps)) {
+        if (strstr(line, lib) && strstr(line, "r-xp")) {
+            char* start = strchr(line, '/');
+            if (start) {
+                char* end = strchr(start, '\n');
+                if (end) *end = 0;
+                strncpy(path, start, sizeof(path) - 1);
+                break;
+            }
+        }
+    }
+    fclose(maps);
+    if (path[0]) {
+        void* handle = dlopen(path, RTLD_NOW | RTLD_NOLOAD);
+        if (handle) {
+            result = dlsym(handle, sym);
+            dlclose(handle);
+        }
+    }
+    return result;
+}
+
+void* loadFixture() {
+    static void* handle = dlopen(MOCKGPS_ELF_FIXTURE, RTLD_NOW);
+    return handle;
+}
+
+void BM_MapsScanDlsym_Exported(benchmark::State& state) {
+    for (auto _ : state) benchmark::DoNotOptimize(mapsScanDlsym("libc.so", "malloc"));
+}
+BENCHMARK(BM_MapsScanDlsym_Exported);
+
+void BM_ElfImage_Exported(benchmark::State& state) {
+    for (auto _ : state) {
+        elf::Image libc("libc.so.6");
+        benchmark::DoNotOptimize(libc.symbol("malloc"));
+    }
+}
+BENCHMARK(BM_ElfImage_Exported);
+
+void BM_MapsScanDlsym_Hidden(benchmark::State& state) {
+    if (!loadFixture()) return state.SkipWithError("fixture not loaded");
+    void* found = nullptr;
+    for (auto _ : state) benchmark::DoNotOptimize(found = mapsScanDlsym("libelf_fixture_mini.so", "mockgps_fixture_hidden"));
+    state.counters["found"] = found != nullptr;
+}
+BENCHMARK(BM_MapsScanDlsym_Hidden);
+
+void BM_ElfImage_HiddenMiniDebugInfo(benchmark::State& state) {
+    if (!loadFixture()) return state.SkipWithError("fixture not loaded");
+    void* found = nullptr;
+    for (auto _ : state) {
+        elf::Image fixture("libelf_fixture_mini.so");
+        benchmark::DoNotOptimize(found = fixture.symbol("mockgps_fixture_hidden"));
+    }
+    state.counters["found"] = found != nullptr;
+}
+BENCHMARK(BM_ElfImage_HiddenMiniDebugInfo);
+
+} // namespace
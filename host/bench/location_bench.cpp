@@ -0,0 +1,75 @@
+// MockGPS host benchmark - Location getter fallback path
+//
+// With spoofing disabled every hooked getter returns the real field value. Before,
+// that meant GetObjectClass + GetFieldID(name) on every call (plus a leaked local
+// reference); now the field IDs are resolved once at hook installation.
+//
+// Costs here come from host/fake_jni.cpp and understate ART, where each of the
+// removed calls also pays a thread-state transition.
+
+#include <benchmark/benchmark.h>
+
+#include "fake_jni.hpp"
+#include "module.cpp"
+
+namespace {
+
+// Fallback read as it was before field IDs were cached
+double legacyReadDoubleField(JNIEnv* env, jobject loc, const char* fieldName) {
+    jclass cls = env->GetObjectClass(loc);
+    jfieldID fid = env->GetFieldID(cls, fieldName, "D");
+    if (!fid) { env->ExceptionClear(); return 0.0; }
+    return env->GetDoubleField(loc, fid);
+}
+
+jobject makeLocation() {
+    auto* loc = fakejni::newObject(fakejni::locationClass());
+    fakejni::setField(loc, "mLatitudeDegrees", 10.7769);
+    fakejni::setField(loc, "mLongitudeDegrees", 106.7009);
+    return loc;
+}
+
+void setEnabled(bool enabled) {
+    MockConfig cfg;
+    cfg.enabled = enabled;
+    cfg.lat = 1.0;
+    applyConfig(cfg);
+}
+
+void BM_Disabled_LegacyFieldLookup(benchmark::State& state) {
+    JNIEnv* env = fakejni::env();
+    jobject loc = makeLocation();
+    long refs = fakejni::liveLocalRefs();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(legacyReadDoubleField(env, loc, "mLatitudeDegrees"));
+    }
+    state.counters["local_refs/call"] = benchmark::Counter(
+        (double)(fakejni::liveLocalRefs() - refs), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_Disabled_LegacyFieldLookup);
+
+void BM_Disabled_CachedFieldID(benchmark::State& state) {
+    JNIEnv* env = fakejni::env();
+    jobject loc = makeLocation();
+    resolveLocationFields(env, fakejni::locationClass());
+    setEnabled(false);
+    long refs = fakejni::liveLocalRefs();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(hook_getLatitude(env, loc));
+    }
+    state.counters["local_refs/call"] = benchmark::Counter(
+        (double)(fakejni::liveLocalRefs() - refs), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_Disabled_CachedFieldID);
+
+void BM_Enabled(benchmark::State& state) {
+    JNIEnv* env = fakejni::env();
+    jobject loc = makeLocation();
+    setEnabled(true);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(hook_getLatitude(env, loc));
+    }
+}
+BENCHMARK(BM_Enabled);
+
+} // namespace
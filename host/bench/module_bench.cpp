@@ -0,0 +1,405 @@
+// MockGPS host benchmark - module hot paths
+//
+// One simulated app process: the module is loaded through fakezygisk, specializes
+// against the in-process companion (config file in MOCKGPS_MODULE_DIR) and installs
+// its hooks into the fake ArtMethods. Benchmarks then cover
+//   - loading the config (the companion's cost per config change): location.bin by
+//     read() and by mmap, against the text file it replaced
+//   - every hook_* function, spoofing enabled and disabled; disabled means the
+//     fallback read (field ID or original method through its backup clone)
+//   - getLatitude while a hook call trace samples every call or one in 64, with
+//     the controller thread's drains folded in
+//   - getLatitude playing a 2-point and a 1M-point route, against the static point;
+//     and the route lookup alone at random times (binary search on every call)
+//   - a getter call through ART-style dispatch, hooked and unhooked
+//   - installing and removing the Location hook group (formerly convertToNative)
+//   - companion_handler, called directly and as a full connectCompanion round trip
+//   - preAppSpecialize for processes that unload: a regular app the config leaves
+//     off (companion round trip) against the classes unloaded without IPC
+//
+// Hook functions are called directly, so results exclude ART's JNI transition.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include <sys/stat.h>
+
+#include "fake_jni.hpp"
+#include "fake_zygisk.hpp"
+#include "module.cpp"
+
+#include "companion_client.hpp"
+
+namespace {
+
+const char* const kConfigText =
+    "enabled=1\n"
+    "lat=10.776900\n"
+    "lng=106.700900\n"
+    "accuracy=3.0\n"
+    "altitude=10\n"
+    "speed=0\n"
+    "bearing=0\n"
+    "hidedev=1\n";
+
+struct Process {
+    JNIEnv*  env;
+    jobject  location;
+    jclass   secure;
+    jclass   global;
+    jstring  hiddenKey;
+    jstring  otherKey;
+    RuntimeKey key;
+
+    Process() : env(fakejni::env()) {
+        writeConfigFileAtomic(CONFIG_BIN_PATH, parseConfig(kConfigText));
+
+        static fakezygisk::Loader loader(env);
+        fakezygisk::AppArgs args;
+        loader.specializeApp(args);
+        if (loader.dlclosed() || !resolved()) {
+            fprintf(stderr, "module did not activate; is %s writable?\n", CONFIG_DIR);
+            abort();
+        }
+
+        auto* loc = fakejni::newObject(fakejni::locationClass());
+        fakejni::setField(loc, "mLatitudeDegrees", 48.8584);
+        fakejni::setField(loc, "mLongitudeDegrees", 2.2945);
+        fakejni::setField(loc, "mHorizontalAccuracyMeters", 12.0f);
+        fakejni::setField(loc, "mTimeMs", (jlong)1700000000000);
+        location = loc;
+
+        secure    = fakejni::findClass("android/provider/Settings$Secure");
+        global    = fakejni::findClass("android/provider/Settings$Global");
+        hiddenKey = fakejni::newString("development_settings_enabled");
+        otherKey  = fakejni::newString("screen_off_timeout");
+        fakejni::putSetting("Secure", "development_settings_enabled", 1);
+        fakejni::putSetting("Global", "development_settings_enabled", 1);
+
+        // The companion stores our detection report after we hang up
+        key = runtimeKey(env);
+        while (!lookupRuntimeCache(key).valid) std::this_thread::yield();
+    }
+
+    static bool resolved() {
+        return g_hooks[kHookGetLatitude].artMethod && g_activeConfig != &g_config;
+    }
+
+    // Publish through the companion and wait for the hook controller to follow
+    void setConfig(bool enabled, bool hideDev) {
+        ConfigSet set;
+        set.defaults = parseConfig(kConfigText);
+        set.defaults.enabled = enabled;
+        set.defaults.hideDev = hideDev;
+        pthread_mutex_lock(&g_reloadLock);
+        publishConfig(set);
+        pthread_mutex_unlock(&g_reloadLock);
+        while (__atomic_load_n(&g_hooks[kHookGetLatitude].installed, __ATOMIC_ACQUIRE) != enabled ||
+               __atomic_load_n(&g_hooks[kHookSecureGetInt3].installed, __ATOMIC_ACQUIRE) != hideDev) {
+            std::this_thread::yield();
+        }
+    }
+
+    // Publish a route of `points` points `spacingMs` apart and play it from the defaults
+    void setRoute(uint32_t points, uint32_t spacingMs) {
+        setConfig(true, true);
+        std::vector<RoutePoint> route(points);
+        for (uint32_t i = 0; i < points; i++) {
+            route[i] = {i * spacingMs, (int32_t)(107769000 + i % 4096 * 20), (int32_t)(1067009000 + i / 4096 * 20)};
+        }
+        writeFileAtomic(ROUTE_PATH, encodeRoute(route));
+        ConfigSet set;
+        set.defaults = parseConfig(kConfigText);
+        set.defaults.route = true;
+        pthread_mutex_lock(&g_reloadLock);
+        loadRoute();
+        publishConfig(set);
+        pthread_mutex_unlock(&g_reloadLock);
+    }
+};
+
+Process& process() {
+    static Process p;
+    return p;
+}
+
+// ── Config ──────────────────────────────────────────────────────────
+
+void BM_ParseConfig(benchmark::State& state) {
+    for (auto _ : state) benchmark::DoNotOptimize(parseConfig(kConfigText));
+    state.SetBytesProcessed((int64_t)state.iterations() * (int64_t)strlen(kConfigText));
+}
+BENCHMARK(BM_ParseConfig);
+
+void BM_DecodeConfigFile(benchmark::State& state) {
+    ConfigSet set;
+    parseConfigSet(kConfigText, &set);
+    std::vector<uint8_t> rec = encodeConfigFile(set);
+    for (auto _ : state) benchmark::DoNotOptimize(decodeConfigFile(rec.data(), rec.size(), &set));
+}
+BENCHMARK(BM_DecodeConfigFile);
+
+// Scratch files next to the real config; the watcher ignores their names
+std::string scratchPath(const char* name) {
+    return std::string(CONFIG_DIR) + "/" + name;
+}
+
+// Previous loader: read up to 1 KiB of text and parse it
+void BM_LoadConfig_Text(benchmark::State& state) {
+    std::string path = scratchPath("bench.conf");
+    if (FILE* f = fopen(path.c_str(), "w")) {
+        fputs(kConfigText, f);
+        fclose(f);
+    }
+    for (auto _ : state) {
+        MockConfig cfg;
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        char buf[1024];
+        int n = read(fd, buf, sizeof(buf) - 1);
+        close(fd);
+        if (n > 0) {
+            buf[n] = 0;
+            cfg = parseConfig(buf);
+        }
+        benchmark::DoNotOptimize(cfg);
+    }
+}
+BENCHMARK(BM_LoadConfig_Text);
+
+void BM_LoadConfig_BinaryRead(benchmark::State& state) {
+    std::string path = scratchPath("bench.bin");
+    writeConfigFileAtomic(path.c_str(), parseConfig(kConfigText));
+    ConfigSet set;
+    for (auto _ : state) {
+        if (loadConfigFile(path.c_str(), &set) != ConfigLoad::kOk) state.SkipWithError("rejected");
+    }
+}
+BENCHMARK(BM_LoadConfig_BinaryRead);
+
+void BM_LoadConfig_BinaryMmap(benchmark::State& state) {
+    std::string path = scratchPath("bench.bin");
+    writeConfigFileAtomic(path.c_str(), parseConfig(kConfigText));
+    ConfigSet set;
+    for (auto _ : state) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        fstat(fd, &st);
+        void* mem = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (!decodeConfigFile(mem, st.st_size, &set)) state.SkipWithError("rejected");
+        munmap(mem, st.st_size);
+    }
+}
+BENCHMARK(BM_LoadConfig_BinaryMmap);
+
+// What the watcher runs per change: location.bin present
+void BM_ReadConfigFile(benchmark::State& state) {
+    process();
+    ConfigSet set;
+    for (auto _ : state) benchmark::DoNotOptimize(readConfigFile(&set));
+}
+BENCHMARK(BM_ReadConfigFile);
+
+// ── Hook functions ──────────────────────────────────────────────────
+
+template <class Hook>
+void BM_LocationHook(benchmark::State& state, Hook hook, bool enabled) {
+    Process& p = process();
+    p.setConfig(enabled, true);
+    for (auto _ : state) benchmark::DoNotOptimize(hook(p.env, p.location));
+}
+
+#define LOCATION_HOOK_BENCHMARK(fn)                          \
+    BENCHMARK_CAPTURE(BM_LocationHook, fn##_Enabled, fn, true); \
+    BENCHMARK_CAPTURE(BM_LocationHook, fn##_Disabled, fn, false)
+
+LOCATION_HOOK_BENCHMARK(hook_isFromMockProvider);
+LOCATION_HOOK_BENCHMARK(hook_isMock);
+LOCATION_HOOK_BENCHMARK(hook_getLatitude);
+LOCATION_HOOK_BENCHMARK(hook_getLongitude);
+LOCATION_HOOK_BENCHMARK(hook_getAccuracy);
+LOCATION_HOOK_BENCHMARK(hook_getAltitude);
+LOCATION_HOOK_BENCHMARK(hook_getSpeed);
+LOCATION_HOOK_BENCHMARK(hook_getBearing);
+LOCATION_HOOK_BENCHMARK(hook_getTime);
+LOCATION_HOOK_BENCHMARK(hook_getElapsedRealtimeNanos);
+
+#if MOCKGPS_TELEMETRY
+// Drains every half ring, as the controller thread would need to keep up
+void BM_LocationHook_Traced(benchmark::State& state) {
+    Process& p = process();
+    p.setConfig(true, true);
+    static TraceBuffer buf;
+    uint32_t n = 0;
+    g_traceSampleEvery.store((uint32_t)state.range(0), std::memory_order_relaxed);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(hook_getLatitude(p.env, p.location));
+        if (++n % (kTraceRingEvents / 2) == 0) {
+            drainTraceRings(&buf, 1);
+            if (buf.head.load(std::memory_order_relaxed) >= kTraceBufferEvents) clearTraceBuffer(&buf);
+        }
+    }
+    g_traceSampleEvery.store(0, std::memory_order_relaxed);
+}
+BENCHMARK(BM_LocationHook_Traced)->Arg(1)->Arg(64);
+#endif
+
+// Arguments: route points, ms between them. Real tracks have a point every second
+// or so; 1 ms makes every fix refresh land several segments on, in a binary search.
+// An iteration is a getLatitude + getLongitude pair, which computes one fix.
+void BM_LocationHook_Route(benchmark::State& state) {
+    Process& p = process();
+    p.setRoute((uint32_t)state.range(0), (uint32_t)state.range(1));
+    RouteFix fix;
+    if (!routeFix(g_activeConfig->load(), 0, &fix)) state.SkipWithError("route not playing");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(hook_getLatitude(p.env, p.location));
+        benchmark::DoNotOptimize(hook_getLongitude(p.env, p.location));
+    }
+    p.setConfig(true, true);
+}
+BENCHMARK(BM_LocationHook_Route)->Args({2, 1000})->Args({1 << 20, 1000})->Args({1 << 20, 1});
+
+void BM_LocateOnRoute_Random(benchmark::State& state) {
+    Process& p = process();
+    p.setRoute(1 << 20, 1000);
+    MockConfig cfg = g_activeConfig->load();
+    const RouteSlot& slot = g_routes->slots[cfg.routeGen & 1];
+    uint64_t startNs = slot.startNs.load(std::memory_order_relaxed);
+    uint64_t spanNs = (uint64_t)(1 << 20) * 1000000000ull;
+    uint64_t x = 88172645463325252ull;
+    RouteCursor cursor;
+    RouteFix fix;
+    for (auto _ : state) {
+        x ^= x << 13, x ^= x >> 7, x ^= x << 17;
+        benchmark::DoNotOptimize(locateOnRoute(g_routes, cfg.routeGen, startNs + x % spanNs, &cursor, &fix));
+    }
+    p.setConfig(true, true);
+}
+BENCHMARK(BM_LocateOnRoute_Random);
+
+// Enabled: hidden key answered locally, other keys forwarded to the original.
+// Disabled: every key forwarded.
+enum SettingsCase { kHiddenKey, kOtherKey, kDevHideOff };
+
+void BM_SettingsHook(benchmark::State& state, jint (*hook)(JNIEnv*, jclass, jobject, jstring),
+                     bool global, SettingsCase c) {
+    Process& p = process();
+    p.setConfig(true, c != kDevHideOff);
+    jclass clazz = global ? p.global : p.secure;
+    jstring name = c == kHiddenKey ? p.hiddenKey : p.otherKey;
+    for (auto _ : state) benchmark::DoNotOptimize(hook(p.env, clazz, nullptr, name));
+}
+
+jint secureGetInt3(JNIEnv* env, jclass clazz, jobject resolver, jstring name) {
+    return hook_secureGetInt3(env, clazz, resolver, name, -1);
+}
+
+jint globalGetInt3(JNIEnv* env, jclass clazz, jobject resolver, jstring name) {
+    return hook_globalGetInt3(env, clazz, resolver, name, -1);
+}
+
+#define SETTINGS_HOOK_BENCHMARK(fn, call, global)                                  \
+    BENCHMARK_CAPTURE(BM_SettingsHook, fn##_HiddenKey, call, global, kHiddenKey);  \
+    BENCHMARK_CAPTURE(BM_SettingsHook, fn##_OtherKey, call, global, kOtherKey);    \
+    BENCHMARK_CAPTURE(BM_SettingsHook, fn##_Disabled, call, global, kDevHideOff)
+
+SETTINGS_HOOK_BENCHMARK(hook_secureGetInt3, secureGetInt3, false);
+SETTINGS_HOOK_BENCHMARK(hook_secureGetInt2, hook_secureGetInt2, false);
+SETTINGS_HOOK_BENCHMARK(hook_globalGetInt3, globalGetInt3, true);
+
+// App code calling getLatitude(): through the trampoline into the hook, or straight
+// into the original body once the hook has been removed
+void BM_Dispatch_GetLatitude(benchmark::State& state, bool enabled) {
+    Process& p = process();
+    p.setConfig(enabled, true);
+    jmethodID mid = p.env->GetMethodID(fakejni::locationClass(), "getLatitude", "()D");
+    for (auto _ : state) benchmark::DoNotOptimize(fakejni::invoke(mid, p.location, nullptr).d);
+}
+BENCHMARK_CAPTURE(BM_Dispatch_GetLatitude, Hooked, true);
+BENCHMARK_CAPTURE(BM_Dispatch_GetLatitude, Unhooked, false);
+
+// ── Hook installation ───────────────────────────────────────────────
+
+// One install + remove of the Location group, without the live grace period (as in
+// postAppSpecialize). The controller thread is idle: nothing is published meanwhile.
+void BM_ConvertToNative(benchmark::State& state) {
+    Process& p = process();
+    p.setConfig(false, true);
+    int changed = 0;
+    for (auto _ : state) {
+        changed += setHooksInstalled(hookRange(kLocationHooksBegin, kLocationHooksEnd), ~0u, false);
+        changed += setHooksInstalled(hookRange(kLocationHooksBegin, kLocationHooksEnd), 0, false);
+    }
+    state.counters["methods/iter"] = benchmark::Counter((double)changed, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_ConvertToNative);
+
+// ── Companion ───────────────────────────────────────────────────────
+
+void parkedHandler(int fd) {
+    CompanionConn conn = {};
+    conn.fd = fd;
+    if (!parkCompanionConn(conn)) serveCompanionInline(&conn);
+}
+
+// Handler without Zygisk's thread spawn: called on this thread with the request
+// already queued; timing ends once the full reply has arrived. Parked hands every
+// connection to the epoll thread, for comparison.
+void BM_CompanionHandler(benchmark::State& state, void (*handler)(int), bool hooking) {
+    Process& p = process();
+    p.setConfig(hooking, hooking);
+    for (auto _ : state) {
+        int sv[2];
+        socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv);
+        companionRequest(sv[0], p.key);
+        handler(sv[1]);
+        close(sv[1]);
+        if (!companionReceive(sv[0], hooking)) state.SkipWithError("short companion reply");
+        close(sv[0]);
+    }
+}
+BENCHMARK_CAPTURE(BM_CompanionHandler, Unload, companion_handler, false)->UseRealTime();
+BENCHMARK_CAPTURE(BM_CompanionHandler, CacheHit, companion_handler, true)->UseRealTime();
+BENCHMARK_CAPTURE(BM_CompanionHandler, Parked_Unload, parkedHandler, false)->UseRealTime();
+BENCHMARK_CAPTURE(BM_CompanionHandler, Parked_CacheHit, parkedHandler, true)->UseRealTime();
+
+// What preAppSpecialize waits for: connectCompanion, handler thread, full reply
+void BM_CompanionRoundTrip(benchmark::State& state, bool hooking) {
+    Process& p = process();
+    p.setConfig(hooking, hooking);
+    for (auto _ : state) {
+        int fd = fakezygisk::connectCompanion();
+        if (!companionExchange(fd, p.key, hooking)) state.SkipWithError("short companion reply");
+        close(fd);
+    }
+}
+BENCHMARK_CAPTURE(BM_CompanionRoundTrip, Unload, false)->UseRealTime();
+BENCHMARK_CAPTURE(BM_CompanionRoundTrip, CacheHit, true)->UseRealTime();
+
+// ── Process classes ─────────────────────────────────────────────────
+
+void BM_PreAppSpecialize_Unload(benchmark::State& state, jint uid, bool childZygote) {
+    Process& p = process();
+    p.setConfig(false, false);
+    static fakezygisk::Loader loader(p.env);
+    fakezygisk::AppArgs args;
+    args.uid = uid;
+    args.isChildZygote = childZygote ? JNI_TRUE : JNI_FALSE;
+    long connections = loader.companionConnections();
+    for (auto _ : state) {
+        loader.preAppSpecialize(args);
+        if (!loader.dlclosed()) state.SkipWithError("module stayed loaded");
+    }
+    state.counters["companion/iter"] = benchmark::Counter(
+        (double)(loader.companionConnections() - connections), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK_CAPTURE(BM_PreAppSpecialize_Unload, App, 10123, false)->UseRealTime();
+BENCHMARK_CAPTURE(BM_PreAppSpecialize_Unload, Isolated, 99012, false)->UseRealTime();
+BENCHMARK_CAPTURE(BM_PreAppSpecialize_Unload, AppZygote, 10123, true)->UseRealTime();
+BENCHMARK_CAPTURE(BM_PreAppSpecialize_Unload, System, 1001, false)->UseRealTime();
+
+} // namespace
@@ -0,0 +1,92 @@
+// MockGPS host benchmark - profile lookup
+//
+// What the companion does per app launch: up to four key lookups (process name,
+// package, uid, app id), usually all misses. Compares the perfect-hash ProfileTable
+// with a linear scan of the profile list and std::unordered_map, for N profiles of
+// realistic package names. Build measures the rebuild the watcher runs per change.
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "profile_table.hpp"
+
+namespace {
+
+std::vector<std::string> profileKeys(size_t n) {
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < n; i++) {
+        keys.push_back(i % 4 == 3 ? "uid:" + std::to_string(10000 + i)
+                                  : "com.example.vendor" + std::to_string(i % 7) + ".app" + std::to_string(i));
+    }
+    return keys;
+}
+
+// Half hits, half misses, as the four-step lookup sees them
+std::vector<std::string> queries(const std::vector<std::string>& keys) {
+    std::vector<std::string> q;
+    for (size_t i = 0; i < 64; i++) {
+        q.push_back(i % 2 ? keys[(i * 7) % keys.size()] : "com.other.app" + std::to_string(i));
+    }
+    return q;
+}
+
+void BM_Lookup_Linear(benchmark::State& state) {
+    auto keys = profileKeys((size_t)state.range(0));
+    auto q = queries(keys);
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::string& k = q[i++ & 63];
+        int found = -1;
+        for (size_t j = 0; j < keys.size(); j++) {
+            if (keys[j] == k) {
+                found = (int)j;
+                break;
+            }
+        }
+        benchmark::DoNotOptimize(found);
+    }
+}
+BENCHMARK(BM_Lookup_Linear)->Arg(8)->Arg(64)->Arg(255);
+
+void BM_Lookup_UnorderedMap(benchmark::State& state) {
+    auto keys = profileKeys((size_t)state.range(0));
+    auto q = queries(keys);
+    std::unordered_map<std::string, int> map;
+    for (size_t j = 0; j < keys.size(); j++) map.emplace(keys[j], (int)j);
+    size_t i = 0;
+    for (auto _ : state) {
+        auto it = map.find(q[i++ & 63]);
+        benchmark::DoNotOptimize(it == map.end() ? -1 : it->second);
+    }
+}
+BENCHMARK(BM_Lookup_UnorderedMap)->Arg(8)->Arg(64)->Arg(255);
+
+void BM_Lookup_PerfectHash(benchmark::State& state) {
+    auto keys = profileKeys((size_t)state.range(0));
+    auto q = queries(keys);
+    std::vector<uint16_t> values;
+    for (size_t j = 0; j < keys.size(); j++) values.push_back((uint16_t)j);
+    ProfileTable table;
+    if (!table.build(keys, values)) {
+        state.SkipWithError("build failed");
+        return;
+    }
+    size_t i = 0;
+    for (auto _ : state) benchmark::DoNotOptimize(table.find(q[i++ & 63]));
+}
+BENCHMARK(BM_Lookup_PerfectHash)->Arg(8)->Arg(64)->Arg(255);
+
+void BM_Build_PerfectHash(benchmark::State& state) {
+    auto keys = profileKeys((size_t)state.range(0));
+    std::vector<uint16_t> values(keys.size());
+    ProfileTable table;
+    for (auto _ : state) {
+        if (!table.build(keys, values)) state.SkipWithError("build failed");
+    }
+}
+BENCHMARK(BM_Build_PerfectHash)->Arg(8)->Arg(64)->Arg(255);
+
+} // namespace
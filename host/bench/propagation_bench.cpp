@@ -0,0 +1,216 @@
+// MockGPS host benchmark - config propagation, from the write to the hooked getter
+//
+// Specializes one app through the stub loader against the in-process companion, then
+// forks N "app processes" from it. Like apps forked from zygote, each keeps the
+// companion's shared config page mapped and spins calling the hooked getLatitude()
+// through the fake ART dispatch, yielding between calls so that on a box with few
+// cores the spinners do not starve the companion. Each update writes a new lat through one transport
+// and times it from the start of the write (the tap) to the moment every process's
+// getter returns the new value. Transports compared:
+//   inotify  location.bin replaced atomically; the companion's watcher publishes it
+//   reload   what mockgpsctl does in-process: lock, replace, then ask the companion
+//            over its control socket to publish, and wait for its reply
+//   ctl      a `mockgpsctl set lat=...` process per update (su would add its own spawn)
+// cpu/upd is the CPU time per update of this process (writer and companion) plus the
+// spawned tool's. The spinning processes are left out: they burn a core by design.
+//
+//   propagation_bench [updates=200] [processes...]     (default processes: 1 4 8)
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <spawn.h>
+#include <vector>
+
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "fake_jni.hpp"
+#include "fake_zygisk.hpp"
+#include "module.cpp"
+
+#include "companion_client.hpp"
+
+extern char** environ;
+
+namespace {
+
+constexpr uint64_t kUpdateTimeoutNs = 2000000000ull;
+constexpr int      kPauseUs         = 1000;   // between updates, so each starts idle
+
+uint64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+double cpuSeconds(const struct rusage& ru) {
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+double cpuSeconds() {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return cpuSeconds(ru);
+}
+
+// Exact in a double and in %.17g text, so the getter's value compares equal
+double latFor(int update) { return 10.0 + (update + 1) / 1024.0; }
+
+enum class Transport { kInotify, kReload, kCtl };
+
+// Apply lat through `how`; false if the write failed. Adds a spawned tool's CPU time.
+bool writeLat(Transport how, double lat, double* childCpu) {
+    MockConfig cfg = parseConfig("enabled=1\nlng=106.7009\nhidedev=1\n");
+    cfg.lat = lat;
+    switch (how) {
+    case Transport::kInotify:
+        return writeConfigFileAtomic(CONFIG_BIN_PATH, cfg);
+    case Transport::kReload: {
+        int lock = lockConfigFile(CONFIG_BIN_PATH);
+        bool ok = writeConfigFileAtomic(CONFIG_BIN_PATH, cfg);
+        if (lock >= 0) close(lock);
+        uint32_t woken;
+        return ok && requestReload(&woken);
+    }
+    case Transport::kCtl: {
+        char arg[64];
+        snprintf(arg, sizeof(arg), "lat=%.17g", lat);
+        char* argv[] = {(char*)MOCKGPS_CTL_PATH, (char*)"set", arg, nullptr};
+        pid_t pid;
+        if (posix_spawn(&pid, MOCKGPS_CTL_PATH, nullptr, nullptr, argv, environ) != 0) return false;
+        int status;
+        struct rusage ru;
+        if (wait4(pid, &status, 0, &ru) != pid) return false;
+        *childCpu += cpuSeconds(ru);
+        return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    }
+    return false;
+}
+
+// Shared with the forked processes; followed by when each saw each update,
+// [update * processes + process]
+struct alignas(64) Board {
+    std::atomic<bool> stop;
+};
+
+std::atomic<uint64_t>* seenNs(Board* board) { return (std::atomic<uint64_t>*)(board + 1); }
+
+void spin(fakejni::Object* loc, Board* board, int process, int processes, int updates) {
+    for (int u = 0; u < updates; u++) {
+        double want = latFor(u);
+        while (fakejni::callVirtual(loc, "getLatitude", "()D").d != want) {
+            if (board->stop.load(std::memory_order_relaxed)) _exit(0);
+            sched_yield();   // leave the companion a core when processes outnumber them
+        }
+        seenNs(board)[u * processes + process].store(nowNs(), std::memory_order_release);
+    }
+    _exit(0);
+}
+
+void run(const char* name, Transport how, fakejni::Object* loc, int processes, int updates) {
+    // Back to a value no update uses, seen here before anyone forks
+    double childCpu = 0;
+    writeLat(Transport::kReload, 1.0, &childCpu);
+    uint64_t settle = nowNs();
+    while (fakejni::callVirtual(loc, "getLatitude", "()D").d != 1.0 && nowNs() - settle < kUpdateTimeoutNs) {}
+
+    size_t size = sizeof(Board) + sizeof(std::atomic<uint64_t>) * updates * processes;
+    auto* board = (Board*)mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (board == MAP_FAILED) {
+        perror("mmap");
+        return;
+    }
+    std::vector<pid_t> pids;
+    for (int p = 0; p < processes; p++) {
+        pid_t pid = fork();
+        if (pid == 0) spin(loc, board, p, processes, updates);
+        if (pid > 0) pids.push_back(pid);
+    }
+
+    std::vector<uint64_t> latency;
+    long failed = 0;
+    childCpu = 0;
+    double cpu0 = cpuSeconds();
+    for (int u = 0; u < updates && !failed; u++) {
+        usleep(kPauseUs);
+        uint64_t t0 = nowNs();
+        if (!writeLat(how, latFor(u), &childCpu)) failed++;
+        for (int p = 0; p < (int)pids.size() && !failed; p++) {
+            auto& seen = seenNs(board)[u * processes + p];
+            uint64_t t;
+            while (!(t = seen.load(std::memory_order_acquire))) {
+                if (nowNs() - t0 > kUpdateTimeoutNs) {
+                    failed++;
+                    break;
+                }
+                sched_yield();
+            }
+            if (t) latency.push_back(t - t0);
+        }
+    }
+    double cpu = cpuSeconds() - cpu0 + childCpu;
+
+    board->stop.store(true, std::memory_order_relaxed);
+    for (pid_t pid : pids) waitpid(pid, nullptr, 0);
+    munmap(board, size);
+
+    if (latency.empty()) {
+        printf("%-8s %9d %9s %9s %9s %10s %6ld\n", name, processes, "-", "-", "-", "-", failed);
+        return;
+    }
+    std::sort(latency.begin(), latency.end());
+    auto pct = [&](double p) { return latency[std::min(latency.size() - 1, (size_t)(p * latency.size()))] / 1e3; };
+    printf("%-8s %9d %9.1f %9.1f %9.1f %10.1f %6ld\n", name, processes, pct(0.50), pct(0.99),
+           latency.back() / 1e3, cpu * 1e6 / (latency.size() / processes), failed);
+}
+
+// A positive decimal count, or 0 for anything else
+int parseCount(const char* s) {
+    char* end;
+    long n = strtol(s, &end, 10);
+    return end != s && !*end && n > 0 && n <= 1000000 ? (int)n : 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int updates = argc > 1 ? parseCount(argv[1]) : 200;
+    std::vector<int> processCounts;
+    for (int i = 2; i < argc && updates; i++) {
+        processCounts.push_back(parseCount(argv[i]));
+        if (!processCounts.back()) updates = 0;
+    }
+    if (!updates) {
+        fprintf(stderr, "usage: %s [updates=200] [processes...]     (default processes: 1 4 8)\n", argv[0]);
+        return 2;
+    }
+    if (processCounts.empty()) processCounts = {1, 4, 8};
+
+    MockConfig cfg = parseConfig("enabled=1\nlat=1.0\nlng=106.7009\nhidedev=1\n");
+    if (!writeConfigFileAtomic(CONFIG_BIN_PATH, cfg)) {
+        fprintf(stderr, "cannot write %s\n", CONFIG_BIN_PATH);
+        return 2;
+    }
+
+    auto* loc = fakejni::newObject(fakejni::locationClass());
+    fakezygisk::Loader loader(fakejni::env());
+    fakezygisk::AppArgs args;
+    loader.specializeApp(args);
+    if (fakejni::callVirtual(loc, "getLatitude", "()D").d != 1.0) {
+        fprintf(stderr, "getLatitude() not spoofed after specialize\n");
+        return 2;
+    }
+
+    printf("%d updates per row, latency in us from the write to every process's getter\n", updates);
+    printf("%-8s %9s %9s %9s %9s %10s %6s\n", "write", "processes", "p50", "p99", "max", "cpu/upd", "fail");
+    for (int processes : processCounts) {
+        run("inotify", Transport::kInotify, loc, processes, updates);
+        run("reload", Transport::kReload, loc, processes, updates);
+        run("ctl", Transport::kCtl, loc, processes, updates);
+    }
+    return 0;
+}
@@ -0,0 +1,170 @@
+// MockGPS host benchmark - route compiler throughput on 100 MB tracks
+//
+// Generates one ~100 MB file per input format, a 1 Hz walk that meanders for days,
+// laid out as exporters write them:
+//   Gpx      <trkpt> with <ele> and <time>, indented
+//   Kml      one <gx:Track> of <when> and <gx:coord> lines
+//   GeoJson  a pretty-printed LineString Feature with properties.coordTimes
+// and feeds it to the streaming reader in 1 MiB chunks, as route_compile does.
+//   Parse    the reader alone
+//   Compile  reader, buildRoute() and encodeRoute(): everything but the file I/O
+// bytes_per_second is input throughput; ratio is input bytes per route.bin byte.
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <string>
+
+#include "route_import.hpp"
+
+namespace {
+
+constexpr size_t kInputBytes = 100u << 20;
+constexpr size_t kChunk      = 1u << 20;
+
+enum Format { kGpx, kKml, kGeoJson };
+
+struct Walk {
+    double lat = 10.7769, lng = 106.7009, ele = 12.0, heading = 0.6;
+    uint64_t rng = 88172645463325252ull;
+    int64_t  t = 1714550400;   // 2024-05-01T08:00:00Z
+
+    void step() {
+        rng ^= rng << 13, rng ^= rng >> 7, rng ^= rng << 17;
+        heading += ((int)(rng % 2001) - 1000) * 1e-4;
+        lat += std::cos(heading) * 1.4 / 111195.0;
+        lng += std::sin(heading) * 1.4 / (111195.0 * std::cos(lat * M_PI / 180));
+        ele += ((int)(rng >> 20 & 63) - 32) * 0.01;
+        t++;
+    }
+
+    void time(char* buf, size_t n) const {
+        time_t s = (time_t)t;
+        struct tm tm;
+        gmtime_r(&s, &tm);
+        strftime(buf, n, "%Y-%m-%dT%H:%M:%SZ", &tm);
+    }
+};
+
+std::string generate(Format format) {
+    std::string out;
+    out.reserve(kInputBytes + 4096);
+    Walk w;
+    char line[256], when[32];
+    switch (format) {
+    case kGpx:
+        out += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+               "<gpx version=\"1.1\" creator=\"route_compile_bench\" xmlns=\"http://www.topografix.com/GPX/1/1\">\n"
+               "  <trk>\n    <name>walk</name>\n    <trkseg>\n";
+        while (out.size() < kInputBytes) {
+            w.time(when, sizeof(when));
+            snprintf(line, sizeof(line),
+                     "      <trkpt lat=\"%.7f\" lon=\"%.7f\">\n        <ele>%.1f</ele>\n"
+                     "        <time>%s</time>\n      </trkpt>\n", w.lat, w.lng, w.ele, when);
+            out += line;
+            w.step();
+        }
+        out += "    </trkseg>\n  </trk>\n</gpx>\n";
+        break;
+    case kKml:
+        out += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+               "<kml xmlns=\"http://www.opengis.net/kml/2.2\" xmlns:gx=\"http://www.google.com/kml/ext/2.2\">\n"
+               "<Document><Placemark><name>walk</name>\n<gx:Track>\n";
+        // gx:Track lists every <when>, then every <gx:coord>
+        {
+            std::string coords;
+            while (out.size() + coords.size() < kInputBytes) {
+                w.time(when, sizeof(when));
+                snprintf(line, sizeof(line), "<when>%s</when>\n", when);
+                out += line;
+                snprintf(line, sizeof(line), "<gx:coord>%.7f %.7f %.1f</gx:coord>\n", w.lng, w.lat, w.ele);
+                coords += line;
+                w.step();
+            }
+            out += coords;
+        }
+        out += "</gx:Track>\n</Placemark></Document></kml>\n";
+        break;
+    case kGeoJson: {
+        std::string times;
+        out += "{\n  \"type\": \"FeatureCollection\",\n  \"features\": [\n    {\n      \"type\": \"Feature\",\n"
+               "      \"geometry\": {\n        \"type\": \"LineString\",\n        \"coordinates\": [\n";
+        bool first = true;
+        while (out.size() + times.size() < kInputBytes) {
+            w.time(when, sizeof(when));
+            snprintf(line, sizeof(line), "%s          [\n            %.7f,\n            %.7f,\n            %.1f\n          ]",
+                     first ? "" : ",\n", w.lng, w.lat, w.ele);
+            out += line;
+            snprintf(line, sizeof(line), "%s          \"%s\"", first ? "" : ",\n", when);
+            times += line;
+            first = false;
+            w.step();
+        }
+        out += "\n        ]\n      },\n      \"properties\": {\n        \"name\": \"walk\",\n"
+               "        \"coordTimes\": [\n";
+        out += times;
+        out += "\n        ]\n      }\n    }\n  ]\n}\n";
+        break;
+    }
+    }
+    return out;
+}
+
+const std::string& input(Format format) {
+    static std::string inputs[3];
+    if (inputs[format].empty()) inputs[format] = generate(format);
+    return inputs[format];
+}
+
+std::unique_ptr<TrackReader> readerFor(Format format) {
+    switch (format) {
+    case kGpx:     return std::make_unique<GpxReader>();
+    case kKml:     return std::make_unique<KmlReader>();
+    case kGeoJson: return std::make_unique<GeoJsonReader>();
+    }
+    return nullptr;
+}
+
+void BM_RouteCompile(benchmark::State& state, Format format, bool compile) {
+    const std::string& text = input(format);
+    size_t points = 0, image = 0;
+    for (auto _ : state) {
+        std::unique_ptr<TrackReader> reader = readerFor(format);
+        for (size_t at = 0; at < text.size(); at += kChunk) {
+            reader->feed(text.data() + at, std::min(kChunk, text.size() - at));
+        }
+        if (!reader->finish()) {
+            state.SkipWithError(reader->error.c_str());
+            return;
+        }
+        points = reader->track.points.size();
+        if (!compile) continue;
+        std::vector<RoutePoint> route;
+        size_t dropped;
+        std::string err;
+        if (!buildRoute(reader->track, 0, &route, &dropped, &err)) {
+            state.SkipWithError(err.c_str());
+            return;
+        }
+        image = encodeRoute(route).size();
+        if (!image) {
+            state.SkipWithError("route does not fit route.bin");
+            return;
+        }
+    }
+    state.SetBytesProcessed((int64_t)state.iterations() * (int64_t)text.size());
+    state.counters["points"] = (double)points;
+    if (image) state.counters["ratio"] = (double)text.size() / image;
+}
+
+BENCHMARK_CAPTURE(BM_RouteCompile, Parse/Gpx, kGpx, false)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_RouteCompile, Parse/Kml, kKml, false)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_RouteCompile, Parse/GeoJson, kGeoJson, false)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_RouteCompile, Compile/Gpx, kGpx, true)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_RouteCompile, Compile/Kml, kKml, true)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_RouteCompile, Compile/GeoJson, kGeoJson, true)->Unit(benchmark::kMillisecond);
+
+} // namespace
@@ -0,0 +1,42 @@
+// MockGPS host harness - client half of the companion protocol
+//
+// The exchange preAppSpecialize makes, for benchmarks and load generators that drive
+// the companion without specializing. Include after module.cpp.
+
+#pragma once
+
+// `niceName`/`uid` pick the profile, as AppSpecializeArgs do
+inline bool companionRequest(int fd, const RuntimeKey& key, const char* niceName = "", int32_t uid = 10123) {
+    CompanionRequest req = {};
+    req.key = key;
+    req.uid = uid;
+    strncpy(req.niceName, niceName, sizeof(req.niceName) - 1);
+    return send(fd, &req, sizeof(req), MSG_NOSIGNAL) == (ssize_t)sizeof(req);
+}
+
+// Read the whole reply; false if it was short. With `hooking` the route grant and
+// the runtime cache follow the config packet (a miss fails here: there is no report
+// to send back).
+inline bool companionReceive(int fd, bool hooking) {
+    ConfigPacket pkt;
+    int pageFd = -1;
+    bool ok = recvWithFd(fd, &pkt, sizeof(pkt), &pageFd);
+    if (pageFd >= 0) close(pageFd);
+    if (ok && hooking) {
+        RouteGrant grant;
+        int routeFd = -1;
+        ok = recvWithFd(fd, &grant, sizeof(grant), &routeFd);
+        if (routeFd >= 0) close(routeFd);
+    }
+    if (ok && hooking) {
+        RuntimeCache cache;
+        int statsFd = -1;
+        ok = recvWithFd(fd, &cache, sizeof(cache), &statsFd) && cache.valid;
+        if (statsFd >= 0) close(statsFd);
+    }
+    return ok;
+}
+
+inline bool companionExchange(int fd, const RuntimeKey& key, bool hooking) {
+    return companionRequest(fd, key) && companionReceive(fd, hooking);
+}
@@ -0,0 +1,558 @@
+// MockGPS host harness - fake JVM implementation
+
+#include "fake_jni.hpp"
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include <android/trace.h>
+#include <sys/system_properties.h>
+
+// Stand-ins for the libart entry points a method can have. They only need distinct
+// addresses inside a loaded image (the module checks them with dladdr).
+extern "C" __attribute__((visibility("default"), noinline)) void art_quick_generic_jni_trampoline() {
+    abort();
+}
+
+extern "C" __attribute__((visibility("default"), noinline)) void art_quick_to_interpreter_bridge() {
+    abort();
+}
+
+namespace fakejni {
+
+namespace {
+
+constexpr uint32_t kAccPublic = 0x0001;
+constexpr uint32_t kAccStatic = 0x0008;
+constexpr uint32_t kAccNative = 0x0100;
+
+std::map<std::string, std::unique_ptr<Class>>& classes() {
+    static std::map<std::string, std::unique_ptr<Class>> table;
+    return table;
+}
+
+// Index is the class id stored in declaring_class_; 0 is never used
+std::vector<Class*>& classesById() {
+    static std::vector<Class*> table(1, nullptr);
+    return table;
+}
+
+std::map<std::string, int>& settings() {
+    static std::map<std::string, int> table;
+    return table;
+}
+
+long g_localRefs = 0;
+
+size_t sigSize(const std::string& sig) {
+    switch (sig[0]) {
+        case 'J': case 'D': return 8;
+        case 'I': case 'F': return 4;
+        case 'S': case 'C': return 2;
+        case 'Z': case 'B': return 1;
+        default:            return sizeof(void*);
+    }
+}
+
+char returnType(const std::string& sig) {
+    return sig[sig.find(')') + 1];
+}
+
+// ── Method bodies ───────────────────────────────────────────────────
+
+jvalue getterBody(const Method& m, JNIEnv*, jobject self, const jvalue*) {
+    jvalue r = {};
+    const uint8_t* data = static_cast<Object*>(self)->data + m.fieldOffset;
+    switch (returnType(m.sig)) {
+        case 'D': memcpy(&r.d, data, sizeof(r.d)); break;
+        case 'F': memcpy(&r.f, data, sizeof(r.f)); break;
+        case 'J': memcpy(&r.j, data, sizeof(r.j)); break;
+    }
+    return r;
+}
+
+// Location built by a mock provider: isFromMockProvider() / isMock() say so
+jvalue trueBody(const Method&, JNIEnv*, jobject, const jvalue*) {
+    jvalue r = {};
+    r.z = JNI_TRUE;
+    return r;
+}
+
+jvalue stringLengthBody(const Method&, JNIEnv*, jobject self, const jvalue*) {
+    jvalue r = {};
+    r.i = (jint)static_cast<String*>(self)->utf.size();
+    return r;
+}
+
+// Settings.{Secure,Global}.getInt(resolver, name[, def]). The 2-arg overload throws
+// SettingNotFoundException on a missing key; the fake has no exceptions and returns 0.
+jvalue settingsGetIntBody(const Method& m, JNIEnv*, jobject self, const jvalue* args) {
+    const auto* klass = static_cast<const Class*>(self);
+    std::string table = klass->name.substr(klass->name.find('$') + 1);
+    auto it = settings().find(table + "/" + static_cast<String*>(args[1].l)->utf);
+    jvalue r = {};
+    if (it != settings().end())           r.i = it->second;
+    else if (m.sig.find(";I)") != std::string::npos) r.i = args[2].i;
+    return r;
+}
+
+jobject JNICALL String_intern(JNIEnv*, jobject self) {
+    return self;
+}
+
+// ── Classes ─────────────────────────────────────────────────────────
+
+struct MethodDef {
+    const char* name;
+    const char* sig;
+    uint32_t    flags;
+    Body        body;
+    void*       nativeFn;
+    const char* field;
+};
+
+Class* defineClass(const char* name,
+                   const std::vector<std::pair<const char*, const char*>>& fields,
+                   const std::vector<MethodDef>& methods = {}) {
+    auto klass = std::make_unique<Class>();
+    klass->name = name;
+    klass->id = (uint32_t)classesById().size();
+    size_t offset = 8;  // object header
+    for (auto& [fname, fsig] : fields) {
+        size_t size = sigSize(fsig);
+        offset = (offset + size - 1) & ~(size - 1);
+        klass->fields.push_back({fname, fsig, offset});
+        offset += size;
+    }
+    klass->instanceSize = offset;
+
+    for (const MethodDef& d : methods) {
+        size_t fieldOffset = 0;
+        for (const Field& f : klass->fields) {
+            if (d.field && f.name == d.field) fieldOffset = f.offset;
+        }
+        klass->methods.push_back({d.name, d.sig, d.flags, d.body, d.nativeFn, fieldOffset});
+    }
+
+    // One empty ArtMethod on either side, so neighbour probes stay inside the array
+    const ArtLayout& l = artLayout();
+    klass->artMethodStorage.assign(((klass->methods.size() + 2) * l.size + 7) / 8, 0);
+    for (size_t i = 0; i < klass->methods.size(); i++) {
+        const Method& m = klass->methods[i];
+        auto* art = (uint8_t*)klass->artMethod(i);
+        uint32_t index = (uint32_t)i;
+        void* entry = (m.accessFlags & kAccNative) ? (void*)art_quick_generic_jni_trampoline
+                                                   : (void*)art_quick_to_interpreter_bridge;
+        memcpy(art, &klass->id, sizeof(uint32_t));
+        memcpy(art + 4, &m.accessFlags, sizeof(uint32_t));
+        memcpy(art + l.methodIndexOffset, &index, sizeof(uint32_t));
+        memcpy(art + l.dataOffset, &m.nativeFn, sizeof(void*));
+        memcpy(art + l.entryPointOffset, &entry, sizeof(void*));
+    }
+
+    Class* raw = klass.get();
+    classesById().push_back(raw);
+    classes()[name] = std::move(klass);
+    return raw;
+}
+
+void registerClasses() {
+    const uint32_t kVirtual = kAccPublic;
+    const uint32_t kStatic  = kAccPublic | kAccStatic;
+
+    // Field order follows ART's layout: references, then 64-bit, then 32-bit values
+    defineClass("android/location/Location", {
+        {"mProvider",                      "Ljava/lang/String;"},
+        {"mExtras",                        "Landroid/os/Bundle;"},
+        {"mTimeMs",                        "J"},
+        {"mElapsedRealtimeNs",             "J"},
+        {"mElapsedRealtimeUncertaintyNs",  "D"},
+        {"mLatitudeDegrees",               "D"},
+        {"mLongitudeDegrees",              "D"},
+        {"mAltitudeMeters",                "D"},
+        {"mMslAltitudeMeters",             "D"},
+        {"mFieldsMask",                    "I"},
+        {"mHorizontalAccuracyMeters",      "F"},
+        {"mAltitudeAccuracyMeters",        "F"},
+        {"mSpeedMetersPerSecond",          "F"},
+        {"mSpeedAccuracyMetersPerSecond",  "F"},
+        {"mBearingDegrees",                "F"},
+        {"mBearingAccuracyDegrees",        "F"},
+        {"mMslAltitudeAccuracyMeters",     "F"},
+    }, {
+        {"isFromMockProvider",      "()Z", kVirtual, trueBody,   nullptr, nullptr},
+        {"isMock",                  "()Z", kVirtual, trueBody,   nullptr, nullptr},
+        {"getLatitude",             "()D", kVirtual, getterBody, nullptr, "mLatitudeDegrees"},
+        {"getLongitude",            "()D", kVirtual, getterBody, nullptr, "mLongitudeDegrees"},
+        {"getAccuracy",             "()F", kVirtual, getterBody, nullptr, "mHorizontalAccuracyMeters"},
+        {"getAltitude",             "()D", kVirtual, getterBody, nullptr, "mAltitudeMeters"},
+        {"getSpeed",                "()F", kVirtual, getterBody, nullptr, "mSpeedMetersPerSecond"},
+        {"getBearing",              "()F", kVirtual, getterBody, nullptr, "mBearingDegrees"},
+        {"getTime",                 "()J", kVirtual, getterBody, nullptr, "mTimeMs"},
+        {"getElapsedRealtimeNanos", "()J", kVirtual, getterBody, nullptr, "mElapsedRealtimeNs"},
+    });
+
+    // Layout probe: a registered native instance method with a Java neighbour
+    defineClass("java/lang/String", {}, {
+        {"intern", "()Ljava/lang/String;", kVirtual | kAccNative, nullptr, (void*)String_intern, nullptr},
+        {"length", "()I",                  kVirtual,              stringLengthBody, nullptr, nullptr},
+    });
+
+    const char* kGetInt3 = "(Landroid/content/ContentResolver;Ljava/lang/String;I)I";
+    const char* kGetInt2 = "(Landroid/content/ContentResolver;Ljava/lang/String;)I";
+    defineClass("android/provider/Settings$Secure", {}, {
+        {"getInt", kGetInt3, kStatic, settingsGetIntBody, nullptr, nullptr},
+        {"getInt", kGetInt2, kStatic, settingsGetIntBody, nullptr, nullptr},
+    });
+    defineClass("android/provider/Settings$Global", {}, {
+        {"getInt", kGetInt3, kStatic, settingsGetIntBody, nullptr, nullptr},
+        {"getInt", kGetInt2, kStatic, settingsGetIntBody, nullptr, nullptr},
+    });
+}
+
+// ── Dispatch ────────────────────────────────────────────────────────
+
+const Method* methodOf(const void* artMethod) {
+    const auto* art = (const uint8_t*)artMethod;
+    uint32_t id, index;
+    memcpy(&id, art, sizeof(id));
+    memcpy(&index, art + artLayout().methodIndexOffset, sizeof(index));
+    if (id == 0 || id >= classesById().size()) return nullptr;
+    const Class* klass = classesById()[id];
+    return index < klass->methods.size() ? &klass->methods[index] : nullptr;
+}
+
+// Run a JNI function with the C signature matching the method's shape
+jvalue callNative(const Method& m, void* fn, JNIEnv* env, jobject self, const jvalue* args) {
+    jvalue r = {};
+    if (m.sig[1] == ')') {
+        switch (returnType(m.sig)) {
+            case 'Z': r.z = ((jboolean (*)(JNIEnv*, jobject))fn)(env, self); break;
+            case 'I': r.i = ((jint (*)(JNIEnv*, jobject))fn)(env, self);     break;
+            case 'J': r.j = ((jlong (*)(JNIEnv*, jobject))fn)(env, self);    break;
+            case 'F': r.f = ((jfloat (*)(JNIEnv*, jobject))fn)(env, self);   break;
+            case 'D': r.d = ((jdouble (*)(JNIEnv*, jobject))fn)(env, self);  break;
+            case 'L': r.l = ((jobject (*)(JNIEnv*, jobject))fn)(env, self);  break;
+        }
+    } else if (m.sig == "(Landroid/content/ContentResolver;Ljava/lang/String;)I") {
+        r.i = ((jint (*)(JNIEnv*, jclass, jobject, jstring))fn)(
+            env, (jclass)self, args[0].l, (jstring)args[1].l);
+    } else if (m.sig == "(Landroid/content/ContentResolver;Ljava/lang/String;I)I") {
+        r.i = ((jint (*)(JNIEnv*, jclass, jobject, jstring, jint))fn)(
+            env, (jclass)self, args[0].l, (jstring)args[1].l, args[2].i);
+    } else {
+        fprintf(stderr, "fakejni: no native call shape for %s%s\n", m.name.c_str(), m.sig.c_str());
+        abort();
+    }
+    return r;
+}
+
+// Unpack varargs by the method's parameter types (C promotes small ints and floats)
+std::vector<jvalue> argsFromVa(const Method& m, va_list ap) {
+    std::vector<jvalue> args;
+    for (size_t i = 1; m.sig[i] != ')'; i++) {
+        jvalue v = {};
+        switch (m.sig[i]) {
+            case 'J': v.j = va_arg(ap, jlong);          break;
+            case 'F': v.f = (jfloat)va_arg(ap, double); break;
+            case 'D': v.d = va_arg(ap, double);         break;
+            case 'L':
+                v.l = va_arg(ap, jobject);
+                i = m.sig.find(';', i);
+                break;
+            default:  v.i = va_arg(ap, jint);           break;
+        }
+        args.push_back(v);
+    }
+    return args;
+}
+
+// ── JNI function table ──────────────────────────────────────────────
+
+jclass FindClass(JNIEnv*, const char* name) {
+    Class* klass = findClass(name);
+    if (klass) g_localRefs++;
+    return klass;
+}
+
+void ExceptionClear(JNIEnv*) {}
+
+jboolean ExceptionCheck(JNIEnv*) { return JNI_FALSE; }
+
+void DeleteLocalRef(JNIEnv*, jobject ref) {
+    if (ref) g_localRefs--;
+}
+
+jclass GetObjectClass(JNIEnv*, jobject obj) {
+    g_localRefs++;
+    return static_cast<Object*>(obj)->klass;
+}
+
+jmethodID findMethod(jclass clazz, const char* name, const char* sig, bool isStatic) {
+    if (!clazz) return nullptr;
+    auto* klass = static_cast<Class*>(clazz);
+    for (size_t i = 0; i < klass->methods.size(); i++) {
+        const Method& m = klass->methods[i];
+        if (m.name == name && m.sig == sig && ((m.accessFlags & kAccStatic) != 0) == isStatic) {
+            return (jmethodID)klass->artMethod(i);
+        }
+    }
+    return nullptr;
+}
+
+jmethodID GetMethodID(JNIEnv*, jclass clazz, const char* name, const char* sig) {
+    return findMethod(clazz, name, sig, false);
+}
+
+jmethodID GetStaticMethodID(JNIEnv*, jclass clazz, const char* name, const char* sig) {
+    return findMethod(clazz, name, sig, true);
+}
+
+jfieldID GetFieldID(JNIEnv*, jclass clazz, const char* name, const char* sig) {
+    if (!clazz) return nullptr;
+    return (jfieldID)static_cast<Class*>(clazz)->findField(name, sig);
+}
+
+template <class T>
+T readField(jobject obj, jfieldID fid) {
+    T value;
+    memcpy(&value, static_cast<Object*>(obj)->data + ((const Field*)fid)->offset, sizeof(T));
+    return value;
+}
+
+jdouble GetDoubleField(JNIEnv*, jobject obj, jfieldID fid) { return readField<jdouble>(obj, fid); }
+jfloat  GetFloatField(JNIEnv*, jobject obj, jfieldID fid)  { return readField<jfloat>(obj, fid); }
+jlong   GetLongField(JNIEnv*, jobject obj, jfieldID fid)   { return readField<jlong>(obj, fid); }
+
+const char* GetStringUTFChars(JNIEnv*, jstring str, jboolean* isCopy) {
+    if (isCopy) *isCopy = JNI_FALSE;
+    return str ? static_cast<String*>(str)->utf.c_str() : nullptr;
+}
+
+void ReleaseStringUTFChars(JNIEnv*, jstring, const char*) {}
+
+// Global refs are never collected in the fake, so the object pointer is the ref
+jobject NewGlobalRef(JNIEnv*, jobject obj) { return obj; }
+
+// CallNonvirtual* runs exactly the ArtMethod passed in, as ART does
+jvalue invokeV(jmethodID mid, jobject self, va_list ap) {
+    const Method* m = methodOf(mid);
+    if (!m) return jvalue{};
+    std::vector<jvalue> args = argsFromVa(*m, ap);
+    return invoke(mid, self, args.data());
+}
+
+jdouble CallNonvirtualDoubleMethodV(JNIEnv*, jobject obj, jclass, jmethodID mid, va_list ap) {
+    return invokeV(mid, obj, ap).d;
+}
+
+jfloat CallNonvirtualFloatMethodV(JNIEnv*, jobject obj, jclass, jmethodID mid, va_list ap) {
+    return invokeV(mid, obj, ap).f;
+}
+
+jlong CallNonvirtualLongMethodV(JNIEnv*, jobject obj, jclass, jmethodID mid, va_list ap) {
+    return invokeV(mid, obj, ap).j;
+}
+
+jint CallStaticIntMethodV(JNIEnv*, jclass clazz, jmethodID mid, va_list ap) {
+    return invokeV(mid, clazz, ap).i;
+}
+
+const JNINativeInterface kFunctions = {
+    FindClass,
+    ExceptionClear,
+    ExceptionCheck,
+    DeleteLocalRef,
+    GetObjectClass,
+    GetMethodID,
+    GetStaticMethodID,
+    GetFieldID,
+    GetDoubleField,
+    GetFloatField,
+    GetLongField,
+    GetStringUTFChars,
+    ReleaseStringUTFChars,
+    NewGlobalRef,
+    CallNonvirtualDoubleMethodV,
+    CallNonvirtualFloatMethodV,
+    CallNonvirtualLongMethodV,
+    CallStaticIntMethodV,
+};
+
+} // namespace
+
+const ArtLayout& artLayout() {
+    static const ArtLayout layout = [] {
+        char value[PROP_VALUE_MAX] = {};
+        __system_property_get("ro.build.version.sdk", value);
+        int api = atoi(value);
+        // {size, data_, entry_point_, dex_method_index_} as in ART for this API level
+        if (sizeof(void*) == 8) {
+            if (api >= 31) return ArtLayout{32, 16, 24, 8};
+            if (api >= 28) return ArtLayout{40, 24, 32, 12};
+            return ArtLayout{48, 32, 40, 12};
+        }
+        if (api >= 31) return ArtLayout{24, 16, 20, 8};
+        if (api >= 28) return ArtLayout{28, 20, 24, 12};
+        return ArtLayout{32, 24, 28, 12};
+    }();
+    return layout;
+}
+
+const Field* Class::findField(const char* fname, const char* fsig) const {
+    for (const Field& f : fields) {
+        if (!strcmp(f.name.c_str(), fname) && !strcmp(f.sig.c_str(), fsig)) return &f;
+    }
+    return nullptr;
+}
+
+void* Class::artMethod(size_t index) {
+    return (uint8_t*)artMethodStorage.data() + (index + 1) * artLayout().size;
+}
+
+JNIEnv* env() {
+    static JNIEnv instance = [] {
+        registerClasses();
+        JNIEnv e;
+        e.functions = &kFunctions;
+        return e;
+    }();
+    return &instance;
+}
+
+Class* findClass(const char* name) {
+    env();
+    auto it = classes().find(name);
+    return it == classes().end() ? nullptr : it->second.get();
+}
+
+Class* locationClass() {
+    return findClass("android/location/Location");
+}
+
+Object* newObject(Class* klass) {
+    auto* obj = new Object();
+    obj->klass = klass;
+    obj->data = (uint8_t*)calloc(1, klass->instanceSize);
+    return obj;
+}
+
+jstring newString(const char* utf) {
+    auto* str = new String();
+    str->utf = utf;
+    return str;
+}
+
+jvalue invoke(jmethodID method, jobject self, const jvalue* args) {
+    const Method* m = methodOf(method);
+    if (!m) return jvalue{};
+
+    const ArtLayout& l = artLayout();
+    const auto* art = (const uint8_t*)method;
+    uint32_t flags = __atomic_load_n((const uint32_t*)(art + 4), __ATOMIC_ACQUIRE);
+    void* entry = __atomic_load_n((void* const*)(art + l.entryPointOffset), __ATOMIC_ACQUIRE);
+    if (entry == (void*)art_quick_generic_jni_trampoline && (flags & kAccNative)) {
+        void* fn = __atomic_load_n((void* const*)(art + l.dataOffset), __ATOMIC_ACQUIRE);
+        return callNative(*m, fn, env(), self, args);
+    }
+    return m->body(*m, env(), self, args);
+}
+
+jvalue callVirtual(jobject obj, const char* name, const char* sig) {
+    jmethodID mid = findMethod(static_cast<Object*>(obj)->klass, name, sig, false);
+    return mid ? invoke(mid, obj, nullptr) : jvalue{};
+}
+
+void putSetting(const char* table, const char* key, int value) {
+    settings()[std::string(table) + "/" + key] = value;
+}
+
+long liveLocalRefs() {
+    return g_localRefs;
+}
+
+} // namespace fakejni
+
+// ── <android/log.h> ─────────────────────────────────────────────────
+
+namespace {
+std::atomic<long> g_loggedLines{0};
+}
+
+namespace fakejni {
+
+long loggedLines() {
+    return g_loggedLines.load();
+}
+
+} // namespace fakejni
+
+extern "C" int __android_log_print(int prio, const char* tag, const char* fmt, ...) {
+    static const bool enabled = getenv("MOCKGPS_HOST_LOG") != nullptr;
+    g_loggedLines++;
+    if (!enabled) return 0;
+    va_list ap;
+    va_start(ap, fmt);
+    fprintf(stderr, "%d %s: ", prio, tag);
+    int n = vfprintf(stderr, fmt, ap);
+    fputc('\n', stderr);
+    va_end(ap);
+    return n;
+}
+
+// ── <android/trace.h> ───────────────────────────────────────────────
+
+namespace {
+std::mutex               g_traceLock;
+std::vector<std::string> g_traceSections;
+int                      g_openTraceSections = 0;
+}
+
+namespace fakejni {
+
+std::vector<std::string> traceSections() {
+    std::lock_guard<std::mutex> lock(g_traceLock);
+    return g_traceSections;
+}
+
+int openTraceSections() {
+    std::lock_guard<std::mutex> lock(g_traceLock);
+    return g_openTraceSections;
+}
+
+} // namespace fakejni
+
+extern "C" bool ATrace_isEnabled() {
+    return true;
+}
+
+extern "C" void ATrace_beginSection(const char* sectionName) {
+    std::lock_guard<std::mutex> lock(g_traceLock);
+    g_traceSections.push_back(sectionName);
+    g_openTraceSections++;
+}
+
+extern "C" void ATrace_endSection() {
+    std::lock_guard<std::mutex> lock(g_traceLock);
+    g_openTraceSections--;
+}
+
+// ── <sys/system_properties.h> ───────────────────────────────────────
+
+extern "C" int __system_property_get(const char* name, char* value) {
+    std::string key = "MOCKGPS_PROP_";
+    for (const char* p = name; *p; p++) key += (*p == '.') ? '_' : *p;
+    const char* v = getenv(key.c_str());
+    if (!v && !strcmp(name, "ro.build.version.sdk")) v = "34";
+    if (!v) {
+        value[0] = 0;
+        return 0;
+    }
+    snprintf(value, PROP_VALUE_MAX, "%s", v);
+    return (int)strlen(value);
+}
@@ -0,0 +1,122 @@
+// MockGPS host harness - fake JVM behind the host <jni.h>
+//
+// Just enough of a runtime for module.cpp: classes with named fields laid out in
+// plain object memory, and JNI lookups that cost roughly what ART's do (a linear
+// name/signature scan per GetFieldID, a local reference per GetObjectClass).
+//
+// Methods are backed by fake ArtMethod memory. Each class owns one contiguous array
+// of ArtMethods laid out like ART's for the configured API level
+// (ro.build.version.sdk, default 34), so jmethodIDs are real ArtMethod pointers the
+// module can detect, patch and clone. invoke() dispatches the way ART does: a method
+// whose entry point is the generic JNI trampoline and whose flags say native runs
+// its data_ function (i.e. a hook), anything else runs its Java body.
+
+#pragma once
+
+#include <jni.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// The generic JNI trampoline the module looks up with dlsym(RTLD_DEFAULT). It is
+// never executed: invoke() recognises it as an entry point.
+extern "C" void art_quick_generic_jni_trampoline();
+
+namespace fakejni {
+
+struct ArtLayout {
+    size_t size;
+    size_t dataOffset;
+    size_t entryPointOffset;
+    size_t methodIndexOffset;   // dex_method_index_
+};
+
+// Layout used for every fake ArtMethod in this process
+const ArtLayout& artLayout();
+
+struct Method;
+
+// Java body of a method: `self` is the receiver, or the class for static methods
+using Body = jvalue (*)(const Method& m, JNIEnv* env, jobject self, const jvalue* args);
+
+struct Method {
+    std::string name;
+    std::string sig;
+    uint32_t    accessFlags;
+    Body        body;       // non-native methods
+    void*       nativeFn;   // native methods: the registered JNI function
+    size_t      fieldOffset; // getters: offset of the field the body reads
+};
+
+struct Field {
+    std::string name;
+    std::string sig;
+    size_t      offset;
+};
+
+struct Class : _jclass {
+    std::string         name;
+    uint32_t            id = 0;          // stands in for the compressed class pointer
+    std::vector<Field>  fields;
+    size_t              instanceSize = 0;
+    std::vector<Method> methods;
+    std::vector<uint64_t> artMethodStorage;
+
+    const Field* findField(const char* name, const char* sig) const;
+    void* artMethod(size_t index);
+};
+
+struct Object : _jobject {
+    Class*   klass;
+    uint8_t* data;
+};
+
+struct String : _jstring {
+    std::string utf;
+};
+
+// Process-wide fake environment; classes are registered once on first use
+JNIEnv* env();
+
+Class* findClass(const char* name);
+
+// android.location.Location with the Android 12+ field names
+Class* locationClass();
+
+Object* newObject(Class* klass);
+
+jstring newString(const char* utf);
+
+template <class T>
+void setField(Object* obj, const char* name, T value) {
+    for (const Field& f : obj->klass->fields) {
+        if (f.name == name) {
+            memcpy(obj->data + f.offset, &value, sizeof(T));
+            return;
+        }
+    }
+}
+
+// Call through ART-style dispatch; `self` is the receiver or the class
+jvalue invoke(jmethodID method, jobject self, const jvalue* args);
+
+// Virtual call of a no-argument method by name, as app code would make it
+jvalue callVirtual(jobject obj, const char* name, const char* sig);
+
+// Backing store for the fake Settings.Secure / Settings.Global getInt()
+void putSetting(const char* table, const char* key, int value);
+
+// Local references handed out and not yet deleted
+long liveLocalRefs();
+
+// Lines written to the fake logcat (<android/log.h>), printed or not
+long loggedLines();
+
+// ATrace sections begun so far (<android/trace.h>), in order, and how many are open
+std::vector<std::string> traceSections();
+int openTraceSections();
+
+} // namespace fakejni
@@ -0,0 +1,85 @@
+// MockGPS host harness - Zygisk loader stand-in
+
+#include "fake_zygisk.hpp"
+
+#include <algorithm>
+#include <thread>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace fakezygisk {
+
+zygisk::AppSpecializeArgs AppArgs::view() {
+    return zygisk::AppSpecializeArgs{
+        uid, gid, gids, runtimeFlags, mountExternal, seInfo, niceName, instructionSet, appDataDir,
+        &isChildZygote, &isTopApp, &pkgDataInfoList, &whitelistedDataInfoList,
+        &mountDataDirs, &mountStorageDirs,
+    };
+}
+
+int connectCompanion(void (*handler)(int)) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0) return -1;
+    int server = sv[1];
+    std::thread([handler, server] {
+        handler(server);
+        close(server);
+    }).detach();
+    return sv[0];
+}
+
+Loader::Loader(JNIEnv* env) {
+    table_.impl             = this;
+    table_.registerModule   = registerModule;
+    table_.connectCompanion = connectCompanion;
+    table_.setOption        = setOption;
+    table_.getModuleDir     = getModuleDir;
+    table_.getFlags         = getFlags;
+    zygisk_module_entry(&table_, env);
+}
+
+void Loader::specializeApp(AppArgs& args) {
+    preAppSpecialize(args);
+    postAppSpecialize(args);
+}
+
+void Loader::preAppSpecialize(AppArgs& args) {
+    options_.clear();
+    zygisk::AppSpecializeArgs view = args.view();
+    abi_->preAppSpecialize(abi_->impl, &view);
+}
+
+void Loader::postAppSpecialize(AppArgs& args) {
+    zygisk::AppSpecializeArgs view = args.view();
+    abi_->postAppSpecialize(abi_->impl, &view);
+}
+
+bool Loader::dlclosed() const {
+    return std::find(options_.begin(), options_.end(), zygisk::DLCLOSE_MODULE_LIBRARY) != options_.end();
+}
+
+bool Loader::registerModule(zygisk::internal::api_table* table, zygisk::internal::module_abi* abi) {
+    static_cast<Loader*>(table->impl)->abi_ = abi;
+    return true;
+}
+
+int Loader::connectCompanion(void* impl) {
+    static_cast<Loader*>(impl)->connections_++;
+    return fakezygisk::connectCompanion();
+}
+
+void Loader::setOption(void* impl, zygisk::Option opt) {
+    static_cast<Loader*>(impl)->options_.push_back(opt);
+}
+
+// The module finds its files through MOCKGPS_MODULE_DIR on host
+int Loader::getModuleDir(void*) {
+    return -1;
+}
+
+uint32_t Loader::getFlags(void* impl) {
+    return static_cast<Loader*>(impl)->flags;
+}
+
+} // namespace fakezygisk
@@ -0,0 +1,77 @@
+// MockGPS host harness - stand-in for the Zygisk loader
+//
+// Drives the module through its real entry points: zygisk_module_entry() registers
+// it against a stub api_table, and each connectCompanion() returns one end of a
+// socketpair whose other end is handed to zygisk_companion_entry() on a thread of
+// its own, the way Zygisk's root daemon serves companion requests. The companion
+// runs in the same process here, so its state is shared with the "app" side.
+
+#pragma once
+
+#include <jni.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "zygisk.hpp"
+
+namespace fakezygisk {
+
+// Arguments for one app specialization; AppSpecializeArgs refers into these
+struct AppArgs {
+    jint         uid           = 10123;
+    jint         gid           = 10123;
+    jintArray    gids          = nullptr;
+    jint         runtimeFlags  = 0;
+    jint         mountExternal = 0;
+    jstring      seInfo        = nullptr;
+    jstring      niceName      = nullptr;
+    jstring      instructionSet = nullptr;
+    jstring      appDataDir    = nullptr;
+    jboolean     isChildZygote = JNI_FALSE;
+    jboolean     isTopApp      = JNI_FALSE;
+    jobjectArray pkgDataInfoList = nullptr;
+    jobjectArray whitelistedDataInfoList = nullptr;
+    jboolean     mountDataDirs = JNI_FALSE;
+    jboolean     mountStorageDirs = JNI_FALSE;
+
+    zygisk::AppSpecializeArgs view();
+};
+
+class Loader {
+public:
+    explicit Loader(JNIEnv* env);
+
+    // Value returned by Api::getFlags()
+    uint32_t flags = 0;
+
+    // One app process: preAppSpecialize then postAppSpecialize, as Zygisk calls them
+    void specializeApp(AppArgs& args);
+    void preAppSpecialize(AppArgs& args);
+    void postAppSpecialize(AppArgs& args);
+
+    // Options set by the module since the last specialization started
+    const std::vector<zygisk::Option>& options() const { return options_; }
+    bool dlclosed() const;
+
+    // connectCompanion() calls made so far
+    long companionConnections() const { return connections_; }
+
+private:
+    static bool registerModule(zygisk::internal::api_table* table, zygisk::internal::module_abi* abi);
+    static int connectCompanion(void* impl);
+    static void setOption(void* impl, zygisk::Option opt);
+    static int getModuleDir(void* impl);
+    static uint32_t getFlags(void* impl);
+
+    zygisk::internal::api_table   table_ = {};
+    zygisk::internal::module_abi* abi_ = nullptr;
+    std::vector<zygisk::Option>   options_;
+    long                          connections_ = 0;
+};
+
+// Client end of a new companion connection: `handler` gets the other end on a thread
+// of its own and the fd is closed when it returns, as in Zygisk's companion daemon
+int connectCompanion(void (*handler)(int) = zygisk_companion_entry);
+
+} // namespace fakezygisk
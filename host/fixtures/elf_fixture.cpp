@@ -0,0 +1,10 @@
+// Shared library for the ELF resolver benchmark and elf_lookup: one exported
+// function and one hidden one, which only .symtab / .gnu_debugdata can see.
+
+extern "C" __attribute__((visibility("hidden"), noinline)) int mockgps_fixture_hidden(int x) {
+    return x * 3 + 1;
+}
+
+extern "C" __attribute__((visibility("default"))) int mockgps_fixture_exported(int x) {
+    return mockgps_fixture_hidden(x) + 1;
+}
@@ -0,0 +1,84 @@
+// MockGPS fuzz target - config text parser and location.bin decoder
+//
+// Feeds arbitrary bytes to parseConfigSet and decodeConfigFile, and checks what the
+// parser promises: accepted values are in range, formatConfigSet output parses back
+// to the same set without errors, and encode/decode round-trips.
+//
+//   clang:  config_fuzz host/fuzz/corpus/config       (libFuzzer)
+//   others: config_fuzz FILE...                       (replays the given inputs)
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "config_file.hpp"
+
+namespace {
+
+void require(bool ok, const char* what) {
+    if (ok) return;
+    fprintf(stderr, "config_fuzz: %s\n", what);
+    abort();
+}
+
+bool sameConfig(const MockConfig& a, const MockConfig& b) {
+    return a.lat == b.lat && a.lng == b.lng && a.altitude == b.altitude && a.accuracy == b.accuracy &&
+           a.speed == b.speed && a.bearing == b.bearing && a.enabled == b.enabled && a.hideDev == b.hideDev &&
+           a.overrides == b.overrides;
+}
+
+// Same defaults, and the same profiles resolving to the same configs
+bool sameConfigSet(const ConfigSet& a, const ConfigSet& b) {
+    if (!sameConfig(a.defaults, b.defaults) || a.profiles.size() != b.profiles.size()) return false;
+    for (size_t i = 0; i < a.profiles.size(); i++) {
+        const ConfigProfile& p = a.profiles[i];
+        const ConfigProfile& q = b.profiles[i];
+        if (p.key != q.key || p.mask != q.mask ||
+            !sameConfig(resolveProfile(a.defaults, p), resolveProfile(b.defaults, q))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void checkRanges(const MockConfig& cfg) {
+    require(cfg.lat >= -90 && cfg.lat <= 90, "lat out of range");
+    require(cfg.lng >= -180 && cfg.lng <= 180, "lng out of range");
+    require(std::isfinite(cfg.altitude) && std::isfinite(cfg.bearing), "non-finite value");
+    require(cfg.accuracy >= 0 && cfg.speed >= 0, "negative accuracy or speed");
+}
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    ConfigErrors errors;
+    ConfigSet set;
+    parseConfigSet(std::string_view((const char*)data, size), &set, &errors);
+
+    checkRanges(set.defaults);
+    require(set.profiles.size() <= kMaxProfiles, "too many profiles");
+    for (const auto& p : set.profiles) {
+        std::string key;
+        require(canonicalProfileKey(p.key, &key) && key == p.key, "non-canonical profile key");
+        checkRanges(resolveProfile(set.defaults, p));
+    }
+    for (int i = 0; i < kConfigKeyCount; i++) {
+        require(errors.key[i] == ConfigError::kNone || errors.line[i] > 0, "error without a line");
+    }
+
+    std::string text = formatConfigSet(set);
+    ConfigErrors again;
+    ConfigSet reparsed;
+    parseConfigSet(text, &reparsed, &again);
+    require(sameConfigSet(reparsed, set) && !again.any(), "formatConfigSet does not round-trip");
+
+    std::vector<uint8_t> rec = encodeConfigFile(set);
+    ConfigSet decoded;
+    require(decodeConfigFile(rec.data(), rec.size(), &decoded) && sameConfigSet(decoded, set),
+            "location.bin does not round-trip");
+
+    // Raw input as location.bin: must be rejected or decoded, never crash
+    decodeConfigFile(data, size, &decoded);
+    return 0;
+}
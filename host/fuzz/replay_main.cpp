@@ -0,0 +1,26 @@
+// Stand-in for libFuzzer's main when the compiler has no -fsanitize=fuzzer: runs the
+// target once per file named on the command line (a corpus entry or saved crash).
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        FILE* f = fopen(argv[i], "rb");
+        if (!f) {
+            perror(argv[i]);
+            return 2;
+        }
+        std::vector<uint8_t> data;
+        uint8_t buf[4096];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.insert(data.end(), buf, buf + n);
+        fclose(f);
+        LLVMFuzzerTestOneInput(data.data(), data.size());
+        printf("ok  %s (%zu bytes)\n", argv[i], data.size());
+    }
+    return 0;
+}
@@ -0,0 +1,9 @@
+// Host stand-in for <android/trace.h>; fakejni::traceSections() lists the sections begun
+
+#pragma once
+
+extern "C" {
+bool ATrace_isEnabled();
+void ATrace_beginSection(const char* sectionName);
+void ATrace_endSection();
+}
@@ -0,0 +1,170 @@
+// Host stand-in for <jni.h>
+//
+// Declares the subset of the JNI interface used by module.cpp with the same shape as
+// the real header (a JNINativeInterface function table behind C++ inline wrappers),
+// so the module compiles unchanged and calls land in host/fake_jni.cpp.
+
+#pragma once
+
+#include <cstdarg>
+#include <cstdint>
+
+typedef uint8_t  jboolean;
+typedef int8_t   jbyte;
+typedef uint16_t jchar;
+typedef int16_t  jshort;
+typedef int32_t  jint;
+typedef int64_t  jlong;
+typedef float    jfloat;
+typedef double   jdouble;
+typedef jint     jsize;
+
+class _jobject {};
+class _jclass : public _jobject {};
+class _jstring : public _jobject {};
+class _jarray : public _jobject {};
+class _jobjectArray : public _jarray {};
+class _jintArray : public _jarray {};
+class _jthrowable : public _jobject {};
+
+typedef _jobject*      jobject;
+typedef _jclass*       jclass;
+typedef _jstring*      jstring;
+typedef _jarray*       jarray;
+typedef _jobjectArray* jobjectArray;
+typedef _jintArray*    jintArray;
+typedef _jthrowable*   jthrowable;
+
+typedef union jvalue {
+    jboolean z;
+    jbyte    b;
+    jchar    c;
+    jshort   s;
+    jint     i;
+    jlong    j;
+    jfloat   f;
+    jdouble  d;
+    jobject  l;
+} jvalue;
+
+struct _jfieldID;
+typedef struct _jfieldID* jfieldID;
+struct _jmethodID;
+typedef struct _jmethodID* jmethodID;
+
+#define JNI_FALSE 0
+#define JNI_TRUE  1
+
+#define JNI_OK  0
+#define JNI_ERR (-1)
+
+#define JNIEXPORT __attribute__((visibility("default")))
+#define JNICALL
+
+typedef struct {
+    const char* name;
+    const char* signature;
+    void*       fnPtr;
+} JNINativeMethod;
+
+struct _JNIEnv;
+typedef _JNIEnv JNIEnv;
+
+struct JNINativeInterface {
+    jclass      (*FindClass)(JNIEnv*, const char*);
+    void        (*ExceptionClear)(JNIEnv*);
+    jboolean    (*ExceptionCheck)(JNIEnv*);
+    void        (*DeleteLocalRef)(JNIEnv*, jobject);
+    jclass      (*GetObjectClass)(JNIEnv*, jobject);
+    jmethodID   (*GetMethodID)(JNIEnv*, jclass, const char*, const char*);
+    jmethodID   (*GetStaticMethodID)(JNIEnv*, jclass, const char*, const char*);
+    jfieldID    (*GetFieldID)(JNIEnv*, jclass, const char*, const char*);
+    jdouble     (*GetDoubleField)(JNIEnv*, jobject, jfieldID);
+    jfloat      (*GetFloatField)(JNIEnv*, jobject, jfieldID);
+    jlong       (*GetLongField)(JNIEnv*, jobject, jfieldID);
+    const char* (*GetStringUTFChars)(JNIEnv*, jstring, jboolean*);
+    void        (*ReleaseStringUTFChars)(JNIEnv*, jstring, const char*);
+    jobject     (*NewGlobalRef)(JNIEnv*, jobject);
+    jdouble     (*CallNonvirtualDoubleMethodV)(JNIEnv*, jobject, jclass, jmethodID, va_list);
+    jfloat      (*CallNonvirtualFloatMethodV)(JNIEnv*, jobject, jclass, jmethodID, va_list);
+    jlong       (*CallNonvirtualLongMethodV)(JNIEnv*, jobject, jclass, jmethodID, va_list);
+    jint        (*CallStaticIntMethodV)(JNIEnv*, jclass, jmethodID, va_list);
+};
+
+struct _JNIEnv {
+    const struct JNINativeInterface* functions;
+
+    jclass FindClass(const char* name)
+    { return functions->FindClass(this, name); }
+
+    void ExceptionClear()
+    { functions->ExceptionClear(this); }
+
+    jboolean ExceptionCheck()
+    { return functions->ExceptionCheck(this); }
+
+    void DeleteLocalRef(jobject localRef)
+    { functions->DeleteLocalRef(this, localRef); }
+
+    jclass GetObjectClass(jobject obj)
+    { return functions->GetObjectClass(this, obj); }
+
+    jmethodID GetMethodID(jclass clazz, const char* name, const char* sig)
+    { return functions->GetMethodID(this, clazz, name, sig); }
+
+    jmethodID GetStaticMethodID(jclass clazz, const char* name, const char* sig)
+    { return functions->GetStaticMethodID(this, clazz, name, sig); }
+
+    jfieldID GetFieldID(jclass clazz, const char* name, const char* sig)
+    { return functions->GetFieldID(this, clazz, name, sig); }
+
+    jdouble GetDoubleField(jobject obj, jfieldID fieldID)
+    { return functions->GetDoubleField(this, obj, fieldID); }
+
+    jfloat GetFloatField(jobject obj, jfieldID fieldID)
+    { return functions->GetFloatField(this, obj, fieldID); }
+
+    jlong GetLongField(jobject obj, jfieldID fieldID)
+    { return functions->GetLongField(this, obj, fieldID); }
+
+    const char* GetStringUTFChars(jstring string, jboolean* isCopy)
+    { return functions->GetStringUTFChars(this, string, isCopy); }
+
+    void ReleaseStringUTFChars(jstring string, const char* utf)
+    { functions->ReleaseStringUTFChars(this, string, utf); }
+
+    jobject NewGlobalRef(jobject lobj)
+    { return functions->NewGlobalRef(this, lobj); }
+
+    jdouble CallNonvirtualDoubleMethod(jobject obj, jclass clazz, jmethodID methodID, ...) {
+        va_list args;
+        va_start(args, methodID);
+        jdouble result = functions->CallNonvirtualDoubleMethodV(this, obj, clazz, methodID, args);
+        va_end(args);
+        return result;
+    }
+
+    jfloat CallNonvirtualFloatMethod(jobject obj, jclass clazz, jmethodID methodID, ...) {
+        va_list args;
+        va_start(args, methodID);
+        jfloat result = functions->CallNonvirtualFloatMethodV(this, obj, clazz, methodID, args);
+        va_end(args);
+        return result;
+    }
+
+    jlong CallNonvirtualLongMethod(jobject obj, jclass clazz, jmethodID methodID, ...) {
+        va_list args;
+        va_start(args, methodID);
+        jlong result = functions->CallNonvirtualLongMethodV(this, obj, clazz, methodID, args);
+        va_end(args);
+        return result;
+    }
+
+    jint CallStaticIntMethod(jclass clazz, jmethodID methodID, ...) {
+        va_list args;
+        va_start(args, methodID);
+        jint result = functions->CallStaticIntMethodV(this, clazz, methodID, args);
+        va_end(args);
+        return result;
+    }
+};
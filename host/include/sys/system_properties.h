@@ -0,0 +1,9 @@
+// Host stand-in for <sys/system_properties.h>; properties come from the environment
+// as MOCKGPS_PROP_<name with '.' replaced by '_'>, e.g. MOCKGPS_PROP_ro_build_version_sdk
+// (which defaults to 34; the fake ArtMethod layout follows it)
+
+#pragma once
+
+#define PROP_VALUE_MAX 92
+
+extern "C" int __system_property_get(const char* name, char* value);
@@ -0,0 +1,582 @@
+// MockGPS host harness - streaming GPX, KML and GeoJSON track readers
+//
+// What route_compile turns into route.bin. A reader takes the file in chunks of any
+// size through feed() and finish(); no chunk is kept after feed() returns, so memory
+// is bounded by the track (capped at kRouteMaxPoints points), never by the input.
+// Readers keep only the markup or token in progress, and the points.
+//
+//   GPX      <trkpt> and <rtept> lat/lon, with their <time>
+//   KML      <LineString><coordinates> (no times) and <gx:Track> <when>/<gx:coord>
+//   GeoJSON  LineString/MultiLineString/Polygon "coordinates", with the
+//            "coordTimes" or "times" arrays some exporters add (ISO 8601 strings,
+//            or numbers as seconds)
+//
+// Several tracks or segments in one file are joined in document order. XML
+// namespaces are matched by local name only and entities are not expanded: none
+// of the values read can contain one.
+
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "route.hpp"
+
+// Points as read; timeMs is set by buildRoute()
+struct Track {
+    std::vector<RoutePoint> points;
+    std::vector<double>     times;    // seconds since the epoch, NaN where a point has none
+    size_t                  limit = kRouteMaxPoints;
+    bool                    tooLong = false;
+
+    void addPoint(double lat, double lng) {
+        if (!(lat >= -90 && lat <= 90 && lng >= -180 && lng <= 180)) return;
+        if (points.size() >= limit) {
+            tooLong = true;
+            return;
+        }
+        points.push_back({0, (int32_t)std::lround(lat * 1e7), (int32_t)std::lround(lng * 1e7)});
+    }
+
+    void addTime(double t) {
+        if (times.size() < limit) times.push_back(t);
+    }
+};
+
+class TrackReader {
+public:
+    virtual ~TrackReader() = default;
+    // False once the input is malformed; error says why
+    virtual bool feed(const char* data, size_t n) = 0;
+    virtual bool finish() = 0;
+
+    Track       track;
+    std::string error;
+};
+
+// ═══════════════════════════════════════════════════════════════════
+// Values
+// ═══════════════════════════════════════════════════════════════════
+
+inline bool isSpace(char c) { return c == ' ' || c == '\n' || c == '\t' || c == '\r'; }
+
+inline bool parseNumber(std::string_view s, double* v) {
+    while (!s.empty() && (isSpace(s.front()) || s.front() == '+')) s.remove_prefix(1);
+    auto r = std::from_chars(s.data(), s.data() + s.size(), *v);
+    return r.ec == std::errc() && std::isfinite(*v);
+}
+
+// Days from 1970-01-01 to a proleptic Gregorian date
+inline int64_t daysFromCivil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = (unsigned)(y - era * 400);
+    unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+// "YYYY-MM-DDTHH:MM:SS[.fff][Z|+HH:MM|-HH:MM]" to seconds since the epoch; NaN if
+// it is not one. Without a zone the time is taken as UTC.
+inline double parseIsoTime(std::string_view s) {
+    while (!s.empty() && isSpace(s.front())) s.remove_prefix(1);
+    while (!s.empty() && isSpace(s.back())) s.remove_suffix(1);
+    auto digits = [&](size_t at, size_t n, int* v) {
+        if (at + n > s.size()) return false;
+        *v = 0;
+        for (size_t i = at; i < at + n; i++) {
+            if (s[i] < '0' || s[i] > '9') return false;
+            *v = *v * 10 + (s[i] - '0');
+        }
+        return true;
+    };
+    int y, mo, d, h, mi, sec;
+    if (!digits(0, 4, &y) || s.size() < 19 || s[4] != '-' || !digits(5, 2, &mo) || s[7] != '-' ||
+        !digits(8, 2, &d) || (s[10] != 'T' && s[10] != ' ') || !digits(11, 2, &h) || s[13] != ':' ||
+        !digits(14, 2, &mi) || s[16] != ':' || !digits(17, 2, &sec) || mo < 1 || mo > 12 || d < 1 || d > 31 ||
+        h > 23 || mi > 59 || sec > 60) {
+        return NAN;
+    }
+    double t = (double)(daysFromCivil(y, mo, d) * 86400 + h * 3600 + mi * 60 + sec);
+    size_t i = 19;
+    if (i < s.size() && (s[i] == '.' || s[i] == ',')) {
+        double scale = 0.1;
+        for (i++; i < s.size() && s[i] >= '0' && s[i] <= '9'; i++, scale /= 10) t += (s[i] - '0') * scale;
+    }
+    if (i == s.size() || (s[i] == 'Z' && i + 1 == s.size())) return t;
+    int zh, zm = 0;
+    if ((s[i] != '+' && s[i] != '-') || !digits(i + 1, 2, &zh)) return NAN;
+    size_t end = i + 3;
+    if (end < s.size() && s[end] == ':') end++;
+    if (end < s.size() && !digits(end, 2, &zm)) return NAN;
+    if (end + (end < s.size() ? 2 : 0) != s.size()) return NAN;
+    double offset = zh * 3600.0 + zm * 60.0;
+    return s[i] == '+' ? t - offset : t + offset;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// XML
+// ═══════════════════════════════════════════════════════════════════
+
+// Tags, comments, CDATA and processing instructions may span chunks; text is handed
+// on in pieces as it arrives
+class XmlReader : public TrackReader {
+public:
+    static constexpr size_t kMaxMarkup = 1u << 20;   // one tag or comment
+
+    bool feed(const char* data, size_t n) override {
+        const char* end = data + n;
+        while (data < end && error.empty()) {
+            if (m_state == kText) {
+                const char* lt = (const char*)memchr(data, '<', end - data);
+                const char* stop = lt ? lt : end;
+                if (stop > data) onText(data, stop - data);
+                if (!lt) break;
+                data = lt + 1;
+                m_state = kTag;
+                m_tag.clear();
+                continue;
+            }
+            // In markup: copy up to the next '>' or quote, then see what it closes
+            const char* p = data;
+            if (m_quote) {
+                while (p < end && *p != m_quote) p++;
+            } else {
+                while (p < end && *p != '>' && *p != '"' && *p != '\'') p++;
+            }
+            m_tag.append(data, p - data);
+            if (m_tag.size() > kMaxMarkup) {
+                error = "markup longer than 1 MiB";
+                return false;
+            }
+            if (p == end) break;
+            data = p + 1;
+            if (*p != '>') {
+                // Quotes only matter inside element tags
+                if (m_quote) m_quote = 0;
+                else if (!m_tag.empty() && m_tag[0] != '!' && m_tag[0] != '?') m_quote = *p;
+                m_tag.push_back(*p);
+            } else if (markupComplete()) {
+                m_state = kText;
+                dispatch();
+            } else {
+                m_tag.push_back('>');
+            }
+        }
+        return error.empty();
+    }
+
+    bool finish() override {
+        if (error.empty() && m_state != kText) error = "input ends inside a tag";
+        return error.empty();
+    }
+
+protected:
+    // `name` without its namespace prefix
+    virtual void onOpen(std::string_view name, std::string_view attrs) = 0;
+    virtual void onClose(std::string_view name) = 0;
+    virtual void onText(const char* data, size_t n) = 0;
+
+    static std::string_view attribute(std::string_view attrs, std::string_view name) {
+        size_t i = 0;
+        while (i < attrs.size()) {
+            while (i < attrs.size() && isSpace(attrs[i])) i++;
+            size_t start = i;
+            while (i < attrs.size() && attrs[i] != '=' && !isSpace(attrs[i])) i++;
+            std::string_view key = attrs.substr(start, i - start);
+            while (i < attrs.size() && isSpace(attrs[i])) i++;
+            if (i >= attrs.size() || attrs[i] != '=') return {};
+            i++;
+            while (i < attrs.size() && isSpace(attrs[i])) i++;
+            if (i >= attrs.size() || (attrs[i] != '"' && attrs[i] != '\'')) return {};
+            size_t close = attrs.find(attrs[i], i + 1);
+            if (close == std::string_view::npos) return {};
+            if (key == name) return attrs.substr(i + 1, close - i - 1);
+            i = close + 1;
+        }
+        return {};
+    }
+
+private:
+    enum State { kText, kTag };
+
+    static bool endsWith(const std::string& s, std::string_view tail) {
+        return s.size() >= tail.size() && std::string_view(s).substr(s.size() - tail.size()) == tail;
+    }
+
+    bool markupComplete() const {
+        if (m_tag.compare(0, 3, "!--") == 0) return m_tag.size() >= 5 && endsWith(m_tag, "--");
+        if (m_tag.compare(0, 8, "![CDATA[") == 0) return m_tag.size() >= 10 && endsWith(m_tag, "]]");
+        if (!m_tag.empty() && m_tag[0] == '?') return endsWith(m_tag, "?");
+        return true;
+    }
+
+    static std::string_view localName(std::string_view name) {
+        size_t colon = name.rfind(':');
+        return colon == std::string_view::npos ? name : name.substr(colon + 1);
+    }
+
+    void dispatch() {
+        std::string_view tag = m_tag;
+        if (tag.empty() || tag[0] == '?' || tag.compare(0, 3, "!--") == 0) return;
+        if (tag.compare(0, 8, "![CDATA[") == 0) {
+            onText(tag.data() + 8, tag.size() - 10);
+            return;
+        }
+        if (tag[0] == '!') return;   // DOCTYPE
+        if (tag[0] == '/') {
+            tag.remove_prefix(1);
+            size_t end = 0;
+            while (end < tag.size() && !isSpace(tag[end])) end++;
+            onClose(localName(tag.substr(0, end)));
+            return;
+        }
+        bool empty = tag.back() == '/';
+        if (empty) tag.remove_suffix(1);
+        size_t end = 0;
+        while (end < tag.size() && !isSpace(tag[end])) end++;
+        std::string_view name = localName(tag.substr(0, end));
+        onOpen(name, tag.substr(end));
+        if (empty) onClose(name);
+    }
+
+    State       m_state = kText;
+    char        m_quote = 0;
+    std::string m_tag;
+};
+
+// Text of the element being captured, capped: only short values are read
+class TextCapture {
+public:
+    static constexpr size_t kMax = 256;
+
+    void start() {
+        m_on = true;
+        m_text.clear();
+    }
+    void append(const char* data, size_t n) {
+        if (m_on) m_text.append(data, std::min(n, kMax - std::min(kMax, m_text.size())));
+    }
+    // The text so far, and stop capturing
+    std::string_view take() {
+        m_on = false;
+        return m_text;
+    }
+    bool on() const { return m_on; }
+
+private:
+    bool        m_on = false;
+    std::string m_text;
+};
+
+class GpxReader : public XmlReader {
+protected:
+    void onOpen(std::string_view name, std::string_view attrs) override {
+        if (name == "trkpt" || name == "rtept") {
+            m_inPoint = parseNumber(attribute(attrs, "lat"), &m_lat) && parseNumber(attribute(attrs, "lon"), &m_lng);
+            m_time = NAN;
+        } else if (name == "time" && m_inPoint) {
+            m_text.start();
+        }
+    }
+
+    void onClose(std::string_view name) override {
+        if (name == "time" && m_text.on()) {
+            m_time = parseIsoTime(m_text.take());
+        } else if ((name == "trkpt" || name == "rtept") && m_inPoint) {
+            m_inPoint = false;
+            size_t before = track.points.size();
+            track.addPoint(m_lat, m_lng);
+            if (track.points.size() > before) track.addTime(m_time);
+        }
+    }
+
+    void onText(const char* data, size_t n) override { m_text.append(data, n); }
+
+private:
+    bool        m_inPoint = false;
+    double      m_lat = 0, m_lng = 0, m_time = NAN;
+    TextCapture m_text;
+};
+
+class KmlReader : public XmlReader {
+protected:
+    void onOpen(std::string_view name, std::string_view) override {
+        if (name == "LineString") {
+            m_inLine = true;
+        } else if (name == "coordinates" && m_inLine) {
+            m_inCoords = true;
+            m_token.clear();
+        } else if (name == "Track") {
+            m_inTrack = true;
+        } else if ((name == "when" || name == "coord") && m_inTrack) {
+            m_text.start();
+        }
+    }
+
+    void onClose(std::string_view name) override {
+        if (name == "LineString") {
+            m_inLine = false;
+        } else if (name == "coordinates" && m_inCoords) {
+            tuple();
+            m_inCoords = false;
+        } else if (name == "Track") {
+            m_inTrack = false;
+        } else if (name == "when" && m_text.on()) {
+            track.addTime(parseIsoTime(m_text.take()));
+        } else if (name == "coord" && m_text.on()) {
+            // gx:coord is "lng lat alt"
+            std::string_view s = m_text.take();
+            double lng, lat;
+            size_t at = s.find_first_not_of(" \t\r\n");
+            size_t gap = s.find_first_of(" \t\r\n", at);
+            if (at != std::string_view::npos && gap != std::string_view::npos &&
+                parseNumber(s.substr(at, gap - at), &lng) && parseNumber(s.substr(gap), &lat)) {
+                track.addPoint(lat, lng);
+            }
+        }
+    }
+
+    // <coordinates> is whitespace-separated "lng,lat[,alt]" tuples, maybe cut by a chunk
+    void onText(const char* data, size_t n) override {
+        m_text.append(data, n);
+        if (!m_inCoords) return;
+        for (const char* end = data + n; data < end; data++) {
+            char c = *data;
+            if (c == ' ' || c == '\n' || c == '\t' || c == '\r') tuple();
+            else if (m_token.size() < 128) m_token.push_back(c);
+        }
+    }
+
+private:
+    void tuple() {
+        if (m_token.empty()) return;
+        std::string_view s = m_token;
+        size_t comma = s.find(',');
+        double lng, lat;
+        if (comma != std::string_view::npos && parseNumber(s.substr(0, comma), &lng)) {
+            std::string_view rest = s.substr(comma + 1);
+            if (parseNumber(rest.substr(0, rest.find(',')), &lat)) track.addPoint(lat, lng);
+        }
+        m_token.clear();
+    }
+
+    bool        m_inLine = false, m_inCoords = false, m_inTrack = false;
+    std::string m_token;
+    TextCapture m_text;
+};
+
+// ═══════════════════════════════════════════════════════════════════
+// GeoJSON
+// ═══════════════════════════════════════════════════════════════════
+
+// A JSON tokenizer that keeps one frame per open object or array. Values under a
+// "coordinates" key become points where an array of numbers sits two or more
+// arrays deep (a lone Point geometry is one deep and skipped); values under
+// "coordTimes" or "times" become times.
+class GeoJsonReader : public TrackReader {
+public:
+    static constexpr size_t kMaxDepth = 256;
+
+    bool feed(const char* data, size_t n) override {
+        for (const char* end = data + n; data < end && error.empty();) {
+            char c = *data;
+            if (m_state == kString) {
+                // Skip to the closing quote, keeping keys and times
+                const char* p = data;
+                for (; p < end; p++) {
+                    if (m_escape) m_escape = false;
+                    else if (*p == '\\') m_escape = true;
+                    else if (*p == '"') break;
+                }
+                if (m_keep) m_token.append(data, std::min<size_t>(p - data, 256 - std::min<size_t>(m_token.size(), 256)));
+                if (p == end) break;
+                data = p + 1;
+                endString();
+                m_state = kValue;
+                continue;
+            }
+            if (m_state == kScalar) {
+                if (c == ',' || c == ']' || c == '}' || c == ' ' || c == '\n' || c == '\t' || c == '\r') {
+                    endScalar();
+                    m_state = kValue;
+                    continue;   // the delimiter is seen again below
+                }
+                if (m_token.size() < 64) m_token.push_back(c);
+                data++;
+                continue;
+            }
+            data++;
+            switch (c) {
+            case ' ': case '\n': case '\t': case '\r':
+                break;
+            case '{':
+            case '[':
+                if (m_frames.size() >= kMaxDepth) {
+                    error = "nested deeper than 256";
+                    break;
+                }
+                m_frames.push_back(open(c == '['));
+                break;
+            case '}':
+            case ']':
+                if (m_frames.empty() || m_frames.back().array != (c == ']')) {
+                    error = "unbalanced brackets";
+                    break;
+                }
+                close();
+                break;
+            case ',':
+                if (!m_frames.empty() && !m_frames.back().array) m_frames.back().expectKey = true;
+                break;
+            case ':':
+                if (!m_frames.empty()) m_frames.back().expectKey = false;
+                break;
+            case '"':
+                m_state = kString;
+                m_isKey = !m_frames.empty() && !m_frames.back().array && m_frames.back().expectKey;
+                m_keep = m_isKey || valueRole() == kTimes;
+                m_token.clear();
+                break;
+            default:
+                m_state = kScalar;
+                m_token.assign(1, c);
+                break;
+            }
+        }
+        return error.empty();
+    }
+
+    bool finish() override {
+        if (error.empty() && m_state == kScalar) endScalar();
+        if (error.empty() && (m_state == kString || !m_frames.empty())) error = "input ends inside a value";
+        return error.empty();
+    }
+
+private:
+    enum State { kValue, kString, kScalar };
+    enum Role : uint8_t { kNone, kCoords, kTimes };
+
+    struct Frame {
+        bool     array;
+        bool     expectKey = true;
+        bool     nested = false;   // holds an array or object
+        Role     role = kNone;
+        uint8_t  count = 0;        // numbers seen, for a coordinate tuple
+        uint32_t depth = 0;        // arrays since the role's key
+        double   nums[2] = {};
+        std::string key;
+    };
+
+    // What a value starting now is part of
+    Role valueRole() const {
+        if (m_frames.empty()) return kNone;
+        const Frame& f = m_frames.back();
+        if (f.array) return f.role;
+        if (f.key == "coordinates") return kCoords;
+        if (f.key == "coordTimes" || f.key == "times") return kTimes;
+        return kNone;
+    }
+
+    Frame open(bool array) {
+        Frame f;
+        f.array = array;
+        f.role = valueRole();
+        if (!m_frames.empty()) {
+            Frame& parent = m_frames.back();
+            parent.nested = true;
+            f.depth = array && f.role != kNone ? (parent.array && parent.role == f.role ? parent.depth : 0) + 1 : 0;
+        }
+        return f;
+    }
+
+    void close() {
+        Frame& f = m_frames.back();
+        if (f.array && f.role == kCoords && f.depth >= 2 && !f.nested && f.count >= 2) {
+            track.addPoint(f.nums[1], f.nums[0]);
+        }
+        m_frames.pop_back();
+    }
+
+    void endString() {
+        if (m_isKey) {
+            m_frames.back().key = m_token;
+        } else if (m_keep) {
+            track.addTime(parseIsoTime(m_token));
+        }
+    }
+
+    void endScalar() {
+        Role role = valueRole();
+        double v;
+        if (role == kNone || !parseNumber(m_token, &v)) return;
+        Frame& f = m_frames.back();
+        if (role == kTimes) {
+            track.addTime(v);
+        } else if (f.array && f.count < 2) {
+            f.nums[f.count++] = v;
+        } else if (f.array) {
+            f.count++;
+        }
+    }
+
+    State              m_state = kValue;
+    bool               m_escape = false, m_isKey = false, m_keep = false;
+    std::string        m_token;
+    std::vector<Frame> m_frames;
+};
+
+// ═══════════════════════════════════════════════════════════════════
+// Route
+// ═══════════════════════════════════════════════════════════════════
+
+// Time the track's points: from their own times when every point has one, else at
+// `speed` m/s along the track (0: no fallback). Points that do not move time
+// forward by at least 1 ms are dropped and counted. False with `err` set if the
+// track cannot make a route.
+inline bool buildRoute(const Track& track, double speed, std::vector<RoutePoint>* out, size_t* dropped,
+                       std::string* err) {
+    out->clear();
+    *dropped = 0;
+    if (track.tooLong) {
+        *err = "more than " + std::to_string(track.limit) + " points";
+        return false;
+    }
+    if (track.points.empty()) {
+        *err = "no track points";
+        return false;
+    }
+    bool timed = track.times.size() == track.points.size() &&
+                 std::all_of(track.times.begin(), track.times.end(), [](double t) { return std::isfinite(t); });
+    if (!timed && !(speed > 0)) {
+        *err = "not every point has a time; give --speed";
+        return false;
+    }
+
+    out->reserve(track.points.size());
+    double elapsedMs = 0;
+    for (size_t i = 0; i < track.points.size(); i++) {
+        RoutePoint p = track.points[i];
+        if (timed) {
+            elapsedMs = (track.times[i] - track.times[0]) * 1000.0;
+        } else if (i) {
+            const RoutePoint& a = track.points[i - 1];
+            double meters, bearing;
+            routeLeg(a.latE7 * 1e-7, a.lngE7 * 1e-7, p.latE7 * 1e-7, p.lngE7 * 1e-7, &meters, &bearing);
+            elapsedMs += meters * 1000.0 / speed;
+        }
+        double ms = std::round(elapsedMs);
+        if (ms < 0 || ms > UINT32_MAX || (!out->empty() && ms <= out->back().timeMs)) {
+            (*dropped)++;
+            continue;
+        }
+        p.timeMs = (uint32_t)ms;
+        out->push_back(p);
+    }
+    return true;
+}
@@ -0,0 +1,49 @@
+// MockGPS host tool - resolve symbols with the module's ELF resolver
+//
+//   elf_lookup <library> <symbol>...
+//
+// <library> is a path or file name; it is dlopen'ed if not already loaded, then
+// looked up by file name exactly like the module finds libart.so. Each symbol is
+// printed with the resolver's address and, where the dynamic linker can see it,
+// dlsym's address for comparison. Exits non-zero if any symbol is missing or the
+// two disagree.
+
+#include <dlfcn.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include "elf_resolver.hpp"
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <library> <symbol>...\n", argv[0]);
+        return 2;
+    }
+
+    void* handle = dlopen(argv[1], RTLD_NOW);
+    if (!handle) {
+        fprintf(stderr, "dlopen %s: %s\n", argv[1], dlerror());
+        return 1;
+    }
+
+    const char* slash = strrchr(argv[1], '/');
+    elf::Image image(slash ? slash + 1 : argv[1]);
+    if (!image.valid()) {
+        fprintf(stderr, "%s: not found in loaded images\n", argv[1]);
+        return 1;
+    }
+    printf("%s bias=%#lx\n", image.path().c_str(), (unsigned long)image.bias());
+
+    int failures = 0;
+    for (int i = 2; i < argc; i++) {
+        void* resolved = image.symbol(argv[i]);
+        void* linker = dlsym(handle, argv[i]);
+        const char* verdict = !resolved ? "MISSING"
+                            : !linker ? "ok (hidden from dlsym)"
+                            : resolved == linker ? "ok" : "MISMATCH";
+        if (!resolved || (linker && resolved != linker)) failures++;
+        printf("  %-40s %18p  dlsym=%-18p %s\n", argv[i], resolved, linker, verdict);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,24 @@
+#!/bin/sh
+# Strip a shared library the way Android's build does and embed its function
+# symbols as an xz-compressed .gnu_debugdata section (MiniDebugInfo).
+#
+#   make_minidebuginfo.sh <input.so> <output.so>
+set -e
+
+in="$1"
+out="$2"
+tmp="$out.tmp"
+mkdir -p "$tmp"
+
+nm -D "$in" --format=posix --defined-only | awk '{ print $1 }' | sort > "$tmp/dynsyms"
+nm "$in" --format=posix --defined-only | awk '$2 == "T" || $2 == "t" { print $1 }' | sort > "$tmp/funcsyms"
+comm -13 "$tmp/dynsyms" "$tmp/funcsyms" > "$tmp/keep_symbols"
+
+objcopy --only-keep-debug "$in" "$tmp/debug"
+objcopy -S --remove-section .gdb_index --remove-section .comment \
+    --keep-symbols="$tmp/keep_symbols" "$tmp/debug" "$tmp/mini_debuginfo"
+xz -f "$tmp/mini_debuginfo"
+
+strip --strip-all -R .comment -o "$out" "$in"
+objcopy --add-section .gnu_debugdata="$tmp/mini_debuginfo.xz" "$out"
+rm -rf "$tmp"
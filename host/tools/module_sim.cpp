@@ -0,0 +1,292 @@
+// module_sim - run one simulated app process through the module on host
+//
+// Writes location.conf into MOCKGPS_MODULE_DIR, loads the module through fakezygisk
+// and specializes an app against the in-process companion. Then calls the hooked
+// methods the way app code would (ART-style dispatch on the fake ArtMethods) and
+// rewrites the config to check that hooks follow it live: first the text file (read
+// while no location.bin exists), then location.bin, then a corrupted location.bin
+// that must be ignored, an override mask that leaves some getters unhooked, a reload
+// requested over the control socket the way mockgpsctl does, and a route.bin played
+// through the getters. The hook telemetry, phase timings and trace sections of this
+// process are then read back, a hook call trace recorded, and its buffered log lines
+// flushed on request. Last,
+// per-app profiles: other processes ask the companion for their config by name and
+// uid, and one without an active profile must unload. Then isolated, app zygote, SDK
+// sandbox and system processes, which unload without IPC.
+//
+//   module_sim              exit status 0 when every check passes
+//   MOCKGPS_HOST_LOG=1 module_sim   also print the module's log
+
+#include <cstdio>
+#include <ctime>
+#include <thread>
+
+#include "fake_jni.hpp"
+#include "fake_zygisk.hpp"
+#include "module.cpp"
+#include "companion_client.hpp"
+
+namespace {
+
+int g_failures = 0;
+
+void check(bool ok, const char* what) {
+    printf("%s  %s\n", ok ? "ok  " : "FAIL", what);
+    if (!ok) g_failures++;
+}
+
+// Replace the config the way the UI should: temp file + rename
+bool writeConfig(const char* text) {
+    char tmp[PATH_MAX];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", CONFIG_PATH);
+    FILE* f = fopen(tmp, "w");
+    if (!f) return false;
+    fputs(text, f);
+    fclose(f);
+    return rename(tmp, CONFIG_PATH) == 0;
+}
+
+double nowMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// Poll getLatitude() for up to `ms`; true once it returns `want`
+bool waitLatitude(fakejni::Object* loc, double want, double ms) {
+    double start = nowMs();
+    while (nowMs() - start < ms) {
+        if (fakejni::callVirtual(loc, "getLatitude", "()D").d == want) return true;
+    }
+    return false;
+}
+
+jint settingsGetInt(const char* cls, const char* key, jint def) {
+    JNIEnv* env = fakejni::env();
+    jclass clazz = env->FindClass(cls);
+    jmethodID mid = env->GetStaticMethodID(clazz, "getInt",
+                                           "(Landroid/content/ContentResolver;Ljava/lang/String;I)I");
+    jvalue args[3] = {};
+    args[1].l = fakejni::newString(key);
+    args[2].i = def;
+    return fakejni::invoke(mid, clazz, args).i;
+}
+
+// The config packet the companion sends a process with this name and uid
+ConfigPacket companionPacket(const char* name, int32_t uid) {
+    ConfigPacket pkt = {};
+    int pageFd = -1;
+    int fd = fakezygisk::connectCompanion();
+    if (companionRequest(fd, runtimeKey(fakejni::env()), name, uid)) recvWithFd(fd, &pkt, sizeof(pkt), &pageFd);
+    if (pageFd >= 0) close(pageFd);
+    close(fd);
+    return pkt;
+}
+
+} // namespace
+
+int main() {
+    unlink(CONFIG_BIN_PATH);
+    if (!writeConfig("enabled=1\nlat=10.7769\nlng=106.7009\nhidedev=1\n")) {
+        fprintf(stderr, "cannot write %s\n", CONFIG_PATH);
+        return 2;
+    }
+    fakejni::putSetting("Secure", "mock_location", 1);
+    fakejni::putSetting("Secure", "screen_off_timeout", 30000);
+
+    auto* loc = fakejni::newObject(fakejni::locationClass());
+    fakejni::setField(loc, "mLatitudeDegrees", 48.8584);
+    fakejni::setField(loc, "mLongitudeDegrees", 2.2945);
+
+    fakezygisk::Loader loader(fakejni::env());
+    fakezygisk::AppArgs args;
+    double start = nowMs();
+    loader.specializeApp(args);
+    printf("specialize: %.3f ms, %ld companion connection(s)\n", nowMs() - start,
+           loader.companionConnections());
+
+    check(!loader.dlclosed(), "module stays loaded while spoofing is on");
+    check(fakejni::callVirtual(loc, "getLatitude", "()D").d == 10.7769, "getLatitude() spoofed");
+    check(fakejni::callVirtual(loc, "getLongitude", "()D").d == 106.7009, "getLongitude() spoofed");
+    check(!fakejni::callVirtual(loc, "isFromMockProvider", "()Z").z, "isFromMockProvider() hidden");
+    check(settingsGetInt("android/provider/Settings$Secure", "mock_location", -1) == 0,
+          "Secure.getInt(mock_location) hidden");
+    check(settingsGetInt("android/provider/Settings$Secure", "screen_off_timeout", -1) == 30000,
+          "Secure.getInt(other key) reaches the original");
+
+    writeConfig("enabled=0\nlat=10.7769\nlng=106.7009\nhidedev=1\n");
+    start = nowMs();
+    bool restored = false;
+    while (!restored && nowMs() - start < 1000) {
+        restored = fakejni::callVirtual(loc, "getLatitude", "()D").d == 48.8584 &&
+                   !__atomic_load_n(&g_hooks[kHookGetLatitude].installed, __ATOMIC_ACQUIRE);
+    }
+    printf("config off -> hooks removed: %.3f ms\n", nowMs() - start);
+    check(restored, "getLatitude() back on the original after enabled=0");
+    check(fakejni::callVirtual(loc, "isFromMockProvider", "()Z").z, "isFromMockProvider() original");
+
+    MockConfig cfg = parseConfig("enabled=1\nlat=1.5\nlng=2.5\nhidedev=1\n");
+    writeConfigFileAtomic(CONFIG_BIN_PATH, cfg);
+    check(waitLatitude(loc, 1.5, 1000), "location.bin takes over from location.conf");
+
+    // A torn write in place of the rename: rejected, last good config stays
+    ConfigSet torn;
+    torn.defaults = parseConfig("enabled=1\nlat=7.5\nlng=2.5\nhidedev=1\n");
+    std::vector<uint8_t> rec = encodeConfigFile(torn);
+    FILE* f = fopen(CONFIG_BIN_PATH, "w");
+    fwrite(rec.data(), 1, rec.size() / 2, f);
+    fclose(f);
+    check(!waitLatitude(loc, 7.5, 100) && waitLatitude(loc, 1.5, 1), "partial location.bin ignored");
+
+    // Only lat/lng overridden: the other getters go back to their compiled code
+    fakejni::setField(loc, "mAltitudeMeters", 35.0);
+    ConfigSet partial;
+    parseConfigSet("enabled=1\nlat=1.5\nlng=2.5\naltitude=99\nhidedev=1\noverride=lat,lng\n", &partial);
+    writeConfigFileAtomic(CONFIG_BIN_PATH, partial);
+    start = nowMs();
+    while (__atomic_load_n(&g_hooks[kHookGetAltitude].installed, __ATOMIC_ACQUIRE) && nowMs() - start < 1000) {}
+    check(!g_hooks[kHookGetAltitude].installed && !g_hooks[kHookGetTime].installed &&
+          fakejni::callVirtual(loc, "getAltitude", "()D").d == 35.0, "getAltitude() unhooked when not overridden");
+    check(g_hooks[kHookGetLatitude].installed && waitLatitude(loc, 1.5, 1), "getLatitude() still spoofed");
+
+    partial.defaults.overrides = kAllLocationFields;
+    writeConfigFileAtomic(CONFIG_BIN_PATH, partial);
+    start = nowMs();
+    bool rehooked = false;
+    while (!rehooked && nowMs() - start < 1000) rehooked = fakejni::callVirtual(loc, "getAltitude", "()D").d == 99.0;
+    check(rehooked, "getAltitude() hooked again when the mask grows");
+
+    // What mockgpsctl does: write, then have the companion publish before returning
+    partial.defaults.lat = 4.5;
+    writeConfigFileAtomic(CONFIG_BIN_PATH, partial);
+    uint32_t woken = 0;
+    check(requestReload(&woken) && fakejni::callVirtual(loc, "getLatitude", "()D").d == 4.5,
+          "companion reload request publishes before it replies");
+
+    // A straight route from 0,0 to 1,2 over 1000 s: ~248.6 km at ~63.4 degrees
+    std::vector<RoutePoint> points = {{0, 0, 0}, {1000000, 10000000, 20000000}};
+    partial.defaults.route = true;
+    writeFileAtomic(ROUTE_PATH, encodeRoute(points));
+    writeConfigFileAtomic(CONFIG_BIN_PATH, partial);
+    requestReload(&woken);
+    double lat = fakejni::callVirtual(loc, "getLatitude", "()D").d;
+    double lng = fakejni::callVirtual(loc, "getLongitude", "()D").d;
+    float speed = fakejni::callVirtual(loc, "getSpeed", "()F").f;
+    float bearing = fakejni::callVirtual(loc, "getBearing", "()F").f;
+    check(lat >= 0 && lat < 0.01 && std::fabs(lng - 2 * lat) < 1e-12, "route position: lat and lng from one instant");
+    check(std::fabs(speed - 248.6f) < 0.5f && std::fabs(bearing - 63.4f) < 0.5f, "route speed and bearing");
+    unlink(ROUTE_PATH);
+    check(requestReload(&woken) && fakejni::callVirtual(loc, "getLatitude", "()D").d == 4.5,
+          "removing route.bin goes back to the static position");
+
+    // This process has no nice name, so its calls are counted under its uid
+    std::vector<StatsRecord> records;
+    const StatsRecord* own = nullptr;
+    if (fetchStats(&records)) {
+        for (const auto& r : records) {
+            if (!strcmp(r.key, "uid:10123")) own = &r;
+        }
+    }
+    if (MOCKGPS_TELEMETRY) {
+        check(own && own->processes == 1 && own->hooks[kHookGetLatitude].calls > 0 &&
+                  own->hooks[kHookGetLatitude].sampled > 0,
+              "stats socket reports this process's hook calls");
+        // First child of this zygote: it ran detection, so no cache adoption
+        bool phases = own != nullptr;
+        for (int i = 0; phases && i < kStatsPhaseCount; i++) {
+            phases = own->phases[i].count == (i == kPhaseCacheAdopt ? 0u : 1u);
+        }
+        check(phases, "every specialize phase timed once, the companion wait included");
+        auto sections = fakejni::traceSections();
+        check(sections.size() >= 8 && sections.front() == "MockGPS preAppSpecialize" &&
+                  sections[1] == "MockGPS companion wait" && fakejni::openTraceSections() == 0,
+              "specialize phases traced as ATrace sections");
+        if (own) printStats(stdout, *own);
+
+        // Every call sampled while a trace runs, drained by the controller thread
+        std::vector<char> trace;
+        bool started = startTrace(1);
+        start = nowMs();
+        while (started && !traceEnabled() && nowMs() - start < 1000) {}
+        for (int i = 0; i < 10; i++) fakejni::callVirtual(loc, "getLatitude", "()D");
+        // More short-lived threads than rings: each gives its ring back on exit
+        for (uint32_t i = 0; i < kTraceRings + 8; i++) {
+            std::thread([loc] { fakejni::callVirtual(loc, "getLatitude", "()D"); }).join();
+        }
+        bool stopped = started && stopTrace(&trace);
+        uint32_t traced = 0, dropped = 0;
+        if (stopped) {
+            const char* at = trace.data() + sizeof(TraceFileHeader);
+            const char* end = trace.data() + trace.size();
+            while (at + sizeof(TracePackage) <= end) {
+                TracePackage pkg;
+                memcpy(&pkg, at, sizeof(pkg));
+                at += sizeof(pkg);
+                if (!strcmp(pkg.key, "uid:10123")) dropped += pkg.dropped;
+                for (uint32_t i = 0; i < pkg.events && at + sizeof(TraceEvent) <= end; i++, at += sizeof(TraceEvent)) {
+                    TraceEvent e;
+                    memcpy(&e, at, sizeof(e));
+                    if (!strcmp(pkg.key, "uid:10123") && e.pid == (uint32_t)getpid() &&
+                        traceHook(e) == kHookGetLatitude) {
+                        traced++;
+                    }
+                }
+            }
+        }
+        printf("hook trace: %zu bytes, %u getLatitude() event(s), %u dropped\n", trace.size(), traced, dropped);
+        check(stopped && traced >= 10 + kTraceRings + 8 && !dropped && !traceEnabled(),
+              "hook call trace records every sampled call, across thread churn");
+    }
+
+    // Buffered info lines (hook updates above) reach logcat only when asked for
+    long logged = fakejni::loggedLines();
+    uint32_t pages = 0;
+    bool flushed = flushLogs(&pages) && pages > 0;
+    start = nowMs();
+    while (flushed && fakejni::loggedLines() == logged && nowMs() - start < 1000) {}
+    check(flushed && fakejni::loggedLines() > logged, "mockgpsconf logs flushes the log ring");
+
+    // Spoofing only for one package and one app id; this process has neither
+    ConfigSet profiles;
+    parseConfigSet("enabled=0\nhidedev=0\nlat=1.5\n"
+                   "[com.example.app]\nenabled=1\nlat=3.5\n"
+                   "[uid:10200]\nhidedev=1\n", &profiles);
+    writeConfigFileAtomic(CONFIG_BIN_PATH, profiles);
+    check(waitLatitude(loc, 48.8584, 1000), "process without a profile follows the defaults");
+
+    ConfigPacket pkt = companionPacket("com.example.app:remote", 10123);
+    check(pkt.enabled && pkt.lat == 3.5, "com.example.app:remote gets the com.example.app profile");
+    pkt = companionPacket("com.other.app", 10123);
+    check(!pkt.enabled && !pkt.hideDev && pkt.lat == 1.5, "com.other.app gets the defaults");
+    pkt = companionPacket("com.other.app", 1010200);
+    check(!pkt.enabled && pkt.hideDev, "uid 1010200 gets the uid:10200 profile");
+
+    fakezygisk::Loader other(fakejni::env());
+    fakezygisk::AppArgs otherArgs;
+    otherArgs.niceName = fakejni::newString("com.other.app");
+    other.preAppSpecialize(otherArgs);
+    check(other.dlclosed(), "process without an active profile unloads in preAppSpecialize");
+
+    // Processes that can never be hooked unload before contacting the companion
+    struct { jint uid; bool childZygote; ProcessClass cls; const char* what; } skipped[] = {
+        { 1099012, false, kClassIsolated,   "isolated process unloads without IPC" },
+        { 10123,   true,  kClassAppZygote,  "app zygote unloads without IPC" },
+        { 20123,   false, kClassSdkSandbox, "SDK sandbox unloads without IPC" },
+        { 1001,    false, kClassSystem,     "system UID unloads without IPC" },
+    };
+    for (const auto& s : skipped) {
+        fakezygisk::AppArgs a;
+        a.uid = s.uid;
+        a.isChildZygote = s.childZygote ? JNI_TRUE : JNI_FALSE;
+        long connections = other.companionConnections();
+        uint32_t count = g_processClassCounts[s.cls].load();
+        other.preAppSpecialize(a);
+        check(other.dlclosed() && other.companionConnections() == connections &&
+              g_processClassCounts[s.cls].load() == count + 1, s.what);
+    }
+    for (int i = 0; i < kProcessClassCount; i++) {
+        printf("%s processes: %u\n", kProcessClassNames[i], g_processClassCounts[i].load());
+    }
+
+    return g_failures ? 1 : 0;
+}
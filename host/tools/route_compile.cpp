@@ -0,0 +1,143 @@
+// MockGPS host tool - compile a GPX, KML or GeoJSON track into route.bin
+//
+//   route_compile [--speed M/S] [--format gpx|kml|geojson] <in> <out>
+//
+// Streams <in> through the readers in route_import.hpp, 1 MiB at a time, so a
+// multi-hour track in a file of any size compiles in memory bounded by its points.
+// The format comes from the extension, or from the first bytes when that does not
+// say. Points with times keep them; a track without a time on every point plays at
+// --speed. Writes <out> atomically (copy it to the module directory, or run with
+// <out> there) and prints what was read and how much smaller the route is.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "route_import.hpp"
+
+namespace {
+
+constexpr size_t kChunk = 1u << 20;
+
+enum class Format { kUnknown, kGpx, kKml, kGeoJson };
+
+Format parseFormat(const char* s) {
+    if (!strcasecmp(s, "gpx")) return Format::kGpx;
+    if (!strcasecmp(s, "kml")) return Format::kKml;
+    if (!strcasecmp(s, "geojson") || !strcasecmp(s, "json")) return Format::kGeoJson;
+    return Format::kUnknown;
+}
+
+Format formatOf(const char* path, const char* head, size_t n) {
+    const char* dot = strrchr(path, '.');
+    Format f = dot ? parseFormat(dot + 1) : Format::kUnknown;
+    if (f != Format::kUnknown) return f;
+    std::string_view s(head, n);
+    size_t at = s.find_first_not_of(" \t\r\n\xef\xbb\xbf");
+    if (at != std::string_view::npos && (s[at] == '{' || s[at] == '[')) return Format::kGeoJson;
+    if (s.find("<gpx") != std::string_view::npos) return Format::kGpx;
+    if (s.find("<kml") != std::string_view::npos) return Format::kKml;
+    return Format::kUnknown;
+}
+
+std::unique_ptr<TrackReader> readerFor(Format f) {
+    switch (f) {
+    case Format::kGpx:     return std::make_unique<GpxReader>();
+    case Format::kKml:     return std::make_unique<KmlReader>();
+    case Format::kGeoJson: return std::make_unique<GeoJsonReader>();
+    case Format::kUnknown: break;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double speed = 0;
+    Format format = Format::kUnknown;
+    bool usage = false;
+    int arg = 1;
+    for (; arg + 1 < argc && !strncmp(argv[arg], "--", 2) && !usage; arg += 2) {
+        if (!strcmp(argv[arg], "--speed")) {
+            speed = atof(argv[arg + 1]);
+            usage = !(speed > 0);
+        } else if (!strcmp(argv[arg], "--format")) {
+            format = parseFormat(argv[arg + 1]);
+            usage = format == Format::kUnknown;
+        } else {
+            usage = true;
+        }
+    }
+    if (usage || argc - arg != 2) {
+        fprintf(stderr, "usage: %s [--speed M/S] [--format gpx|kml|geojson] <in> <out>\n", argv[0]);
+        return 2;
+    }
+    const char* in = argv[arg];
+    const char* out = argv[arg + 1];
+
+    FILE* f = strcmp(in, "-") ? fopen(in, "rb") : stdin;
+    if (!f) {
+        perror(in);
+        return 2;
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::vector<char> chunk(kChunk);
+    std::unique_ptr<TrackReader> reader;
+    size_t inBytes = 0, n;
+    while ((n = fread(chunk.data(), 1, chunk.size(), f)) > 0) {
+        if (!reader) {
+            reader = readerFor(format != Format::kUnknown ? format : formatOf(in, chunk.data(), n));
+            if (!reader) {
+                if (f != stdin) fclose(f);
+                fprintf(stderr, "%s: not GPX, KML or GeoJSON; give --format\n", in);
+                return 1;
+            }
+        }
+        inBytes += n;
+        if (!reader->feed(chunk.data(), n)) break;
+    }
+    bool readFailed = ferror(f);
+    if (f != stdin) fclose(f);
+    if (readFailed) {
+        fprintf(stderr, "%s: read failed\n", in);
+        return 2;
+    }
+    if (!reader) {
+        fprintf(stderr, "%s: empty\n", in);
+        return 1;
+    }
+    if (!reader->finish()) {
+        fprintf(stderr, "%s: %s after %zu bytes\n", in, reader->error.c_str(), inBytes);
+        return 1;
+    }
+
+    std::vector<RoutePoint> points;
+    size_t dropped;
+    std::string err;
+    if (!buildRoute(reader->track, speed, &points, &dropped, &err)) {
+        fprintf(stderr, "%s: %s\n", in, err.c_str());
+        return 1;
+    }
+    std::vector<uint8_t> image = encodeRoute(points);
+    if (image.empty()) {
+        fprintf(stderr, "%s: too many points for route.bin (%zu MiB at most)\n", in, kRouteImageMax >> 20);
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!writeFileAtomic(out, image)) {
+        perror(out);
+        return 2;
+    }
+
+    RouteFileHeader head;
+    memcpy(&head, image.data(), sizeof(head));
+    printf("%zu points read, %zu dropped (time not increasing)\n", reader->track.points.size(), dropped);
+    printf("%u points, %.1f s, %.3f km\n", head.points, head.durationMs / 1e3, head.distanceDm / 1e4);
+    printf("%zu -> %zu bytes (%.1fx smaller), %.1f MB/s\n", inBytes, image.size(),
+           (double)inBytes / image.size(), inBytes / 1e6 / seconds);
+    printf("written to %s\n", out);
+    return 0;
+}
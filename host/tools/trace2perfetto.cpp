@@ -0,0 +1,209 @@
+// MockGPS host tool - convert a hook call trace to the Perfetto trace format
+//
+//   trace2perfetto <trace> [<out.perfetto-trace>]
+//
+// <trace> is what `mockgpsconf trace stop` wrote. Prints per package the sampled
+// calls of each hook and each thread; with <out> also writes a Perfetto trace
+// (open it in ui.perfetto.dev) with a process track per traced process, named after
+// its package, a thread track per thread, and one instant event per sampled call.
+// The protobuf is encoded here; the few fields used are listed below.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "trace.hpp"
+
+namespace {
+
+// perfetto/trace/trace.proto and the TracePacket, TrackDescriptor, TrackEvent protos
+enum : uint32_t {
+    kTracePacket = 1,                  // Trace.packet
+    kPacketTimestamp = 8,
+    kPacketSequenceId = 10,            // trusted_packet_sequence_id
+    kPacketTrackEvent = 11,
+    kPacketTrackDescriptor = 60,
+    kTrackUuid = 1,                    // TrackDescriptor
+    kTrackProcess = 3,
+    kTrackThread = 4,
+    kTrackParentUuid = 5,
+    kProcessPid = 1,                   // ProcessDescriptor
+    kProcessName = 6,
+    kThreadPid = 1,                    // ThreadDescriptor
+    kThreadTid = 2,
+    kEventType = 9,                    // TrackEvent
+    kEventTrackUuid = 11,
+    kEventCategories = 22,
+    kEventName = 23,
+    kEventTypeInstant = 3,
+};
+
+constexpr uint32_t kSequenceId = 1;
+
+class Proto {
+public:
+    void varint(uint32_t field, uint64_t v) {
+        key(field, 0);
+        put(v);
+    }
+
+    void bytes(uint32_t field, const void* data, size_t len) {
+        key(field, 2);
+        put(len);
+        buf_.insert(buf_.end(), (const char*)data, (const char*)data + len);
+    }
+
+    void string(uint32_t field, const std::string& s) { bytes(field, s.data(), s.size()); }
+    void message(uint32_t field, const Proto& m) { bytes(field, m.buf_.data(), m.buf_.size()); }
+
+    const std::vector<char>& data() const { return buf_; }
+
+private:
+    void key(uint32_t field, uint32_t wireType) { put((uint64_t)field << 3 | wireType); }
+
+    void put(uint64_t v) {
+        while (v >= 0x80) {
+            buf_.push_back((char)(v | 0x80));
+            v >>= 7;
+        }
+        buf_.push_back((char)v);
+    }
+
+    std::vector<char> buf_;
+};
+
+struct Package {
+    std::string             key;
+    uint32_t                dropped;
+    std::vector<TraceEvent> events;
+};
+
+bool readTrace(const char* path, TraceFileHeader* header, std::vector<Package>* out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    bool ok = fread(header, sizeof(*header), 1, f) == 1 && header->magic == kTraceMagic &&
+              header->version == kTraceVersion;
+    for (uint32_t i = 0; ok && i < header->packages; i++) {
+        TracePackage pkg;
+        ok = fread(&pkg, sizeof(pkg), 1, f) == 1 && pkg.events <= kTraceBufferEvents;
+        if (!ok) break;
+        pkg.key[sizeof(pkg.key) - 1] = 0;
+        Package p{pkg.key, pkg.dropped, std::vector<TraceEvent>(pkg.events)};
+        ok = !pkg.events || fread(p.events.data(), sizeof(TraceEvent), pkg.events, f) == pkg.events;
+        for (const auto& e : p.events) ok = ok && traceHook(e) < kStatsHookCount;
+        out->push_back(std::move(p));
+    }
+    fclose(f);
+    if (!ok) fprintf(stderr, "%s: not a MockGPS trace, or truncated\n", path);
+    return ok;
+}
+
+void printSummary(const TraceFileHeader& header, const std::vector<Package>& packages) {
+    printf("%.3f s, 1 in %u calls per thread, %u package(s)\n", (header.stopNs - header.startNs) / 1e9,
+           header.every, header.packages);
+    for (const auto& p : packages) {
+        printf("%s  events=%zu  dropped=%u\n", p.key.c_str(), p.events.size(), p.dropped);
+        uint64_t hooks[kStatsHookCount] = {};
+        std::map<std::pair<uint32_t, uint32_t>, uint64_t> threads;
+        for (const auto& e : p.events) {
+            hooks[traceHook(e)]++;
+            threads[{e.pid, traceTid(e)}]++;
+        }
+        for (int i = 0; i < kStatsHookCount; i++) {
+            if (hooks[i]) printf("  %-26s %10llu\n", kStatsHookNames[i], (unsigned long long)hooks[i]);
+        }
+        for (const auto& t : threads) {
+            printf("  pid %-7u tid %-7u %14llu\n", t.first.first, t.first.second, (unsigned long long)t.second);
+        }
+    }
+}
+
+// Track uuids: a process's is its pid, a thread's sets the pid in the high half
+uint64_t threadUuid(uint32_t pid, uint32_t tid) { return (uint64_t)pid << 32 | tid; }
+
+void appendPacket(std::vector<char>* out, const Proto& packet) {
+    Proto trace;
+    trace.message(kTracePacket, packet);
+    out->insert(out->end(), trace.data().begin(), trace.data().end());
+}
+
+std::vector<char> toPerfetto(const std::vector<Package>& packages) {
+    std::vector<char> out;
+    std::map<uint32_t, std::string> processes;
+    std::map<std::pair<uint32_t, uint32_t>, bool> threads;
+    std::vector<TraceEvent> events;
+    for (const auto& p : packages) {
+        for (const auto& e : p.events) {
+            processes.emplace(e.pid, p.key);
+            threads[{e.pid, traceTid(e)}] = true;
+            events.push_back(e);
+        }
+    }
+
+    for (const auto& p : processes) {
+        Proto process, track, packet;
+        process.varint(kProcessPid, p.first);
+        process.string(kProcessName, p.second);
+        track.varint(kTrackUuid, p.first);
+        track.message(kTrackProcess, process);
+        packet.varint(kPacketSequenceId, kSequenceId);
+        packet.message(kPacketTrackDescriptor, track);
+        appendPacket(&out, packet);
+    }
+    for (const auto& t : threads) {
+        Proto thread, track, packet;
+        thread.varint(kThreadPid, t.first.first);
+        thread.varint(kThreadTid, t.first.second);
+        track.varint(kTrackUuid, threadUuid(t.first.first, t.first.second));
+        track.varint(kTrackParentUuid, t.first.first);
+        track.message(kTrackThread, thread);
+        packet.varint(kPacketSequenceId, kSequenceId);
+        packet.message(kPacketTrackDescriptor, track);
+        appendPacket(&out, packet);
+    }
+
+    std::sort(events.begin(), events.end(),
+              [](const TraceEvent& a, const TraceEvent& b) { return a.timeNs < b.timeNs; });
+    for (const auto& e : events) {
+        Proto event, packet;
+        event.varint(kEventType, kEventTypeInstant);
+        event.varint(kEventTrackUuid, threadUuid(e.pid, traceTid(e)));
+        event.string(kEventCategories, "mockgps");
+        event.string(kEventName, kStatsHookNames[traceHook(e)]);
+        packet.varint(kPacketTimestamp, e.timeNs);
+        packet.varint(kPacketSequenceId, kSequenceId);
+        packet.message(kPacketTrackEvent, event);
+        appendPacket(&out, packet);
+    }
+    return out;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "usage: %s <trace> [<out.perfetto-trace>]\n", argv[0]);
+        return 2;
+    }
+
+    TraceFileHeader header;
+    std::vector<Package> packages;
+    if (!readTrace(argv[1], &header, &packages)) return 1;
+    printSummary(header, packages);
+    if (argc == 2) return 0;
+
+    std::vector<char> trace = toPerfetto(packages);
+    FILE* f = fopen(argv[2], "wb");
+    if (!f || fwrite(trace.data(), 1, trace.size(), f) != trace.size() || fclose(f) != 0) {
+        perror(argv[2]);
+        return 1;
+    }
+    printf("%zu bytes written to %s\n", trace.size(), argv[2]);
+    return 0;
+}
@@ -0,0 +1,136 @@
+// MockGPS - Logging
+//
+// MOCKGPS_LOG_LEVEL (an android_LogPriority) is the lowest level compiled in: the
+// LOGD/LOGI calls below it disappear with their format strings. It defaults to
+// ANDROID_LOG_INFO in release builds (NDEBUG) and ANDROID_LOG_DEBUG otherwise.
+//
+// LOGD and LOGI do not talk to logd. They format into a per-process ring of the last
+// kLogRingEntries lines, which any thread appends to without locks, overwriting the
+// oldest. The ring reaches logcat only when flushed: by every LOGE (the buffered
+// lines first, then the error itself, written directly) and on demand through
+// `mockgpsconf logs`. A process that never fails never writes a log line.
+
+#pragma once
+
+#include <android/log.h>
+#include <atomic>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#ifndef LOG_TAG
+#define LOG_TAG "MockGPS"
+#endif
+
+#ifndef MOCKGPS_LOG_LEVEL
+#ifdef NDEBUG
+#define MOCKGPS_LOG_LEVEL ANDROID_LOG_INFO
+#else
+#define MOCKGPS_LOG_LEVEL ANDROID_LOG_DEBUG
+#endif
+#endif
+
+static constexpr uint32_t kLogRingEntries = 64;    // power of two
+static constexpr size_t   kLogLineMax     = 112;   // bytes per line, NUL included
+
+// One line. `seq` is a per-entry seqlock: 2 * position + 1 while it is written,
+// 2 * position + 2 once complete, so a flush skips lines that are torn or were
+// overwritten by a later lap. Fields are atomics for the same reason
+// ConfigSnapshot's words are.
+struct LogEntry {
+    using Word = uint64_t;
+    static constexpr size_t kWords = kLogLineMax / sizeof(Word);
+
+    std::atomic<uint64_t> seq;
+    std::atomic<uint64_t> timeNs;   // CLOCK_MONOTONIC
+    std::atomic<int32_t>  tid;
+    std::atomic<int32_t>  level;
+    std::atomic<Word>     text[kWords];
+};
+
+struct LogRing {
+    std::atomic<uint64_t> head{0};      // next position to write
+    std::atomic<uint64_t> flushed{0};   // first position not yet flushed
+    std::atomic_flag      flushing = ATOMIC_FLAG_INIT;
+    LogEntry              entries[kLogRingEntries];
+};
+
+inline LogRing& logRing() {
+    static LogRing ring;
+    return ring;
+}
+
+__attribute__((format(printf, 2, 3))) inline void logBuffered(int level, const char* fmt, ...) {
+    LogEntry::Word buf[LogEntry::kWords] = {};
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf((char*)buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+
+    LogRing& ring = logRing();
+    uint64_t pos = ring.head.fetch_add(1, std::memory_order_relaxed);
+    LogEntry& e = ring.entries[pos & (kLogRingEntries - 1)];
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    e.seq.store(2 * pos + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    e.timeNs.store((uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec, std::memory_order_relaxed);
+    e.tid.store((int32_t)syscall(SYS_gettid), std::memory_order_relaxed);
+    e.level.store(level, std::memory_order_relaxed);
+    for (size_t i = 0; i < LogEntry::kWords; i++) e.text[i].store(buf[i], std::memory_order_relaxed);
+    e.seq.store(2 * pos + 2, std::memory_order_release);
+}
+
+// Write every complete line not flushed yet to logcat, oldest first. Lines lost to
+// overwriting are reported as a count. Concurrent flushes leave it to the first.
+inline void flushLogRing() {
+    LogRing& ring = logRing();
+    if (ring.flushing.test_and_set(std::memory_order_acquire)) return;
+
+    uint64_t end = ring.head.load(std::memory_order_acquire);
+    uint64_t pos = ring.flushed.load(std::memory_order_relaxed);
+    if (end - pos > kLogRingEntries) {
+        __android_log_print(ANDROID_LOG_WARN, LOG_TAG, "log ring: %llu line(s) overwritten",
+                            (unsigned long long)(end - kLogRingEntries - pos));
+        pos = end - kLogRingEntries;
+    }
+    for (; pos < end; pos++) {
+        const LogEntry& e = ring.entries[pos & (kLogRingEntries - 1)];
+        if (e.seq.load(std::memory_order_acquire) != 2 * pos + 2) continue;
+        LogEntry::Word buf[LogEntry::kWords];
+        for (size_t i = 0; i < LogEntry::kWords; i++) buf[i] = e.text[i].load(std::memory_order_relaxed);
+        uint64_t timeNs = e.timeNs.load(std::memory_order_relaxed);
+        int tid = e.tid.load(std::memory_order_relaxed);
+        int level = e.level.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (e.seq.load(std::memory_order_relaxed) != 2 * pos + 2) continue;
+        ((char*)buf)[sizeof(buf) - 1] = 0;
+        __android_log_print(level, LOG_TAG, "[%llu.%06llu %d] %s", (unsigned long long)(timeNs / 1000000000ull),
+                            (unsigned long long)(timeNs / 1000 % 1000000), tid, (const char*)buf);
+    }
+    ring.flushed.store(end, std::memory_order_relaxed);
+    ring.flushing.clear(std::memory_order_release);
+}
+
+// A constant condition rather than an empty macro: arguments stay type-checked and
+// used, and the compiler drops the call and its strings
+#define LOGD(...)                                                                          \
+    do {                                                                                   \
+        if (MOCKGPS_LOG_LEVEL <= ANDROID_LOG_DEBUG) logBuffered(ANDROID_LOG_DEBUG, __VA_ARGS__); \
+    } while (0)
+
+#define LOGI(...)                                                                        \
+    do {                                                                                 \
+        if (MOCKGPS_LOG_LEVEL <= ANDROID_LOG_INFO) logBuffered(ANDROID_LOG_INFO, __VA_ARGS__); \
+    } while (0)
+
+#define LOGE(...)                                                     \
+    do {                                                              \
+        flushLogRing();                                               \
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__); \
+    } while (0)
@@ -0,0 +1,279 @@
+// mockgpsconf - convert between the text config and location.bin
+//
+//   mockgpsconf import [-f BIN] [TEXT|-]   parse text (stdin by default), replace BIN atomically
+//   mockgpsconf update [-f BIN] [TEXT|-]   like import, but only the keys and profiles in
+//                                          TEXT change; the rest of BIN stays
+//   mockgpsconf export [-f BIN]            print BIN as text; location.conf while BIN is missing
+//   mockgpsconf check  [-f BIN]            exit 0 when BIN passes the header check
+//   mockgpsconf route  [CSV|-]             replace route.bin atomically with the points
+//                                          in CSV: "seconds,lat,lng" lines, seconds
+//                                          increasing; configs with route=1 play it
+//   mockgpsconf stats                      per-package hook call rates and latency, from
+//                                          the running companion (root only)
+//   mockgpsconf logs                       have the companion and every hooked process
+//                                          write their buffered log lines to logcat
+//   mockgpsconf trace start [EVERY]        record one hook call in EVERY (default 1) per
+//                                          thread in every hooked process
+//   mockgpsconf trace stop FILE            end the trace and write it to FILE; convert
+//                                          with trace2perfetto
+//
+// BIN defaults to location.bin in the module directory. Exit status: 0 ok, 1 invalid
+// input or config, 2 usage or I/O error.
+
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "config_file.hpp"
+#include "route.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+
+#ifndef MOCKGPS_MODULE_DIR
+#define MOCKGPS_MODULE_DIR "/data/adb/modules/mockgps"
+#endif
+
+static const char* TEXT_PATH  = MOCKGPS_MODULE_DIR "/location.conf";
+static const char* ROUTE_PATH = MOCKGPS_MODULE_DIR "/route.bin";
+
+static int usage() {
+    fprintf(stderr,
+            "usage: mockgpsconf import [-f BIN] [TEXT|-]\n"
+            "       mockgpsconf update [-f BIN] [TEXT|-]\n"
+            "       mockgpsconf export [-f BIN]\n"
+            "       mockgpsconf check  [-f BIN]\n"
+            "       mockgpsconf route  [CSV|-]\n"
+            "       mockgpsconf stats\n"
+            "       mockgpsconf logs\n"
+            "       mockgpsconf trace start [EVERY]\n"
+            "       mockgpsconf trace stop FILE\n");
+    return 2;
+}
+
+static bool readAll(FILE* f, std::string* out) {
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out->append(buf, n);
+    return !ferror(f);
+}
+
+// Current config: BIN, else location.conf, as the companion reads them
+static int loadCurrent(const char* bin, ConfigSet* set) {
+    if (loadCurrentConfig(bin, TEXT_PATH, set) == ConfigLoad::kOk) return 0;
+    fprintf(stderr, "mockgpsconf: %s: bad header or checksum\n", bin);
+    return 1;
+}
+
+static int importText(const char* bin, const char* src, bool merge) {
+    ConfigSet set;
+    ConfigErrors errors;
+    const char* name = src;
+    if (!strcmp(src, "-")) {
+        name = "<stdin>";
+        std::string text;
+        if (!readAll(stdin, &text)) {
+            fprintf(stderr, "mockgpsconf: read stdin failed\n");
+            return 2;
+        }
+        parseConfigSet(text, &set, &errors);
+    } else if (loadConfigText(src, &set, &errors) != ConfigLoad::kOk) {
+        fprintf(stderr, "mockgpsconf: %s: %s\n", src, strerror(errno));
+        return 2;
+    }
+
+    // Nothing is written unless every key parsed
+    if (printConfigErrors(stderr, name, errors)) return 1;
+    int lock = lockConfigFile(bin);
+    if (lock < 0) {
+        fprintf(stderr, "mockgpsconf: lock %s failed: %s\n", bin, strerror(errno));
+        return 2;
+    }
+    int r = 0;
+    if (merge) {
+        ConfigSet current;
+        r = loadCurrent(bin, &current);
+        if (!r && !mergeConfigSet(&current, set)) {
+            fprintf(stderr, "mockgpsconf: more than %zu profiles\n", kMaxProfiles);
+            r = 1;
+        }
+        set = std::move(current);
+    }
+    if (!r && !writeConfigFileAtomic(bin, set)) {
+        fprintf(stderr, "mockgpsconf: write %s failed: %s\n", bin, strerror(errno));
+        r = 2;
+    }
+    close(lock);
+    return r;
+}
+
+static int exportText(const char* bin) {
+    ConfigSet set;
+    if (int r = loadCurrent(bin, &set)) return r;
+    fputs(formatConfigSet(set).c_str(), stdout);
+    return 0;
+}
+
+static int check(const char* bin) {
+    ConfigSet set;
+    ConfigLoad r = loadConfigFile(bin, &set);
+    if (r == ConfigLoad::kOk) return 0;
+    fprintf(stderr, "mockgpsconf: %s: %s\n", bin, r == ConfigLoad::kMissing ? "missing" : "bad header or checksum");
+    return 1;
+}
+
+// Times are taken relative to the first point and rounded to ms. Blank lines and
+// lines starting with '#' are skipped.
+static int importRoute(const char* src) {
+    FILE* f = strcmp(src, "-") ? fopen(src, "r") : stdin;
+    const char* name = f == stdin ? "<stdin>" : src;
+    if (!f) {
+        fprintf(stderr, "mockgpsconf: %s: %s\n", src, strerror(errno));
+        return 2;
+    }
+    std::vector<RoutePoint> points;
+    char line[256];
+    double first = 0;
+    unsigned lineNo = 0;
+    int r = 0;
+    while (!r && fgets(line, sizeof(line), f)) {
+        lineNo++;
+        const char* p = line + strspn(line, " \t");
+        if (*p == '#' || *p == '\n' || !*p) continue;
+        // Numbers as in the text config: '.' whatever the locale
+        std::string_view rest(p, strcspn(p, "\n"));
+        double v[3] = {};
+        size_t fields = 0;
+        bool ok = true;
+        while (ok) {
+            size_t comma = rest.find(',');
+            ok = fields < 3 && parseConfigReal(trimConfigField(rest.substr(0, comma)), &v[fields++]);
+            if (comma == std::string_view::npos) break;
+            rest.remove_prefix(comma + 1);
+        }
+        double t = v[0], lat = v[1], lng = v[2];
+        if (!ok || fields != 3 || !std::isfinite(t) || !(lat >= -90 && lat <= 90) || !(lng >= -180 && lng <= 180)) {
+            fprintf(stderr, "mockgpsconf: %s:%u: expected seconds,lat,lng\n", name, lineNo);
+            r = 1;
+            break;
+        }
+        if (points.empty()) first = t;
+        double ms = std::round((t - first) * 1000.0);
+        if (ms < 0 || ms > UINT32_MAX || (!points.empty() && ms <= points.back().timeMs)) {
+            fprintf(stderr, "mockgpsconf: %s:%u: time must increase by at least 1 ms\n", name, lineNo);
+            r = 1;
+            break;
+        }
+        points.push_back({(uint32_t)ms, (int32_t)std::lround(lat * 1e7), (int32_t)std::lround(lng * 1e7)});
+    }
+    if (!r && ferror(f)) {
+        fprintf(stderr, "mockgpsconf: read %s failed\n", name);
+        r = 2;
+    }
+    if (f != stdin) fclose(f);
+    if (r) return r;
+
+    std::vector<uint8_t> image = encodeRoute(points);
+    if (image.empty()) {
+        fprintf(stderr, "mockgpsconf: %s: no points, or too many for route.bin\n", name);
+        return 1;
+    }
+    if (!writeFileAtomic(ROUTE_PATH, image)) {
+        fprintf(stderr, "mockgpsconf: write %s failed: %s\n", ROUTE_PATH, strerror(errno));
+        return 2;
+    }
+    printf("%zu points, %.1f s written to %s\n", points.size(), points.back().timeMs / 1e3, ROUTE_PATH);
+    return 0;
+}
+
+static int stats() {
+    std::vector<StatsRecord> records;
+    if (!fetchStats(&records)) {
+        fprintf(stderr, "mockgpsconf: no reply from the companion on @%s\n", MOCKGPS_STATS_SOCKET);
+        return 2;
+    }
+    if (records.empty()) {
+        printf(MOCKGPS_TELEMETRY ? "no hooked processes yet\n" : "telemetry compiled out\n");
+    }
+    for (size_t i = 0; i < records.size(); i++) {
+        if (i) putchar('\n');
+        printStats(stdout, records[i]);
+    }
+    return 0;
+}
+
+static int logs() {
+    uint32_t pages;
+    if (!flushLogs(&pages)) {
+        fprintf(stderr, "mockgpsconf: no reply from the companion on @%s\n", MOCKGPS_STATS_SOCKET);
+        return 2;
+    }
+    printf("log flush requested from %u config page(s); see logcat -s MockGPS\n", pages);
+    return 0;
+}
+
+static int traceStart(const char* every) {
+    char* end = nullptr;
+    unsigned long n = every ? strtoul(every, &end, 10) : 1;
+    if (every && (*end || !n || n > UINT32_MAX)) return usage();
+    if (!startTrace((uint32_t)n)) {
+        fprintf(stderr, "mockgpsconf: no reply from the companion on @%s\n", MOCKGPS_STATS_SOCKET);
+        return 2;
+    }
+    if (!MOCKGPS_TELEMETRY) printf("telemetry compiled out, the trace will be empty\n");
+    return 0;
+}
+
+static int traceStop(const char* path) {
+    std::vector<char> trace;
+    if (!stopTrace(&trace)) {
+        fprintf(stderr, "mockgpsconf: no trace from the companion on @%s\n", MOCKGPS_STATS_SOCKET);
+        return 2;
+    }
+    FILE* f = fopen(path, "wb");
+    if (!f || fwrite(trace.data(), 1, trace.size(), f) != trace.size() || fclose(f) != 0) {
+        fprintf(stderr, "mockgpsconf: %s: %s\n", path, strerror(errno));
+        return 2;
+    }
+    TraceFileHeader header;
+    memcpy(&header, trace.data(), sizeof(header));
+    printf("%u package(s), %zu bytes written to %s\n", header.packages, trace.size(), path);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) return usage();
+    if (!strcmp(argv[1], "stats")) return argc == 2 ? stats() : usage();
+    if (!strcmp(argv[1], "logs")) return argc == 2 ? logs() : usage();
+    if (!strcmp(argv[1], "route")) return argc <= 3 ? importRoute(argc == 3 ? argv[2] : "-") : usage();
+    if (!strcmp(argv[1], "trace")) {
+        if (argc >= 3 && argc <= 4 && !strcmp(argv[2], "start")) return traceStart(argc == 4 ? argv[3] : nullptr);
+        if (argc == 4 && !strcmp(argv[2], "stop")) return traceStop(argv[3]);
+        return usage();
+    }
+    const char* cmd = argv[1];
+    const char* bin = MOCKGPS_MODULE_DIR "/location.bin";
+    const char* src = "-";
+
+    int i = 2;
+    if (i + 1 < argc && !strcmp(argv[i], "-f")) {
+        bin = argv[i + 1];
+        i += 2;
+    }
+
+    if (!strcmp(cmd, "import") || !strcmp(cmd, "update")) {
+        if (i < argc) src = argv[i++];
+        if (i != argc) return usage();
+        return importText(bin, src, !strcmp(cmd, "update"));
+    }
+    if (i != argc) return usage();
+    if (!strcmp(cmd, "export")) return exportText(bin);
+    if (!strcmp(cmd, "check")) return check(bin);
+    return usage();
+}
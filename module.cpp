@@ -8,42 +8,57 @@
 // 3. When setting kAccNative, must clear kAccSingleImplementation (0x80000) and kAccCriticalNative (0x200000)
 //    because these bits have different meanings for native vs Java methods
 
+#include <cerrno>
+#include <climits>
+#include <ctime>
 #include <cstdlib>
 #include <cstring>
+#include <new>
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <pthread.h>
 #include <dlfcn.h>
 #include <jni.h>
-#include <android/log.h>
+#include <android/trace.h>
+#include <linux/futex.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
 #include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/system_properties.h>
 #include <atomic>
 #include <string>
 #include <vector>
 
 #include "zygisk.hpp"
-
-#define LOG_TAG "MockGPS"
-#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  LOG_TAG, __VA_ARGS__)
+#include "config.hpp"
+#include "config_file.hpp"
+#include "profile_table.hpp"
+#include "route.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+#include "elf_resolver.hpp"
+#include "log.hpp"
 
 // ═══════════════════════════════════════════════════════════════════
 // Configuration
 // ═══════════════════════════════════════════════════════════════════
 
-static const char* CONFIG_PATH = "/data/adb/modules/mockgps/location.conf";
+// Host builds point this at a scratch directory
+#ifndef MOCKGPS_MODULE_DIR
+#define MOCKGPS_MODULE_DIR "/data/adb/modules/mockgps"
+#endif
 
-struct MockConfig {
-    bool    enabled  = false;
-    double  lat      = 0.0;
-    double  lng      = 0.0;
-    float   accuracy = 5.0f;
-    double  altitude = 0.0;
-    float   speed    = 0.0f;
-    float   bearing  = 0.0f;
-    bool    hideDev  = true;   // hide developer options
-};
+static const char* CONFIG_DIR      = MOCKGPS_MODULE_DIR;
+static const char* CONFIG_NAME     = "location.conf";
+static const char* CONFIG_PATH     = MOCKGPS_MODULE_DIR "/location.conf";
+static const char* CONFIG_BIN_NAME = "location.bin";
+static const char* CONFIG_BIN_PATH = MOCKGPS_MODULE_DIR "/location.bin";
+static const char* ROUTE_NAME      = "route.bin";
+static const char* ROUTE_PATH      = MOCKGPS_MODULE_DIR "/route.bin";
 
 // Binary packet for companion → child communication
 struct __attribute__((packed)) ConfigPacket {
@@ -55,80 +70,238 @@ struct __attribute__((packed)) ConfigPacket {
     float    speed;
     float    bearing;
     uint8_t  hideDev;
+    uint16_t overrides;
+    uint8_t  route;
+    uint32_t routeGen;
+};
+
+// Follows the config packet when the process hooks; carries the route region's fd
+struct __attribute__((packed)) RouteGrant {
+    uint32_t size;   // sizeof(RouteRegion), 0 if the companion has none
+};
+
+// Live config, published as one seqlock-protected snapshot so hook threads
+// always see a consistent set of fields
+static ConfigSnapshot g_config;
+
+// Snapshot the hooks read from: the companion's shared page once mapped in
+// preAppSpecialize, otherwise the process-local copy above
+static const ConfigSnapshot* g_activeConfig = &g_config;
+
+// Telemetry page shared with the other processes of this package (stats.hpp);
+// nullptr until the companion hands one out
+static StatsPage* g_stats = nullptr;
+
+// The companion's route region (route.hpp), mapped read-only in preAppSpecialize;
+// nullptr until then, and routes are not played without it
+static const RouteRegion* g_routes = nullptr;
+
+#if MOCKGPS_TELEMETRY
+// Phases that ended before g_stats was mapped; added to it by mapStatsPage()
+static uint64_t g_pendingPhaseNs[kStatsPhaseCount];
+static bool     g_pendingPhase[kStatsPhaseCount];
+
+static void recordPhase(StatsPhase phase, uint64_t ns) {
+    if (g_stats) {
+        recordPhase(g_stats, phase, ns);
+    } else {
+        g_pendingPhaseNs[phase] = ns;
+        g_pendingPhase[phase] = true;
+    }
+}
+
+// Times one run of a specialize phase into the stats page and marks it as an ATrace
+// section, so it shows up as a slice on the app's main thread in Perfetto/systrace
+// (atrace category "app" with the package selected)
+class PhaseTrace {
+public:
+    explicit PhaseTrace(StatsPhase phase) : phase_(phase) {
+        ATrace_beginSection(kPhaseTraceNames[phase]);
+        start_ = statsClockNs(CLOCK_MONOTONIC);
+    }
+
+    ~PhaseTrace() {
+        recordPhase(phase_, statsClockNs(CLOCK_MONOTONIC) - start_);
+        ATrace_endSection();
+    }
+
+    PhaseTrace(const PhaseTrace&) = delete;
+    PhaseTrace& operator=(const PhaseTrace&) = delete;
+
+private:
+    static constexpr const char* kPhaseTraceNames[kStatsPhaseCount] = {
+        "MockGPS preAppSpecialize", "MockGPS companion wait", "MockGPS cache adopt",
+        "MockGPS layout detection", "MockGPS trampoline discovery", "MockGPS hook resolve",
+        "MockGPS postAppSpecialize", "MockGPS hook install", "MockGPS controller start",
+    };
+
+    StatsPhase phase_;
+    uint64_t   start_;
 };
 
-static std::atomic<bool>   g_enabled{false};
-static std::atomic<double> g_lat{0.0};
-static std::atomic<double> g_lng{0.0};
-static std::atomic<float>  g_accuracy{5.0f};
-static std::atomic<double> g_altitude{0.0};
-static std::atomic<float>  g_speed{0.0f};
-static std::atomic<float>  g_bearing{0.0f};
-static std::atomic<bool>   g_hideDev{true};
+#define HOOK_STATS(id)     HookTimer hookTimer_(g_stats, id); \
+                           if (traceEnabled()) traceHookCall(id)
+#define PHASE_TRACE(phase) PhaseTrace phaseTrace##phase(phase)
+#else
+#define HOOK_STATS(id)     ((void)0)
+#define PHASE_TRACE(phase) ((void)0)
+#endif
 
 static void applyConfig(const MockConfig& cfg) {
-    g_enabled.store(cfg.enabled);
-    g_lat.store(cfg.lat);
-    g_lng.store(cfg.lng);
-    g_accuracy.store(cfg.accuracy);
-    g_altitude.store(cfg.altitude);
-    g_speed.store(cfg.speed);
-    g_bearing.store(cfg.bearing);
-    g_hideDev.store(cfg.hideDev);
-}
-
-// Parse config from text file content
-static MockConfig parseConfig(const char* data) {
-    MockConfig cfg;
-    const char* p = data;
-    while (p && *p) {
-        const char* nl = strchr(p, '\n');
-        int len = nl ? (int)(nl - p) : (int)strlen(p);
-        char line[256];
-        if (len < (int)sizeof(line)) {
-            memcpy(line, p, len);
-            line[len] = 0;
-            char* eq = strchr(line, '=');
-            if (eq) {
-                *eq = 0;
-                const char* key = line;
-                const char* val = eq + 1;
-                if (!strcmp(key, "enabled"))  cfg.enabled  = atoi(val) != 0;
-                else if (!strcmp(key, "lat"))      cfg.lat      = atof(val);
-                else if (!strcmp(key, "lng"))      cfg.lng      = atof(val);
-                else if (!strcmp(key, "accuracy")) cfg.accuracy = (float)atof(val);
-                else if (!strcmp(key, "altitude")) cfg.altitude = atof(val);
-                else if (!strcmp(key, "speed"))    cfg.speed    = (float)atof(val);
-                else if (!strcmp(key, "bearing"))  cfg.bearing  = (float)atof(val);
-                else if (!strcmp(key, "hidedev"))  cfg.hideDev  = atoi(val) != 0;
-            }
+    g_config.store(cfg);
+}
+
+static inline MockConfig currentConfig() {
+    return g_activeConfig->load();
+}
+
+static thread_local ConfigPair t_pair;
+
+// What getLatitude and getLongitude (`field`) answer from; see ConfigPair
+static inline const MockConfig& pairedConfig(uint16_t field) {
+    return t_pair.get(*g_activeConfig, field, statsClockNs(CLOCK_MONOTONIC_COARSE));
+}
+
+// A thread's place on the route and the fix it last reported. The fix is kept until
+// both its lat and its lng have been returned, so the two an app reads one after the
+// other come from the same instant, then the next getLatitude or getLongitude computes
+// a new one. A fix older than kRouteFixStaleNs is never reused: a lone getter, or one
+// left waiting for its pair, stays that close to the route's clock.
+static constexpr uint64_t kRouteFixStaleNs = 10000000;   // 10 ms, ~0.3 m at 100 km/h
+
+struct RouteThread {
+    RouteCursor cursor;
+    RouteFix    fix;
+    uint32_t    gen      = 0;   // route publish `fix` is on
+    uint16_t    consumed = 0;   // kFieldLat / kFieldLng returned from `fix`
+    uint64_t    atNs     = 0;
+};
+
+static thread_local RouteThread t_route;
+
+// Position on the route `cfg` plays for a getter of `field`; false while it plays
+// none. kFieldLat and kFieldLng consume the fix; speed and bearing (0) only read it.
+static inline bool routeFix(const MockConfig& cfg, uint16_t field, RouteFix* out) {
+    if (!cfg.routeGen) return false;
+    RouteThread& t = t_route;
+    uint64_t now = statsClockNs(CLOCK_BOOTTIME);
+    bool fresh  = t.gen == cfg.routeGen && now - t.atNs < kRouteFixStaleNs;
+    bool second = t.consumed && !(t.consumed & field);
+    if (fresh && (!field || second)) {
+        t.consumed |= field;
+    } else {
+        if (!locateOnRoute(g_routes, cfg.routeGen, now, &t.cursor, &t.fix)) return false;
+        t.gen  = cfg.routeGen;
+        t.atNs = now;
+        // A second call that found its fix stale ends the pair, as in ConfigPair
+        t.consumed = field && second ? (kFieldLat | kFieldLng) : field;
+    }
+    *out = t.fix;
+    return true;
+}
+
+// Load location.bin with a header check. The text location.conf is read only while no
+// binary config exists (installs that predate it, hand edits before an import).
+// Returns false when location.bin is present but rejected; callers keep the last good
+// config rather than falling back to defaults.
+static bool readConfigFile(ConfigSet* out) {
+    switch (loadConfigFile(CONFIG_BIN_PATH, out)) {
+    case ConfigLoad::kOk:
+        return true;
+    case ConfigLoad::kInvalid:
+        LOGE("Rejected %s: bad header or checksum", CONFIG_BIN_PATH);
+        return false;
+    case ConfigLoad::kMissing:
+        break;
+    }
+
+    // Missing or empty text file yields defaults. read() rather than a mapping: a
+    // hand edit may truncate the file under us, which would fault a mapping.
+    *out = ConfigSet();
+    int fd = open(CONFIG_PATH, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return true;
+    char buf[4096];
+    ssize_t n = read(fd, buf, sizeof(buf));
+    close(fd);
+    if (n == (ssize_t)sizeof(buf)) {
+        LOGE("%s too large, import it with mockgpsconf", CONFIG_PATH);
+        return false;
+    }
+    if (n > 0) {
+        ConfigErrors errors;
+        parseConfigSet(std::string_view(buf, n), out, &errors);
+        for (int i = 0; i < kConfigKeyCount; i++) {
+            if (errors.key[i] == ConfigError::kNone) continue;
+            LOGE("%s:%u: %s: %s", CONFIG_NAME, errors.line[i], kConfigKeyNames[i],
+                 configErrorName(errors.key[i]));
+        }
+        if (errors.badSections) {
+            LOGE("%s:%u: invalid profile section ignored", CONFIG_NAME, errors.firstBadSectionLine);
         }
-        p = nl ? nl + 1 : nullptr;
     }
-    return cfg;
+    return true;
 }
 
 // ═══════════════════════════════════════════════════════════════════
 // ART Method Layout Detection
 // ═══════════════════════════════════════════════════════════════════
 //
-// ArtMethod struct (Android 10+):
-//   offset 0:  declaring_class_ (GcRoot, 4 bytes compressed)
-//   offset 4:  access_flags_ (uint32_t)
-//   offset 8:  dex_code_item_offset_ (uint32_t)
-//   offset 12: dex_method_index_ (uint32_t)
-//   offset 16: hotness_count_ OR data_ (depends on size)
-//
-// Two known layouts:
-//   32-byte: data_ at offset 16, entry_point_ at offset 24
-//   40-byte: more fields between, data_ at offset 24/28, entry_point_ at offset 32
+// ArtMethod starts with 32-bit fields, followed by pointer-sized fields:
+//   declaring_class_ (GcRoot, 4 bytes compressed)
+//   access_flags_ (uint32_t, always at offset 4)
+//   dex_code_item_offset_ (uint32_t, removed in Android 12)
+//   dex_method_index_ (uint32_t)
+//   method_index_ (uint16_t), hotness_count_ / imt_index_ (uint16_t)
+//   [dex_cache_resolved_methods_ (Android 8.x only)]
+//   data_, entry_point_from_quick_compiled_code_
 //
-// We detect by comparing entry_point of two known native methods
+// The layout is looked up by API level and pointer width, then confirmed with one
+// probe. ART became an updatable module in Android 12, so a mismatch falls back to
+// the other known layouts and finally to the old size heuristics (64-bit only).
+
+struct ArtMethodLayout {
+    int    minApi;            // first API level with this layout
+    size_t ptrSize;
+    size_t size;
+    size_t dataOffset;
+    size_t entryPointOffset;
+};
+
+// Newest first; lookup takes the first entry whose minApi is not above the device's
+static constexpr ArtMethodLayout kArtMethodLayouts[] = {
+    // Android 12+: 16-byte header
+    {31, 8, 32, 16, 24},
+    {31, 4, 24, 16, 20},
+    // Android 9-11: 20-byte header
+    {28, 8, 40, 24, 32},
+    {28, 4, 28, 20, 24},
+    // Android 8.x: dex_cache_resolved_methods_ before data_
+    {26, 8, 48, 32, 40},
+    {26, 4, 32, 24, 28},
+};
+
+static constexpr const ArtMethodLayout* findArtMethodLayout(int api, size_t ptrSize) {
+    for (const auto& l : kArtMethodLayouts) {
+        if (l.ptrSize == ptrSize && api >= l.minApi) return &l;
+    }
+    return nullptr;
+}
+
+static_assert(findArtMethodLayout(34, 8)->size == 32, "Android 14 arm64 ArtMethod");
+static_assert(findArtMethodLayout(30, 8)->entryPointOffset == 32, "Android 11 arm64 ArtMethod");
+static_assert(findArtMethodLayout(29, 4)->dataOffset == 20, "Android 10 arm ArtMethod");
+static_assert(findArtMethodLayout(25, 8) == nullptr, "below minSdk");
 
 static size_t g_artMethodSize   = 0;
 static size_t g_dataOffset      = 0;
 static size_t g_entryPointOffset = 0;
 
+static int androidApiLevel() {
+    char value[PROP_VALUE_MAX] = {};
+    if (__system_property_get("ro.build.version.sdk", value) <= 0) return 0;
+    return atoi(value);
+}
+
 static void* getArtMethod(JNIEnv* env, jclass cls, const char* name, const char* sig) {
     jmethodID mid = env->GetMethodID(cls, name, sig);
     if (!mid) {
@@ -139,7 +312,66 @@ static void* getArtMethod(JNIEnv* env, jclass cls, const char* name, const char*
     return (void*)mid;  // jmethodID IS an ArtMethod*
 }
 
+// Probe a registered native instance method against a candidate layout:
+//   - data_ (JNI function) and entry_point_ (trampoline or compiled stub) must
+//     both point into loaded images
+//   - a neighbour in the class's method array, `size` bytes away, must have the
+//     same declaring_class_ (methods are stored contiguously per class)
+static bool validateArtMethodLayout(void* probe, const ArtMethodLayout& l) {
+    uint8_t* m = (uint8_t*)probe;
+    if (!(*(uint32_t*)(m + 4) & 0x00000100)) return false;  // kAccNative
+
+    Dl_info info;
+    void* data = *(void**)(m + l.dataOffset);
+    void* entry = *(void**)(m + l.entryPointOffset);
+    if (!data || !entry || !dladdr(data, &info) || !dladdr(entry, &info)) return false;
+
+    uint32_t klass = *(uint32_t*)m;
+    return *(uint32_t*)(m + l.size) == klass || *(uint32_t*)(m - l.size) == klass;
+}
+
+static bool applyArtMethodLayout(const ArtMethodLayout& l, const char* how) {
+    g_artMethodSize    = l.size;
+    g_dataOffset       = l.dataOffset;
+    g_entryPointOffset = l.entryPointOffset;
+    LOGI("ArtMethod layout (%s): size=%zu data_@%zu entry_point_@%zu", how,
+         l.size, l.dataOffset, l.entryPointOffset);
+    return true;
+}
+
+static bool detectArtMethodLayoutHeuristic(JNIEnv* env);
+
 static bool detectArtMethodLayout(JNIEnv* env) {
+    jclass stringClass = env->FindClass("java/lang/String");
+    void* probe = stringClass ? getArtMethod(env, stringClass, "intern", "()Ljava/lang/String;") : nullptr;
+    if (!probe) {
+        env->ExceptionClear();
+        LOGE("ArtMethod layout probe String.intern not found");
+        return false;
+    }
+
+    int api = androidApiLevel();
+    const ArtMethodLayout* expected = findArtMethodLayout(api, sizeof(void*));
+    if (expected && validateArtMethodLayout(probe, *expected)) {
+        return applyArtMethodLayout(*expected, "table");
+    }
+    LOGE("ArtMethod layout for API %d not confirmed, trying other known layouts", api);
+
+    for (const auto& l : kArtMethodLayouts) {
+        if (&l == expected || l.ptrSize != sizeof(void*)) continue;
+        if (validateArtMethodLayout(probe, l)) return applyArtMethodLayout(l, "probed");
+    }
+
+    return detectArtMethodLayoutHeuristic(env);
+}
+
+// Last resort for unknown runtimes. These guesses only cover 64-bit layouts.
+static bool detectArtMethodLayoutHeuristic(JNIEnv* env) {
+    if (sizeof(void*) != 8) {
+        LOGE("Unknown ArtMethod layout on 32-bit runtime, not hooking");
+        return false;
+    }
+
     // Use two native methods to measure struct size
     jclass stringClass = env->FindClass("java/lang/String");
     jclass systemClass = env->FindClass("java/lang/System");
@@ -222,12 +454,9 @@ static bool detectArtMethodLayout(JNIEnv* env) {
         }
     }
 
-    // Default to 32 based on our testing
-    g_artMethodSize = 32;
-    g_dataOffset = 16;
-    g_entryPointOffset = 24;
-    LOGI("Defaulting to 32-byte ArtMethod layout");
-    return true;
+    // A wrong guess would corrupt ART memory; better not to hook at all
+    LOGE("ArtMethod layout unknown, not hooking");
+    return false;
 }
 
 // ═══════════════════════════════════════════════════════════════════
@@ -250,38 +479,17 @@ static void* findJniTrampoline(JNIEnv* env) {
         return trampoline;
     }
 
-    // Strategy 2: Find libart.so via /proc/self/maps, dlopen, dlsym
+    // Strategy 2: Resolve from libart's own symbol tables. The trampoline is a
+    // hidden symbol on most builds, so it is usually only in .gnu_debugdata.
     {
-        FILE* maps = fopen("/proc/self/maps", "r");
-        if (maps) {
-            char line[512];
-            char artPath[256] = {};
-            while (fgets(line, sizeof(line), maps)) {
-                if (strstr(line, "libart.so") && strstr(line, "r-xp")) {
-                    // Extract path
-                    char* pathStart = strchr(line, '/');
-                    if (pathStart) {
-                        char* pathEnd = strchr(pathStart, '\n');
-                        if (pathEnd) *pathEnd = 0;
-                        strncpy(artPath, pathStart, sizeof(artPath) - 1);
-                        break;
-                    }
-                }
-            }
-            fclose(maps);
-
-            if (artPath[0]) {
-                void* handle = dlopen(artPath, RTLD_NOW | RTLD_NOLOAD);
-                if (handle) {
-                    trampoline = dlsym(handle, "art_quick_generic_jni_trampoline");
-                    dlclose(handle);
-                    if (trampoline) {
-                        LOGI("JNI trampoline found via libart dlopen: %p (path: %s)", trampoline, artPath);
-                        return trampoline;
-                    }
-                }
-            }
+        elf::Image libart("libart.so");
+        trampoline = libart.symbol("art_quick_generic_jni_trampoline");
+        if (trampoline) {
+            LOGI("JNI trampoline found in libart symbols: %p (path: %s)", trampoline, libart.path().c_str());
+            return trampoline;
         }
+        LOGE("art_quick_generic_jni_trampoline not in %s, probing methods",
+             libart.valid() ? libart.path().c_str() : "libart.so (not found)");
     }
 
     // Strategy 3: Read from INSTANCE native methods (guaranteed non-@CriticalNative)
@@ -356,199 +564,437 @@ static void* findJniTrampoline(JNIEnv* env) {
 //    - 0x00200000 = (becomes kAccCriticalNative when native)
 // 3. Write our native function pointer to data_ field
 // 4. Write JNI trampoline to entry_point_ field
+//
+// The original access_flags_, data_ and entry_point_ are saved on every install so
+// a hook can be removed again and the method goes back to its compiled code.
+//
+// Each install also clones the untouched ArtMethod into module-owned memory. The
+// clone keeps the original entry point, so passing it as a jmethodID to the JNI
+// Call* functions runs the original implementation (see originalMethod()).
+
+enum HookId {
+    // Location group: installed while spoofing is enabled, getters only while their
+    // field is overridden (hookField)
+    kHookIsFromMockProvider,
+    kHookIsMock,
+    kHookGetLatitude,
+    kHookGetLongitude,
+    kHookGetAccuracy,
+    kHookGetAltitude,
+    kHookGetSpeed,
+    kHookGetBearing,
+    kHookGetTime,
+    kHookGetElapsedRealtimeNanos,
+    // Settings group: installed while developer options are hidden
+    kHookSecureGetInt3,
+    kHookSecureGetInt2,
+    kHookGlobalGetInt3,
+    kHookCount,
+
+    kLocationHooksBegin = kHookIsFromMockProvider,
+    kLocationHooksEnd   = kHookSecureGetInt3,
+    kSettingsHooksBegin = kHookSecureGetInt3,
+    kSettingsHooksEnd   = kHookCount,
+};
 
-static bool convertToNative(JNIEnv* env, void* artMethod, void* nativeFunc) {
-    if (!artMethod || !nativeFunc || !g_jniTrampoline) return false;
+static_assert(kHookCount == kStatsHookCount, "kStatsHookNames follows HookId");
 
-    uint32_t* accessFlags = (uint32_t*)((uint8_t*)artMethod + 4);
-    uint32_t oldFlags = *accessFlags;
+// Set of HookIds, bit (1 << id)
+static constexpr uint32_t hookRange(int begin, int end) {
+    return ((1u << end) - 1) & ~((1u << begin) - 1);
+}
 
-    // Set kAccNative, clear problematic bits
-    uint32_t newFlags = (oldFlags | 0x00000100)           // + kAccNative
-                      & ~0x40000000                        // - kAccFastInterpreterToInterpreterInvoke
-                      & ~0x00080000                        // - kAccSingleImplementation/kAccFastNative
-                      & ~0x00200000;                       // - kAccCriticalNative
+// LocationField a getter returns; 0 for hooks that do not depend on the mask
+static uint16_t hookField(int id) {
+    switch (id) {
+    case kHookGetLatitude:             return kFieldLat;
+    case kHookGetLongitude:            return kFieldLng;
+    case kHookGetAccuracy:             return kFieldAccuracy;
+    case kHookGetAltitude:             return kFieldAltitude;
+    case kHookGetSpeed:                return kFieldSpeed;
+    case kHookGetBearing:              return kFieldBearing;
+    case kHookGetTime:
+    case kHookGetElapsedRealtimeNanos: return kFieldTime;
+    default:                           return 0;
+    }
+}
+
+struct HookSlot {
+    const char* name;        // for logging
+    void*       artMethod;   // nullptr when the target was not found
+    void*       hookFunc;
+    uint32_t    origFlags;
+    void*       origData;
+    void*       origEntry;
+    bool        saved;       // orig* and backup taken, on the first install only
+    bool        installed;
+    void*       backup;      // clone of the original ArtMethod, kBackupStride bytes
+    bool        callable;    // backup may be invoked (see cloneOriginal)
+};
+
+static HookSlot g_hooks[kHookCount] = {};
+
+// Backup clones live in one private anonymous mapping; ArtMethod is at most 48 bytes
+static constexpr size_t kBackupStride = 64;
+static uint8_t* g_backupArena = nullptr;
+
+static inline uint32_t* artAccessFlags(void* artMethod) {
+    return (uint32_t*)((uint8_t*)artMethod + 4);
+}
 
-    *accessFlags = newFlags;
+static inline void** artData(void* artMethod) {
+    return (void**)((uint8_t*)artMethod + g_dataOffset);
+}
+
+static inline void** artEntryPoint(void* artMethod) {
+    return (void**)((uint8_t*)artMethod + g_entryPointOffset);
+}
 
-    // Write native function pointer to data_
-    void** dataPtr = (void**)((uint8_t*)artMethod + g_dataOffset);
-    *dataPtr = nativeFunc;
+static uint32_t nativeAccessFlags(uint32_t flags) {
+    // Set kAccNative, clear problematic bits
+    return (flags | 0x00000100)           // + kAccNative
+         & ~0x40000000                    // - kAccFastInterpreterToInterpreterInvoke
+         & ~0x00080000                    // - kAccSingleImplementation/kAccFastNative
+         & ~0x00200000;                   // - kAccCriticalNative
+}
 
-    // Write JNI trampoline to entry_point_
-    void** epPtr = (void**)((uint8_t*)artMethod + g_entryPointOffset);
-    *epPtr = g_jniTrampoline;
+// Threads that loaded the previous entry point a moment ago may still be about to
+// read data_ / access_flags_. Live swaps wait this long between the two halves.
+static void hookGracePeriod() {
+    struct timespec ts = { 0, 2 * 1000 * 1000 };
+    nanosleep(&ts, nullptr);
+}
 
-    LOGD("convertToNative: method=%p flags 0x%08x→0x%08x data_=%p ep=%p",
-         artMethod, oldFlags, newFlags, nativeFunc, g_jniTrampoline);
+static bool allocBackupArena() {
+    if (g_backupArena) return true;
+    if (g_artMethodSize > kBackupStride) {
+        LOGE("ArtMethod size %zu exceeds backup stride, calling originals disabled", g_artMethodSize);
+        return false;
+    }
+    void* mem = mmap(nullptr, kHookCount * kBackupStride, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        LOGE("backup arena mmap failed: %s", strerror(errno));
+        return false;
+    }
+    g_backupArena = (uint8_t*)mem;
+    for (int i = 0; i < kHookCount; i++) g_hooks[i].backup = g_backupArena + i * kBackupStride;
     return true;
 }
 
+// Copy the ArtMethod before it is converted. The clone is only marked callable when
+// its entry point lies in a loaded image (boot oat, libart trampolines): JIT code is
+// tracked through the methods pointing at it, and the code cache may free it once
+// the original stops doing so. Hook targets live in the boot image, so the declaring
+// class the clone refers to never moves.
+static void cloneOriginal(HookSlot& h) {
+    if (!h.backup) return;
+    memcpy(h.backup, h.artMethod, g_artMethodSize);
+    Dl_info info;
+    bool callable = dladdr(h.origEntry, &info) != 0;
+    __atomic_store_n(&h.callable, callable, __ATOMIC_RELEASE);
+    if (!callable) LOGD("%s: entry %p not in a mapped image, original not callable", h.name, h.origEntry);
+}
+
+// jmethodID that runs the original implementation, or nullptr if there is none.
+// Instance methods go through CallNonvirtual*Method (a virtual call would dispatch
+// back to the hooked method), static ones through CallStatic*Method.
+static inline jmethodID originalMethod(HookId id) {
+    const HookSlot& h = g_hooks[id];
+    return __atomic_load_n(&h.callable, __ATOMIC_ACQUIRE) ? (jmethodID)h.backup : nullptr;
+}
+
+// Bring each hook in `which` to the state of its bit in `want` (HookId sets).
+//   Install: flags + data_ first, entry point last, so any caller that reaches the
+//            JNI trampoline finds the native flag and our function.
+//   Remove:  entry point first, flags + data_ last, so callers still inside the
+//            trampoline keep reading our function until they are through.
+// `live` adds the grace period between the halves; it is skipped during
+// postAppSpecialize where no app code is running yet. The original state is saved
+// on the first install and never again: while unhooked the method may be JIT
+// compiled, and an entry point saved then would point into code the code cache can
+// free once the hook hides it, leaving the next removal to restore a dangling one.
+// Removal hands the method back its image code and ART compiles it again if it is
+// still hot.
+static int setHooksInstalled(uint32_t which, uint32_t want, bool live) {
+    int changed = 0;
+    for (int i = 0; i < kHookCount; i++) {
+        HookSlot& h = g_hooks[i];
+        bool install = want & (1u << i);
+        if (!(which & (1u << i)) || !h.artMethod || h.installed == install) continue;
+        if (install) {
+            if (!h.saved) {
+                h.origFlags = __atomic_load_n(artAccessFlags(h.artMethod), __ATOMIC_RELAXED);
+                h.origData  = __atomic_load_n(artData(h.artMethod), __ATOMIC_RELAXED);
+                h.origEntry = __atomic_load_n(artEntryPoint(h.artMethod), __ATOMIC_RELAXED);
+                cloneOriginal(h);
+                h.saved = true;
+            }
+            __atomic_store_n(artData(h.artMethod), h.hookFunc, __ATOMIC_RELEASE);
+            __atomic_store_n(artAccessFlags(h.artMethod), nativeAccessFlags(h.origFlags), __ATOMIC_RELEASE);
+        } else {
+            __atomic_store_n(artEntryPoint(h.artMethod), h.origEntry, __ATOMIC_RELEASE);
+        }
+        changed++;
+    }
+    if (!changed) return 0;
+    if (live) hookGracePeriod();
+
+    for (int i = 0; i < kHookCount; i++) {
+        HookSlot& h = g_hooks[i];
+        bool install = want & (1u << i);
+        if (!(which & (1u << i)) || !h.artMethod || h.installed == install) continue;
+        if (install) {
+            __atomic_store_n(artEntryPoint(h.artMethod), g_jniTrampoline, __ATOMIC_RELEASE);
+            LOGD("convertToNative: %s method=%p flags 0x%08x→0x%08x data_=%p ep=%p",
+                 h.name, h.artMethod, h.origFlags, nativeAccessFlags(h.origFlags),
+                 h.hookFunc, g_jniTrampoline);
+        } else {
+            __atomic_store_n(artAccessFlags(h.artMethod), h.origFlags, __ATOMIC_RELEASE);
+            __atomic_store_n(artData(h.artMethod), h.origData, __ATOMIC_RELEASE);
+            LOGD("restoreOriginal: %s method=%p flags=0x%08x ep=%p", h.name, h.artMethod,
+                 h.origFlags, h.origEntry);
+        }
+        h.installed = install;
+    }
+    return changed;
+}
+
 // ═══════════════════════════════════════════════════════════════════
 // Hook Functions - Location Methods
 // ═══════════════════════════════════════════════════════════════════
 
-// Read actual field value from Location object (bypass our hooks)
-static double readDoubleField(JNIEnv* env, jobject loc, const char* fieldName) {
-    jclass cls = env->GetObjectClass(loc);
-    jfieldID fid = env->GetFieldID(cls, fieldName, "D");
-    if (!fid) { env->ExceptionClear(); return 0.0; }
-    return env->GetDoubleField(loc, fid);
+// Location instance fields for the fallback (spoofing disabled) path.
+// Resolved once in hookLocationMethods(); Location lives in the boot image, so the
+// IDs stay valid for the life of the process. Raw field offsets are not used: thiz
+// is an indirect reference, and turning it into an object address needs ART internals.
+struct LocationFields {
+    jfieldID latitude;
+    jfieldID longitude;
+    jfieldID accuracy;
+    jfieldID altitude;
+    jfieldID speed;
+    jfieldID bearing;
+    jfieldID time;
+    jfieldID elapsedRealtimeNanos;
+};
+
+static LocationFields g_locationFields = {};
+
+static void resolveLocationFields(JNIEnv* env, jclass locationClass) {
+    // Android 12 renamed the fields to carry their units; try both spellings
+    struct FieldDef {
+        jfieldID*   slot;
+        const char* name;
+        const char* legacyName;
+        const char* sig;
+    };
+    FieldDef defs[] = {
+        {&g_locationFields.latitude,             "mLatitudeDegrees",          "mLatitude",             "D"},
+        {&g_locationFields.longitude,            "mLongitudeDegrees",         "mLongitude",            "D"},
+        {&g_locationFields.accuracy,             "mHorizontalAccuracyMeters", "mAccuracy",             "F"},
+        {&g_locationFields.altitude,             "mAltitudeMeters",           "mAltitude",             "D"},
+        {&g_locationFields.speed,                "mSpeedMetersPerSecond",     "mSpeed",                "F"},
+        {&g_locationFields.bearing,              "mBearingDegrees",           "mBearing",              "F"},
+        {&g_locationFields.time,                 "mTimeMs",                   "mTime",                 "J"},
+        {&g_locationFields.elapsedRealtimeNanos, "mElapsedRealtimeNs",        "mElapsedRealtimeNanos", "J"},
+    };
+
+    for (auto& f : defs) {
+        jfieldID fid = env->GetFieldID(locationClass, f.name, f.sig);
+        if (!fid) {
+            env->ExceptionClear();
+            fid = env->GetFieldID(locationClass, f.legacyName, f.sig);
+        }
+        if (!fid) {
+            env->ExceptionClear();
+            LOGE("Location field not found: %s / %s", f.name, f.legacyName);
+        }
+        *f.slot = fid;
+    }
 }
 
-static float readFloatField(JNIEnv* env, jobject loc, const char* fieldName) {
-    jclass cls = env->GetObjectClass(loc);
-    jfieldID fid = env->GetFieldID(cls, fieldName, "F");
-    if (!fid) { env->ExceptionClear(); return 0.0f; }
-    return env->GetFloatField(loc, fid);
+// Global ref to android.location.Location for CallNonvirtual*Method. Created on first
+// use: hook targets may come from the companion's detection cache without any JNI
+// lookups, and only a missing field ever needs it. Racing threads store equal refs.
+static std::atomic<jclass> g_locationClass{nullptr};
+
+static jclass locationClassRef(JNIEnv* env) {
+    jclass cls = g_locationClass.load(std::memory_order_acquire);
+    if (cls) return cls;
+    jclass local = env->FindClass("android/location/Location");
+    if (!local) {
+        env->ExceptionClear();
+        return nullptr;
+    }
+    cls = (jclass)env->NewGlobalRef(local);
+    env->DeleteLocalRef(local);
+    g_locationClass.store(cls, std::memory_order_release);
+    return cls;
+}
+
+// Read actual field value from Location object (bypass our hooks). If the field was
+// not found on this Android version, run the original getter through its backup.
+static inline double readDoubleField(JNIEnv* env, jobject loc, jfieldID fid, HookId id) {
+    if (fid) return env->GetDoubleField(loc, fid);
+    jmethodID orig = originalMethod(id);
+    return orig ? env->CallNonvirtualDoubleMethod(loc, locationClassRef(env), orig) : 0.0;
 }
 
-static jlong readLongField(JNIEnv* env, jobject loc, const char* fieldName) {
-    jclass cls = env->GetObjectClass(loc);
-    jfieldID fid = env->GetFieldID(cls, fieldName, "J");
-    if (!fid) { env->ExceptionClear(); return 0; }
-    return env->GetLongField(loc, fid);
+static inline float readFloatField(JNIEnv* env, jobject loc, jfieldID fid, HookId id) {
+    if (fid) return env->GetFloatField(loc, fid);
+    jmethodID orig = originalMethod(id);
+    return orig ? env->CallNonvirtualFloatMethod(loc, locationClassRef(env), orig) : 0.0f;
+}
+
+static inline jlong readLongField(JNIEnv* env, jobject loc, jfieldID fid, HookId id) {
+    if (fid) return env->GetLongField(loc, fid);
+    jmethodID orig = originalMethod(id);
+    return orig ? env->CallNonvirtualLongMethod(loc, locationClassRef(env), orig) : 0;
 }
 
 // --- isFromMockProvider() → false ---
 static jboolean JNICALL hook_isFromMockProvider(JNIEnv* env, jobject thiz) {
+    HOOK_STATS(kHookIsFromMockProvider);
     (void)env; (void)thiz;
     return JNI_FALSE;
 }
 
 // --- isMock() → false ---
 static jboolean JNICALL hook_isMock(JNIEnv* env, jobject thiz) {
+    HOOK_STATS(kHookIsMock);
     (void)env; (void)thiz;
     return JNI_FALSE;
 }
 
 // --- getLatitude() → spoofed ---
 static jdouble JNICALL hook_getLatitude(JNIEnv* env, jobject thiz) {
-    if (g_enabled.load()) return g_lat.load();
-    return readDoubleField(env, thiz, "mLatitude");
+    HOOK_STATS(kHookGetLatitude);
+    const MockConfig& cfg = pairedConfig(kFieldLat);
+    if (cfg.spoofs(kFieldLat)) {
+        RouteFix fix;
+        return routeFix(cfg, kFieldLat, &fix) ? fix.lat : cfg.lat;
+    }
+    return readDoubleField(env, thiz, g_locationFields.latitude, kHookGetLatitude);
 }
 
 // --- getLongitude() → spoofed ---
 static jdouble JNICALL hook_getLongitude(JNIEnv* env, jobject thiz) {
-    if (g_enabled.load()) return g_lng.load();
-    return readDoubleField(env, thiz, "mLongitude");
+    HOOK_STATS(kHookGetLongitude);
+    const MockConfig& cfg = pairedConfig(kFieldLng);
+    if (cfg.spoofs(kFieldLng)) {
+        RouteFix fix;
+        return routeFix(cfg, kFieldLng, &fix) ? fix.lng : cfg.lng;
+    }
+    return readDoubleField(env, thiz, g_locationFields.longitude, kHookGetLongitude);
 }
 
 // --- getAccuracy() → spoofed ---
 static jfloat JNICALL hook_getAccuracy(JNIEnv* env, jobject thiz) {
-    if (g_enabled.load()) return g_accuracy.load();
-    return readFloatField(env, thiz, "mAccuracy");
+    HOOK_STATS(kHookGetAccuracy);
+    MockConfig cfg = currentConfig();
+    if (cfg.spoofs(kFieldAccuracy)) return cfg.accuracy;
+    return readFloatField(env, thiz, g_locationFields.accuracy, kHookGetAccuracy);
 }
 
 // --- getAltitude() → spoofed ---
 static jdouble JNICALL hook_getAltitude(JNIEnv* env, jobject thiz) {
-    if (g_enabled.load()) return g_altitude.load();
-    return readDoubleField(env, thiz, "mAltitude");
+    HOOK_STATS(kHookGetAltitude);
+    MockConfig cfg = currentConfig();
+    if (cfg.spoofs(kFieldAltitude)) return cfg.altitude;
+    return readDoubleField(env, thiz, g_locationFields.altitude, kHookGetAltitude);
 }
 
 // --- getSpeed() → spoofed ---
 static jfloat JNICALL hook_getSpeed(JNIEnv* env, jobject thiz) {
-    if (g_enabled.load()) return g_speed.load();
-    return readFloatField(env, thiz, "mSpeed");
+    HOOK_STATS(kHookGetSpeed);
+    MockConfig cfg = currentConfig();
+    if (cfg.spoofs(kFieldSpeed)) {
+        RouteFix fix;
+        return routeFix(cfg, 0, &fix) ? fix.speed : cfg.speed;
+    }
+    return readFloatField(env, thiz, g_locationFields.speed, kHookGetSpeed);
 }
 
 // --- getBearing() → spoofed ---
 static jfloat JNICALL hook_getBearing(JNIEnv* env, jobject thiz) {
-    if (g_enabled.load()) return g_bearing.load();
-    return readFloatField(env, thiz, "mBearing");
+    HOOK_STATS(kHookGetBearing);
+    MockConfig cfg = currentConfig();
+    if (cfg.spoofs(kFieldBearing)) {
+        RouteFix fix;
+        return routeFix(cfg, 0, &fix) ? fix.bearing : cfg.bearing;
+    }
+    return readFloatField(env, thiz, g_locationFields.bearing, kHookGetBearing);
 }
 
 // --- getTime() → current time (keeps location "fresh") ---
 static jlong JNICALL hook_getTime(JNIEnv* env, jobject thiz) {
-    if (g_enabled.load()) {
+    HOOK_STATS(kHookGetTime);
+    if (currentConfig().spoofs(kFieldTime)) {
         struct timespec ts;
         clock_gettime(CLOCK_REALTIME, &ts);
         return (jlong)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
     }
-    return readLongField(env, thiz, "mTime");
+    return readLongField(env, thiz, g_locationFields.time, kHookGetTime);
 }
 
 // --- getElapsedRealtimeNanos() → current boottime ---
 static jlong JNICALL hook_getElapsedRealtimeNanos(JNIEnv* env, jobject thiz) {
-    if (g_enabled.load()) {
+    HOOK_STATS(kHookGetElapsedRealtimeNanos);
+    if (currentConfig().spoofs(kFieldTime)) {
         struct timespec ts;
         clock_gettime(CLOCK_BOOTTIME, &ts);
         return (jlong)ts.tv_sec * 1000000000LL + ts.tv_nsec;
     }
-    return readLongField(env, thiz, "mElapsedRealtimeNanos");
-}
-
-// ═══════════════════════════════════════════════════════════════════
-// Hook Functions - Developer Options Hiding
-// ═══════════════════════════════════════════════════════════════════
-
-// Hook Settings.Secure.getInt / Settings.Global.getInt to hide developer options
-// We hook at the Location level and also intercept Settings queries via reflection
-
-static void hideDeveloperOptions(JNIEnv* env) {
-    if (!g_hideDev.load()) return;
-
-    // Use ContentResolver to set development_settings_enabled = 0
-    // This is done via Settings.Global and Settings.Secure
-    // We'll write to the fields that apps check
-
-    jclass settingsGlobal = env->FindClass("android/provider/Settings$Global");
-    jclass settingsSecure = env->FindClass("android/provider/Settings$Secure");
-
-    // We can't easily hook static methods with our ART conversion technique
-    // on Settings since they're heavily used by the system.
-    // Instead, we'll set the actual system properties that apps check.
-
-    // The mock_location and development_settings checks are typically done via:
-    // Settings.Secure.getInt(cr, "mock_location", 0)
-    // Settings.Global.getInt(cr, "development_settings_enabled", 0)
-
-    // A more reliable approach: hook at the native property level
-    // For now, we write the values directly via System.setProperty
-    // (apps reading system settings will get 0)
-
-    LOGD("Developer options hiding active - apps checking Settings will see hooks");
+    return readLongField(env, thiz, g_locationFields.elapsedRealtimeNanos, kHookGetElapsedRealtimeNanos);
 }
 
 // ═══════════════════════════════════════════════════════════════════
 // Apply All Hooks
 // ═══════════════════════════════════════════════════════════════════
+//
+// Hook targets are resolved once per process into g_hooks; whether each group is
+// installed follows the live config (see hookControllerThread).
+
+struct LocationHookDef {
+    HookId      id;
+    const char* name;
+    const char* sig;
+    void*       func;
+    bool        required;
+};
+
+static const LocationHookDef kLocationHookDefs[] = {
+    // Mock detection
+    {kHookIsFromMockProvider,       "isFromMockProvider",       "()Z", (void*)hook_isFromMockProvider,              true},
+    {kHookIsMock,                   "isMock",                   "()Z", (void*)hook_isMock,                          false}, // API 31+
+
+    // Coordinate methods
+    {kHookGetLatitude,              "getLatitude",              "()D", (void*)hook_getLatitude,                     true},
+    {kHookGetLongitude,             "getLongitude",             "()D", (void*)hook_getLongitude,                    true},
+    {kHookGetAccuracy,              "getAccuracy",              "()F", (void*)hook_getAccuracy,                     true},
+    {kHookGetAltitude,              "getAltitude",              "()D", (void*)hook_getAltitude,                     true},
+    {kHookGetSpeed,                 "getSpeed",                 "()F", (void*)hook_getSpeed,                        true},
+    {kHookGetBearing,               "getBearing",               "()F", (void*)hook_getBearing,                      true},
+
+    // Time methods (prevents stale location detection)
+    {kHookGetTime,                  "getTime",                  "()J", (void*)hook_getTime,                         true},
+    {kHookGetElapsedRealtimeNanos,  "getElapsedRealtimeNanos",  "()J", (void*)hook_getElapsedRealtimeNanos,         true},
+};
 
-static bool hookLocationMethods(JNIEnv* env) {
+static bool resolveLocationHooks(JNIEnv* env) {
     jclass locationClass = env->FindClass("android/location/Location");
     if (!locationClass) {
         LOGE("Cannot find android.location.Location class!");
         return false;
     }
 
-    struct HookDef {
-        const char* name;
-        const char* sig;
-        void* func;
-        bool required;
-    };
-
-    HookDef hooks[] = {
-        // Mock detection
-        {"isFromMockProvider", "()Z",  (void*)hook_isFromMockProvider, true},
-        {"isMock",             "()Z",  (void*)hook_isMock,             false}, // API 31+
-
-        // Coordinate methods
-        {"getLatitude",        "()D",  (void*)hook_getLatitude,        true},
-        {"getLongitude",       "()D",  (void*)hook_getLongitude,       true},
-        {"getAccuracy",        "()F",  (void*)hook_getAccuracy,        true},
-        {"getAltitude",        "()D",  (void*)hook_getAltitude,        true},
-        {"getSpeed",           "()F",  (void*)hook_getSpeed,           true},
-        {"getBearing",         "()F",  (void*)hook_getBearing,         true},
-
-        // Time methods (prevents stale location detection)
-        {"getTime",                  "()J", (void*)hook_getTime,                  true},
-        {"getElapsedRealtimeNanos",  "()J", (void*)hook_getElapsedRealtimeNanos,  true},
-    };
+    // Fallback reads need the field IDs before any hooked getter can run
+    resolveLocationFields(env, locationClass);
 
-    int hooked = 0, failed = 0;
+    int resolved = 0, failed = 0;
 
-    for (auto& h : hooks) {
+    for (auto& h : kLocationHookDefs) {
         jmethodID mid = env->GetMethodID(locationClass, h.name, h.sig);
         if (!mid) {
             env->ExceptionClear();
@@ -560,18 +1006,14 @@ static bool hookLocationMethods(JNIEnv* env) {
             }
             continue;
         }
-
-        if (convertToNative(env, (void*)mid, h.func)) {
-            LOGI("Hooked: Location.%s%s", h.name, h.sig);
-            hooked++;
-        } else {
-            LOGE("FAILED to hook: Location.%s%s", h.name, h.sig);
-            failed++;
-        }
+        g_hooks[h.id].name      = h.name;
+        g_hooks[h.id].artMethod = (void*)mid;
+        g_hooks[h.id].hookFunc  = h.func;
+        resolved++;
     }
 
-    LOGI("Location hooks: %d hooked, %d failed", hooked, failed);
-    return hooked > 0;
+    LOGI("Location hooks: %d resolved, %d failed", resolved, failed);
+    return resolved > 0;
 }
 
 // ═══════════════════════════════════════════════════════════════════
@@ -583,160 +1025,492 @@ static bool hookLocationMethods(JNIEnv* env) {
 
 // We use a JNI approach: register a native wrapper that checks the key
 
-// Static hooks for Settings.Secure.getInt(ContentResolver, String)
-// This is a static method so it gets: env, jclass, contentResolver, key
-static jint JNICALL hook_secureGetInt2(JNIEnv* env, jclass clazz, jobject resolver, jstring name) {
-    (void)clazz; (void)resolver;
-    if (!g_hideDev.load()) {
-        // Fallback: return 0 since we can't call original easily
-        return 0;
-    }
+// Keys reported as 0 while developer options are hidden
+static const char* const kHiddenSecureKeys[] = {
+    "mock_location", "allow_mock_location", "development_settings_enabled", nullptr
+};
+static const char* const kHiddenGlobalKeys[] = {
+    "development_settings_enabled", "adb_enabled", nullptr
+};
 
+static bool isHiddenKey(JNIEnv* env, jstring name, const char* const* keys) {
     const char* key = env->GetStringUTFChars(name, nullptr);
-    if (!key) return 0;
+    if (!key) return false;
 
-    jint result = 0;
-    if (!strcmp(key, "mock_location") || !strcmp(key, "allow_mock_location") ||
-        !strcmp(key, "development_settings_enabled")) {
-        LOGD("Settings.Secure.getInt intercepted: %s → 0", key);
-        result = 0;
-    }
-    // For other keys, return 0 as default (not ideal but safe for this overload)
+    bool hidden = false;
+    for (; *keys && !hidden; keys++) hidden = !strcmp(key, *keys);
+    if (hidden) LOGD("Settings.getInt intercepted: %s → 0", key);
 
     env->ReleaseStringUTFChars(name, key);
-    return result;
+    return hidden;
+}
+
+// Non-hidden keys go to the original getInt through its backup clone. Without one
+// (backup not callable) the 3-arg overloads fall back to defValue and the 2-arg
+// overload to 0.
+
+// Static hooks for Settings.Secure.getInt(ContentResolver, String)
+// This is a static method so it gets: env, jclass, contentResolver, key
+static jint JNICALL hook_secureGetInt2(JNIEnv* env, jclass clazz, jobject resolver, jstring name) {
+    HOOK_STATS(kHookSecureGetInt2);
+    if (currentConfig().hideDev && isHiddenKey(env, name, kHiddenSecureKeys)) return 0;
+
+    // The original throws SettingNotFoundException; it stays pending for the caller
+    jmethodID orig = originalMethod(kHookSecureGetInt2);
+    return orig ? env->CallStaticIntMethod(clazz, orig, resolver, name) : 0;
 }
 
 // Hook Settings.Secure.getInt(ContentResolver, String, int default)
 static jint JNICALL hook_secureGetInt3(JNIEnv* env, jclass clazz, jobject resolver, jstring name, jint defValue) {
-    (void)clazz; (void)resolver;
+    HOOK_STATS(kHookSecureGetInt3);
+    if (currentConfig().hideDev && isHiddenKey(env, name, kHiddenSecureKeys)) return 0;
 
-    const char* key = env->GetStringUTFChars(name, nullptr);
-    if (!key) return defValue;
+    jmethodID orig = originalMethod(kHookSecureGetInt3);
+    return orig ? env->CallStaticIntMethod(clazz, orig, resolver, name, defValue) : defValue;
+}
+
+// Hook Settings.Global.getInt(ContentResolver, String, int default)
+static jint JNICALL hook_globalGetInt3(JNIEnv* env, jclass clazz, jobject resolver, jstring name, jint defValue) {
+    HOOK_STATS(kHookGlobalGetInt3);
+    if (currentConfig().hideDev && isHiddenKey(env, name, kHiddenGlobalKeys)) return 0;
 
-    jint result = defValue;
-    bool intercepted = false;
+    jmethodID orig = originalMethod(kHookGlobalGetInt3);
+    return orig ? env->CallStaticIntMethod(clazz, orig, resolver, name, defValue) : defValue;
+}
+
+struct SettingsHookDef {
+    HookId      id;
+    const char* cls;
+    const char* name;
+    const char* sig;
+    void*       func;
+};
+
+static const SettingsHookDef kSettingsHookDefs[] = {
+    // The 3-arg version (with default) is what most apps use
+    {kHookSecureGetInt3, "android/provider/Settings$Secure", "Secure.getInt(CR, String, int)",
+     "(Landroid/content/ContentResolver;Ljava/lang/String;I)I", (void*)hook_secureGetInt3},
+    // 2-arg version (throws on not found)
+    {kHookSecureGetInt2, "android/provider/Settings$Secure", "Secure.getInt(CR, String)",
+     "(Landroid/content/ContentResolver;Ljava/lang/String;)I", (void*)hook_secureGetInt2},
+    {kHookGlobalGetInt3, "android/provider/Settings$Global", "Global.getInt(CR, String, int)",
+     "(Landroid/content/ContentResolver;Ljava/lang/String;I)I", (void*)hook_globalGetInt3},
+};
 
-    if (g_hideDev.load()) {
-        if (!strcmp(key, "mock_location") || !strcmp(key, "allow_mock_location") ||
-            !strcmp(key, "development_settings_enabled")) {
-            result = 0;
-            intercepted = true;
-            LOGD("Settings.Secure.getInt intercepted: %s → 0", key);
+static bool resolveSettingsHooks(JNIEnv* env) {
+    int resolved = 0;
+    for (auto& h : kSettingsHookDefs) {
+        jclass cls = env->FindClass(h.cls);
+        if (!cls) {
+            env->ExceptionClear();
+            continue;
         }
+        jmethodID mid = env->GetStaticMethodID(cls, "getInt", h.sig);
+        if (!mid) {
+            env->ExceptionClear();
+            continue;
+        }
+        g_hooks[h.id].name      = h.name;
+        g_hooks[h.id].artMethod = (void*)mid;
+        g_hooks[h.id].hookFunc  = h.func;
+        resolved++;
     }
 
-    env->ReleaseStringUTFChars(name, key);
+    LOGI("Settings hooks: %d resolved", resolved);
+    return resolved > 0;
+}
 
-    if (!intercepted) {
-        // For non-intercepted keys, we need to read the actual value
-        // Use ContentResolver.query approach or just return defValue
-        return defValue;
+// Hooks a config needs. Getters of fields it does not override stay on their
+// compiled code; the mock flag hooks follow `enabled` alone.
+static uint32_t wantedHooks(const MockConfig& cfg) {
+    uint32_t want = 0;
+    for (int i = kLocationHooksBegin; i < kLocationHooksEnd; i++) {
+        uint16_t field = hookField(i);
+        if (field ? cfg.spoofs(field) : cfg.enabled) want |= 1u << i;
     }
-    return result;
+    if (cfg.hideDev) want |= hookRange(kSettingsHooksBegin, kSettingsHooksEnd);
+    return want;
 }
 
-// Hook Settings.Global.getInt(ContentResolver, String, int default)
-static jint JNICALL hook_globalGetInt3(JNIEnv* env, jclass clazz, jobject resolver, jstring name, jint defValue) {
-    (void)clazz; (void)resolver;
+// Bring installed hooks in line with the config; returns number of methods changed
+static int applyHookState(const MockConfig& cfg, bool live) {
+    return setHooksInstalled(hookRange(0, kHookCount), wantedHooks(cfg), live);
+}
 
-    const char* key = env->GetStringUTFChars(name, nullptr);
-    if (!key) return defValue;
+// ═══════════════════════════════════════════════════════════════════
+// Runtime Detection Cache
+// ═══════════════════════════════════════════════════════════════════
+//
+// Layout detection, trampoline discovery and hook target lookup give the same
+// answers in every child of a zygote: boot image ArtMethods/ArtFields and libart
+// are inherited at the same addresses. Zygisk loads modules after the fork, so
+// there is no zygote-time hook to run them once. Instead the first hooked child
+// runs them in preAppSpecialize and reports the results to the companion, which
+// hands them to every later child of the same zygote.
+//
+// Entries are keyed by zygote pid plus env->functions (libart's JNI table, which
+// moves with ASLR whenever a zygote restarts). A child re-checks one remembered
+// word of the probe method before trusting an entry.
 
-    jint result = defValue;
-    bool intercepted = false;
+static constexpr size_t kLocationFieldCount = sizeof(LocationFields) / sizeof(jfieldID);
 
-    if (g_hideDev.load()) {
-        if (!strcmp(key, "development_settings_enabled") || !strcmp(key, "adb_enabled")) {
-            result = 0;
-            intercepted = true;
-            LOGD("Settings.Global.getInt intercepted: %s → 0", key);
-        }
+struct __attribute__((packed)) RuntimeKey {
+    uint64_t zygotePid;
+    uint64_t jniTable;
+    uint32_t ptrSize;
+};
+
+struct __attribute__((packed)) RuntimeCache {
+    RuntimeKey key;
+    uint32_t valid;
+    uint32_t artMethodSize;
+    uint32_t dataOffset;
+    uint32_t entryPointOffset;
+    uint32_t probeWord;                  // declaring_class_ of Location.getLatitude
+    uint64_t trampoline;
+    uint64_t methods[kHookCount];        // ArtMethod* per HookId, 0 if not found
+    uint64_t fields[kLocationFieldCount];
+};
+
+static RuntimeKey runtimeKey(JNIEnv* env) {
+    RuntimeKey key = {};
+    key.zygotePid = (uint64_t)getppid();
+    key.jniTable  = (uint64_t)(uintptr_t)env->functions;
+    key.ptrSize   = sizeof(void*);
+    return key;
+}
+
+static bool sameKey(const RuntimeKey& a, const RuntimeKey& b) {
+    return a.zygotePid == b.zygotePid && a.jniTable == b.jniTable && a.ptrSize == b.ptrSize;
+}
+
+// Full detection; fills the hook table and the Location field IDs
+static bool detectRuntime(JNIEnv* env) {
+    bool detected;
+    {
+        PHASE_TRACE(kPhaseLayoutDetect);
+        detected = detectArtMethodLayout(env);
+    }
+    if (!detected) {
+        LOGE("Failed to detect ArtMethod layout!");
+        return false;
     }
 
-    env->ReleaseStringUTFChars(name, key);
+    {
+        PHASE_TRACE(kPhaseTrampolineFind);
+        g_jniTrampoline = findJniTrampoline(env);
+    }
+    if (!g_jniTrampoline) {
+        LOGE("Failed to find JNI trampoline!");
+        return false;
+    }
+
+    PHASE_TRACE(kPhaseHookResolve);
+    bool location = resolveLocationHooks(env);
+    bool settings = resolveSettingsHooks(env);
+    return location || settings;
+}
 
-    if (!intercepted) return defValue;
-    return result;
+// Snapshot the detection results for the companion. Fails when the runtime hands
+// out index-based jmethodIDs/jfieldIDs (odd values, debuggable apps on Android 11+):
+// those are per-process and must not be shared.
+static bool exportRuntimeCache(const RuntimeKey& key, RuntimeCache* out) {
+    const auto* fields = (const jfieldID*)&g_locationFields;
+    void* probe = g_hooks[kHookGetLatitude].artMethod;
+    if (!probe) return false;
+
+    memset(out, 0, sizeof(*out));
+    out->key              = key;
+    out->artMethodSize    = (uint32_t)g_artMethodSize;
+    out->dataOffset       = (uint32_t)g_dataOffset;
+    out->entryPointOffset = (uint32_t)g_entryPointOffset;
+    out->probeWord        = *(const uint32_t*)probe;
+    out->trampoline       = (uint64_t)(uintptr_t)g_jniTrampoline;
+
+    uint64_t ids = 0;
+    for (int i = 0; i < kHookCount; i++) {
+        out->methods[i] = (uint64_t)(uintptr_t)g_hooks[i].artMethod;
+        ids |= out->methods[i];
+    }
+    for (size_t i = 0; i < kLocationFieldCount; i++) {
+        out->fields[i] = (uint64_t)(uintptr_t)fields[i];
+        ids |= out->fields[i];
+    }
+    if (ids & 1) {
+        LOGD("Index-based JNI IDs, detection results not shared");
+        return false;
+    }
+    out->valid = 1;
+    return true;
 }
 
-static bool hookSettingsMethods(JNIEnv* env) {
-    if (!g_hideDev.load()) return true;
+// Take over a companion entry; no JNI calls, one memory probe
+static bool adoptRuntimeCache(const RuntimeCache& cache, const RuntimeKey& key) {
+    if (!cache.valid || !sameKey(cache.key, key)) return false;
 
-    int hooked = 0;
+    void* probe = (void*)(uintptr_t)cache.methods[kHookGetLatitude];
+    if (!probe || *(const uint32_t*)probe != cache.probeWord) {
+        LOGE("Cached runtime data failed validation, detecting");
+        return false;
+    }
 
-    // Hook Settings.Secure.getInt(ContentResolver, String, int)
-    jclass secureClass = env->FindClass("android/provider/Settings$Secure");
-    if (secureClass) {
-        // The 3-arg version (with default) is what most apps use
-        jmethodID getInt3 = env->GetStaticMethodID(secureClass, "getInt",
-            "(Landroid/content/ContentResolver;Ljava/lang/String;I)I");
-        if (getInt3) {
-            if (convertToNative(env, (void*)getInt3, (void*)hook_secureGetInt3)) {
-                LOGI("Hooked: Settings.Secure.getInt(CR, String, int)");
-                hooked++;
-            }
-        } else {
-            env->ExceptionClear();
-        }
+    g_artMethodSize    = cache.artMethodSize;
+    g_dataOffset       = cache.dataOffset;
+    g_entryPointOffset = cache.entryPointOffset;
+    g_jniTrampoline    = (void*)(uintptr_t)cache.trampoline;
 
-        // 2-arg version (throws on not found)
-        jmethodID getInt2 = env->GetStaticMethodID(secureClass, "getInt",
-            "(Landroid/content/ContentResolver;Ljava/lang/String;)I");
-        if (getInt2) {
-            if (convertToNative(env, (void*)getInt2, (void*)hook_secureGetInt2)) {
-                LOGI("Hooked: Settings.Secure.getInt(CR, String)");
-                hooked++;
-            }
-        } else {
-            env->ExceptionClear();
-        }
+    auto* fields = (jfieldID*)&g_locationFields;
+    for (size_t i = 0; i < kLocationFieldCount; i++) fields[i] = (jfieldID)(uintptr_t)cache.fields[i];
+
+    for (auto& h : kLocationHookDefs) {
+        g_hooks[h.id].name      = h.name;
+        g_hooks[h.id].artMethod = (void*)(uintptr_t)cache.methods[h.id];
+        g_hooks[h.id].hookFunc  = h.func;
     }
+    for (auto& h : kSettingsHookDefs) {
+        g_hooks[h.id].name      = h.name;
+        g_hooks[h.id].artMethod = (void*)(uintptr_t)cache.methods[h.id];
+        g_hooks[h.id].hookFunc  = h.func;
+    }
+    LOGD("Runtime data from companion cache: ArtMethod %zu bytes, trampoline %p",
+         g_artMethodSize, g_jniTrampoline);
+    return true;
+}
 
-    // Hook Settings.Global.getInt(ContentResolver, String, int)
-    jclass globalClass = env->FindClass("android/provider/Settings$Global");
-    if (globalClass) {
-        jmethodID getInt3 = env->GetStaticMethodID(globalClass, "getInt",
-            "(Landroid/content/ContentResolver;Ljava/lang/String;I)I");
-        if (getInt3) {
-            if (convertToNative(env, (void*)getInt3, (void*)hook_globalGetInt3)) {
-                LOGI("Hooked: Settings.Global.getInt(CR, String, int)");
-                hooked++;
-            }
-        } else {
-            env->ExceptionClear();
+// ═══════════════════════════════════════════════════════════════════
+// Shared Config Page
+// ═══════════════════════════════════════════════════════════════════
+//
+// The companion owns the only config watcher and publishes every change into a
+// ConfigSnapshot living in a sealed memfd. Each hooked process maps that page
+// read-only in preAppSpecialize (the fd itself is closed by Zygisk's fd sanitizer,
+// the mapping survives) and the hooks read it directly through the seqlock.
+// Updates are visible to every process as soon as the companion stores them,
+// with no polling and no syscalls on the hook path.
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+#ifndef MFD_ALLOW_SEALING
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+#ifndef F_SEAL_FUTURE_WRITE
+#define F_SEAL_FUTURE_WRITE 0x0010  // Linux 5.1+
+#endif
+
+static int memfdCreate(const char* name, unsigned int flags) {
+    return (int)syscall(__NR_memfd_create, name, flags);
+}
+
+static void futexWait(const std::atomic<uint32_t>* addr, uint32_t expected,
+                      const struct timespec* timeout = nullptr) {
+    syscall(__NR_futex, addr, FUTEX_WAIT, expected, timeout, nullptr, 0);
+}
+
+static void futexWake(const std::atomic<uint32_t>* addr) {
+    syscall(__NR_futex, addr, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+// Send a buffer, optionally with one file descriptor attached (SCM_RIGHTS)
+static bool sendWithFd(int sock, const void* data, size_t len, int fd) {
+    struct iovec iov = { const_cast<void*>(data), len };
+    struct msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    alignas(struct cmsghdr) char ctrl[CMSG_SPACE(sizeof(int))] = {};
+    if (fd >= 0) {
+        msg.msg_control = ctrl;
+        msg.msg_controllen = sizeof(ctrl);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    }
+    return sendmsg(sock, &msg, MSG_NOSIGNAL) == (ssize_t)len;
+}
+
+// Receive exactly len bytes; *fd is set to an attached descriptor or -1
+static bool recvWithFd(int sock, void* data, size_t len, int* fd) {
+    struct iovec iov = { data, len };
+    struct msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    alignas(struct cmsghdr) char ctrl[CMSG_SPACE(sizeof(int))] = {};
+    msg.msg_control = ctrl;
+    msg.msg_controllen = sizeof(ctrl);
+
+    *fd = -1;
+    ssize_t n = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); n > 0 && cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            memcpy(fd, CMSG_DATA(cmsg), sizeof(int));
         }
     }
+    return n == (ssize_t)len;
+}
+
+// Map the package's telemetry region (stats page and trace buffer) read-write.
+// Like the config page it must be sealed against shrinking, and large enough for
+// both; a region with the wrong layout is left unmapped.
+static void mapStatsPage(int fd) {
+    if (!MOCKGPS_TELEMETRY) return;
+    int seals = fcntl(fd, F_GET_SEALS);
+    struct stat st;
+    if (seals < 0 || !(seals & F_SEAL_SHRINK) || fstat(fd, &st) < 0 || st.st_size < (off_t)kStatsRegionSize) return;
+    void* mem = mmap(nullptr, kStatsRegionSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mem == MAP_FAILED) return;
+    auto* page = (StatsPage*)mem;
+    if (page->magic != kStatsMagic || page->version != kStatsVersion) {
+        munmap(mem, kStatsRegionSize);
+        return;
+    }
+    g_stats = page;
+#if MOCKGPS_TELEMETRY
+    for (int i = 0; i < kStatsPhaseCount; i++) {
+        if (g_pendingPhase[i]) recordPhase(page, (StatsPhase)i, g_pendingPhaseNs[i]);
+    }
+#endif
+}
 
-    LOGI("Settings hooks: %d applied", hooked);
-    return hooked > 0;
+// Map the companion's route region read-only. Like the config page it must be
+// sealed against shrinking; one of another size is left unmapped.
+static void mapRouteRegion(int fd, const RouteGrant& grant) {
+    int seals = fcntl(fd, F_GET_SEALS);
+    struct stat st;
+    if (grant.size != sizeof(RouteRegion) || seals < 0 || !(seals & F_SEAL_SHRINK) || fstat(fd, &st) < 0 ||
+        st.st_size < (off_t)sizeof(RouteRegion)) {
+        return;
+    }
+    void* mem = mmap(nullptr, sizeof(RouteRegion), PROT_READ, MAP_SHARED, fd, 0);
+    if (mem != MAP_FAILED) g_routes = (const RouteRegion*)mem;
 }
 
 // ═══════════════════════════════════════════════════════════════════
-// Config Watcher Thread
+// Hook Controller Thread
 // ═══════════════════════════════════════════════════════════════════
+//
+// Installs and removes hooks when the enabled/hideDev switches or the override mask
+// change, so a process runs the original compiled getters for every field it does
+// not spoof. Sleeps on the shared page's sequence word; the companion wakes it
+// after each publish, to have the log ring flushed (`mockgpsconf logs`), and when a
+// hook call trace starts or stops. While one runs it also wakes every kTraceDrainMs
+// to drain the trace rings into the package's buffer.
+
+// Follow the companion's trace sampling; drains once more when a trace stops
+static bool followTrace(const ConfigSnapshot* shared) {
+#if MOCKGPS_TELEMETRY
+    if (!g_stats) return false;
+    uint32_t every = shared->traceEvery.load(std::memory_order_acquire);
+    if (every || g_traceSampleEvery.load(std::memory_order_relaxed)) {
+        g_traceSampleEvery.store(every, std::memory_order_relaxed);
+        drainTraceRings(traceBufferOf(g_stats), (uint32_t)getpid());
+    }
+    return every != 0;
+#else
+    (void)shared;
+    return false;
+#endif
+}
 
-static void* configWatcherThread(void* arg) {
+static void* hookControllerThread(void* arg) {
     (void)arg;
-    LOGD("Config watcher thread started");
+    const ConfigSnapshot* shared = g_activeConfig;
+    uint32_t seen = shared->seq.load(std::memory_order_acquire);
+    uint32_t flushSeen = shared->logFlush.load(std::memory_order_acquire);
+
+    // Catch up on anything published between postAppSpecialize and now
+    applyHookState(shared->load(), true);
+    bool tracing = followTrace(shared);
+    const struct timespec drainEvery = { 0, kTraceDrainMs * 1000000L };
 
     while (true) {
-        sleep(3);
+        futexWait(&shared->seq, seen, tracing ? &drainEvery : nullptr);  // returns at once if seq already moved
+        tracing = followTrace(shared);
+        uint32_t flush = shared->logFlush.load(std::memory_order_acquire);
+        if (flush != flushSeen) {
+            flushSeen = flush;
+            flushLogRing();
+        }
+        uint32_t now = shared->seq.load(std::memory_order_acquire);
+        if (now == seen) continue;      // spurious wakeup
+        seen = now;
+        if (now & 1) continue;          // write in flight; its completion wakes us again
+
+        MockConfig cfg = shared->load();
+        int changed = applyHookState(cfg, true);
+        if (changed) {
+            LOGI("Hooks updated live: %d methods, GPS=%s overrides=0x%x DevHide=%s", changed,
+                 cfg.enabled ? "ON" : "OFF", cfg.overrides, cfg.hideDev ? "ON" : "OFF");
+        }
+    }
+
+    return nullptr;
+}
 
-        int fd = open(CONFIG_PATH, O_RDONLY);
-        if (fd < 0) continue;
+// ═══════════════════════════════════════════════════════════════════
+// Process Classes
+// ═══════════════════════════════════════════════════════════════════
+//
+// Decided from the specialize args alone, before any IPC. Every class but kClassApp
+// can never reach the location APIs: isolated and SDK sandbox processes hold no
+// permissions, app zygotes only fork isolated children, and system UIDs are not
+// apps. Those unload without a companion round trip.
+
+enum ProcessClass : uint8_t {
+    kClassApp,           // regular app: the companion decides
+    kClassIsolated,      // isolated services, WebView renderers (app ids 90000-99999)
+    kClassAppZygote,     // app zygotes, the WebView zygote (is_child_zygote)
+    kClassSdkSandbox,    // SDK runtime processes (app ids 20000-29999)
+    kClassSystem,        // app ids below FIRST_APPLICATION_UID (phone, bluetooth, ...)
+    kProcessClassCount,
+};
 
-        char buf[1024];
-        int n = read(fd, buf, sizeof(buf) - 1);
-        close(fd);
-        if (n <= 0) continue;
+static constexpr const char* kProcessClassNames[kProcessClassCount] = {
+    "app", "isolated", "app zygote", "sdk sandbox", "system",
+};
 
-        buf[n] = 0;
-        MockConfig cfg = parseConfig(buf);
-        applyConfig(cfg);
-    }
+// Specializations seen per class; all but kClassApp are round trips avoided. Per
+// process on device (the library unloads right after), cumulative in the host harness.
+static std::atomic<uint32_t> g_processClassCounts[kProcessClassCount];
+
+static ProcessClass classifyProcess(const zygisk::AppSpecializeArgs* args) {
+    if (args->is_child_zygote && *args->is_child_zygote) return kClassAppZygote;
+    int appId = args->uid % 100000;   // AID_USER_OFFSET
+    if (appId >= 90000 && appId <= 99999) return kClassIsolated;
+    if (appId >= 20000 && appId <= 29999) return kClassSdkSandbox;
+    if (appId < 10000) return kClassSystem;
+    return kClassApp;
+}
 
-    return nullptr;
+// ═══════════════════════════════════════════════════════════════════
+// Per-App Profiles
+// ═══════════════════════════════════════════════════════════════════
+//
+// The companion keeps one config page per profile. A specializing process names
+// itself (nice_name, uid) and gets only the page of its own profile, or the defaults;
+// it never sees other apps' profiles.
+
+struct __attribute__((packed)) CompanionRequest {
+    RuntimeKey key;
+    int32_t    uid;
+    char       niceName[kProfileKeyMax];   // NUL-terminated, truncated; empty if unknown
+};
+
+static CompanionRequest makeCompanionRequest(JNIEnv* env, const zygisk::AppSpecializeArgs* args) {
+    CompanionRequest req = {};
+    req.key = runtimeKey(env);
+    req.uid = args->uid;
+    if (args->nice_name) {
+        const char* name = env->GetStringUTFChars(args->nice_name, nullptr);
+        if (name) {
+            strncpy(req.niceName, name, sizeof(req.niceName) - 1);
+            env->ReleaseStringUTFChars(args->nice_name, name);
+        }
+    }
+    return req;
 }
 
 // ═══════════════════════════════════════════════════════════════════
@@ -751,14 +1525,31 @@ public:
     }
 
     void preAppSpecialize(zygisk::AppSpecializeArgs* args) override {
+        ProcessClass cls = classifyProcess(args);
+        g_processClassCounts[cls].fetch_add(1, std::memory_order_relaxed);
+        if (cls != kClassApp) {
+            LOGD("%s process (uid %d), unloading without companion", kProcessClassNames[cls], args->uid);
+            api->setOption(zygisk::DLCLOSE_MODULE_LIBRARY);
+            return;
+        }
+
+        PHASE_TRACE(kPhasePreSpecialize);
+
         // Get config from companion (root daemon)
-        auto fd = api->connectCompanion();
+        CompanionRequest req = makeCompanionRequest(env, args);
+        ConfigPacket pkt = {};
+        int pageFd = -1;
+        int fd;
+        bool ok;
+        {
+            PHASE_TRACE(kPhaseCompanionWait);
+            fd = api->connectCompanion();
+            ok = fd >= 0 && send(fd, &req, sizeof(req), MSG_NOSIGNAL) == (ssize_t)sizeof(req) &&
+                 recvWithFd(fd, &pkt, sizeof(pkt), &pageFd);
+        }
         if (fd >= 0) {
-            ConfigPacket pkt = {};
-            int n = read(fd, &pkt, sizeof(pkt));
-            close(fd);
 
-            if (n == sizeof(pkt)) {
+            if (ok) {
                 MockConfig cfg;
                 cfg.enabled  = pkt.enabled;
                 cfg.lat      = pkt.lat;
@@ -768,57 +1559,99 @@ public:
                 cfg.speed    = pkt.speed;
                 cfg.bearing  = pkt.bearing;
                 cfg.hideDev  = pkt.hideDev;
+                cfg.overrides = pkt.overrides;
+                cfg.route    = pkt.route;
+                cfg.routeGen = pkt.routeGen;
                 applyConfig(cfg);
                 shouldHook = cfg.enabled || cfg.hideDev;
                 LOGD("Config received: enabled=%d lat=%.6f lng=%.6f hideDev=%d",
                      cfg.enabled, cfg.lat, cfg.lng, cfg.hideDev);
             }
+
+            // Map the companion's config page now; Zygisk closes our fds after this callback.
+            // Only trust it if it can no longer shrink (a truncated mapping would SIGBUS).
+            if (pageFd >= 0) {
+                int seals = fcntl(pageFd, F_GET_SEALS);
+                if (shouldHook && seals >= 0 && (seals & F_SEAL_SHRINK)) {
+                    void* page = mmap(nullptr, sizeof(ConfigSnapshot), PROT_READ, MAP_SHARED, pageFd, 0);
+                    if (page != MAP_FAILED) g_activeConfig = (const ConfigSnapshot*)page;
+                }
+                close(pageFd);
+            }
+
+            // Resolve hook targets here so postAppSpecialize only writes ArtMethods.
+            // The companion answers with this zygote's cached results, if any; a miss
+            // means we are the first child and report ours back on the same socket.
+            if (shouldHook) {
+                RouteGrant grant = {};
+                int routeFd = -1;
+                if (recvWithFd(fd, &grant, sizeof(grant), &routeFd) && routeFd >= 0) mapRouteRegion(routeFd, grant);
+                if (routeFd >= 0) close(routeFd);
+
+                RuntimeCache cache = {};
+                int statsFd = -1;
+                bool cached = recvWithFd(fd, &cache, sizeof(cache), &statsFd);
+                if (statsFd >= 0) {
+                    mapStatsPage(statsFd);
+                    close(statsFd);
+                }
+                if (cached && cache.valid) {
+                    PHASE_TRACE(kPhaseCacheAdopt);
+                    resolved = adoptRuntimeCache(cache, req.key);
+                }
+                if (!resolved) {
+                    resolved = detectRuntime(env);
+                    if (resolved && exportRuntimeCache(req.key, &cache)) {
+                        send(fd, &cache, sizeof(cache), MSG_NOSIGNAL);
+                    }
+                }
+                if (resolved) allocBackupArena();
+            }
+            close(fd);
         }
 
+        // No active profile: unload before any hook or thread exists
         if (!shouldHook) {
             api->setOption(zygisk::DLCLOSE_MODULE_LIBRARY);
         }
     }
 
-    void postAppSpecialize(const zygisk::AppSpecializeArgs* args) override {
+    void postAppSpecialize(const zygisk::AppSpecializeArgs*) override {
         if (!shouldHook) return;
-
-        LOGI("MockGPS activating in process");
-
-        // Detect ART layout
-        if (!detectArtMethodLayout(env)) {
-            LOGE("Failed to detect ArtMethod layout!");
+        if (!resolved) {
+            LOGE("Hook targets unresolved, MockGPS inactive");
             return;
         }
+        PHASE_TRACE(kPhasePostSpecialize);
 
-        // Find JNI trampoline
-        g_jniTrampoline = findJniTrampoline(env);
-        if (!g_jniTrampoline) {
-            LOGE("Failed to find JNI trampoline!");
-            return;
-        }
+        LOGI("MockGPS activating in process");
 
-        // Apply Location hooks
-        if (g_enabled.load()) {
-            hookLocationMethods(env);
+        MockConfig cfg = currentConfig();
+        {
+            PHASE_TRACE(kPhaseHookInstall);
+            applyHookState(cfg, false);
         }
 
-        // Apply Settings hooks (developer options)
-        if (g_hideDev.load()) {
-            hookSettingsMethods(env);
+        // Follow the companion's page so hooks can be removed and re-added live
+        if (g_activeConfig != &g_config) {
+            PHASE_TRACE(kPhaseControllerStart);
+            pthread_attr_t attr;
+            pthread_attr_init(&attr);
+            pthread_attr_setstacksize(&attr, 64 * 1024);
+            pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+            pthread_t tid;
+            pthread_create(&tid, &attr, hookControllerThread, nullptr);
+            pthread_attr_destroy(&attr);
+        } else {
+            LOGE("No shared config page - live updates disabled");
         }
 
-        // Start config watcher for live updates
-        pthread_t tid;
-        pthread_create(&tid, nullptr, configWatcherThread, nullptr);
-        pthread_detach(tid);
-
         LOGI("MockGPS fully active: GPS=%s DevHide=%s",
-             g_enabled.load() ? "ON" : "OFF",
-             g_hideDev.load() ? "ON" : "OFF");
+             cfg.enabled ? "ON" : "OFF",
+             cfg.hideDev ? "ON" : "OFF");
     }
 
-    void preServerSpecialize(zygisk::ServerSpecializeArgs* args) override {
+    void preServerSpecialize(zygisk::ServerSpecializeArgs*) override {
         // Don't hook system_server
         api->setOption(zygisk::DLCLOSE_MODULE_LIBRARY);
     }
@@ -827,27 +1660,565 @@ private:
     zygisk::Api* api = nullptr;
     JNIEnv* env = nullptr;
     bool shouldHook = false;
+    bool resolved = false;    // hook targets known (detected or from companion cache)
 };
 
 // ═══════════════════════════════════════════════════════════════════
 // Companion Handler (runs as root in Zygote's parent)
 // ═══════════════════════════════════════════════════════════════════
+//
+// State below lives for the lifetime of the companion daemon and is shared by
+// all handler invocations (which may run concurrently).
+
+static pthread_once_t  g_companionOnce = PTHREAD_ONCE_INIT;
+static int             g_pageFd        = -1;
+static ConfigSnapshot* g_page          = nullptr;
+
+// Detection results per zygote (zygote64, zygote, app zygotes); replaced round-robin
+static constexpr int   kRuntimeCacheSlots = 8;
+static RuntimeCache    g_runtimeCaches[kRuntimeCacheSlots];
+static int             g_runtimeCacheNext = 0;
+static pthread_mutex_t g_runtimeCacheLock = PTHREAD_MUTEX_INITIALIZER;
+
+static RuntimeCache lookupRuntimeCache(const RuntimeKey& key) {
+    RuntimeCache found = {};
+    pthread_mutex_lock(&g_runtimeCacheLock);
+    for (auto& c : g_runtimeCaches) {
+        if (c.valid && sameKey(c.key, key)) {
+            found = c;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_runtimeCacheLock);
+    return found;
+}
 
-static void companion_handler(int fd) {
-    // Read config file and send to child process
-    MockConfig cfg;
+static void storeRuntimeCache(const RuntimeCache& cache) {
+    pthread_mutex_lock(&g_runtimeCacheLock);
+    RuntimeCache* slot = nullptr;
+    for (auto& c : g_runtimeCaches) {
+        // Same zygote pid: either a duplicate report or a restarted zygote
+        if (c.valid && c.key.zygotePid == cache.key.zygotePid && c.key.ptrSize == cache.key.ptrSize) {
+            slot = &c;
+            break;
+        }
+    }
+    if (!slot) {
+        slot = &g_runtimeCaches[g_runtimeCacheNext];
+        g_runtimeCacheNext = (g_runtimeCacheNext + 1) % kRuntimeCacheSlots;
+    }
+    *slot = cache;
+    pthread_mutex_unlock(&g_runtimeCacheLock);
+    LOGD("Runtime data cached for zygote %llu", (unsigned long long)cache.key.zygotePid);
+}
+
+static int createConfigPage(ConfigSnapshot** page);
+
+// route.bin as last published into the route region. g_routeGen is the publish the
+// configs play (0 while there is no valid route); it and the rest are only used from
+// companionInit() before any thread exists, then under g_reloadLock.
+static int          g_routeFd        = -1;
+static RouteRegion* g_routeRegion    = nullptr;
+static uint32_t     g_routeGen       = 0;
+static uint32_t     g_routePublishes = 0;
+static struct stat  g_routeStat      = {};
+static bool         g_routePlaying   = false;   // some config had route=1 at the last publish
+
+static bool sameFile(const struct stat& a, const struct stat& b) {
+    return a.st_ino == b.st_ino && a.st_dev == b.st_dev && a.st_size == b.st_size &&
+           a.st_mtim.tv_sec == b.st_mtim.tv_sec && a.st_mtim.tv_nsec == b.st_mtim.tv_nsec;
+}
+
+// Publish route.bin into the region if it changed; returns whether the route the
+// configs should play changed. A rejected file keeps the last good route, like a
+// rejected location.bin; a removed one stops playback.
+static bool loadRoute() {
+    if (!g_routeRegion) return false;
+    struct stat st;
+    if (stat(ROUTE_PATH, &st) != 0) {
+        g_routeStat = {};
+        if (!g_routeGen) return false;
+        g_routeGen = 0;
+        LOGI("Route removed");
+        return true;
+    }
+    if (sameFile(st, g_routeStat)) return false;
+
+    std::vector<uint8_t> image;
+    if (loadRouteFile(ROUTE_PATH, &image) != ConfigLoad::kOk) {
+        LOGE("Rejected %s: bad header, checksum or points", ROUTE_PATH);
+        return false;
+    }
+    g_routeStat = st;
+    g_routeGen  = ++g_routePublishes;
+    publishRoute(g_routeRegion, g_routeGen, image.data(), image.size(), statsClockNs(CLOCK_BOOTTIME));
+    RouteFileHeader head;
+    memcpy(&head, image.data(), sizeof(head));
+    LOGI("Route published: %u points, %u s, %.1f km", head.points, head.durationMs / 1000, head.distanceDm / 1e4);
+    return true;
+}
+
+// One page per profile key seen since the daemon started. Slot 0 holds the defaults
+// (g_page). A slot stays bound to its key for the daemon's lifetime, so processes
+// already mapping it follow later edits; a profile removed from the config reverts
+// its page to the defaults. g_profileLock guards the slot list and the table; pages
+// are only written by publishConfig(), under g_reloadLock once threads run.
+struct ProfileSlot {
+    std::string     key;
+    int             fd;       // -1 if the page could not be shared
+    ConfigSnapshot* page;
+};
+
+static constexpr size_t  kMaxProfileSlots = 1024;
+static std::vector<ProfileSlot> g_profileSlots;
+static ProfileTable      g_profileTable;          // current profile keys -> slot
+static pthread_mutex_t   g_profileLock = PTHREAD_MUTEX_INITIALIZER;
+static std::atomic<uint32_t> g_traceEvery{0};     // copied to new pages, see beginTraceSession()
+
+static size_t profileSlotFor(const std::string& key) {
+    for (size_t i = 1; i < g_profileSlots.size(); i++) {
+        if (g_profileSlots[i].key == key) return i;
+    }
+    if (g_profileSlots.size() >= kMaxProfileSlots) return 0;
+
+    ConfigSnapshot* page = nullptr;
+    int fd = createConfigPage(&page);
+    if (fd < 0) page = new ConfigSnapshot();
+    page->traceEvery.store(g_traceEvery.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    g_profileSlots.push_back(ProfileSlot{key, fd, page});
+    return g_profileSlots.size() - 1;
+}
+
+// Called from companionInit() before any thread exists, then only under
+// g_reloadLock. Returns the number of pages woken.
+static size_t publishConfig(const ConfigSet& set) {
+    std::vector<std::string> keys;
+    std::vector<uint16_t> slots;
+
+    pthread_mutex_lock(&g_profileLock);
+    if (g_profileSlots.empty()) g_profileSlots.push_back(ProfileSlot{std::string(), g_pageFd, g_page});
+    for (const auto& p : set.profiles) {
+        size_t slot = profileSlotFor(p.key);
+        if (!slot) {
+            LOGE("Too many profiles, [%s] uses the defaults", p.key.c_str());
+            continue;
+        }
+        keys.push_back(p.key);
+        slots.push_back((uint16_t)slot);
+    }
+    if (!g_profileTable.build(keys, slots)) LOGE("Profile table build failed, profiles ignored");
+
+    // Playback restarts when a route is turned on while no config plays one
+    bool playing = set.defaults.route;
+    for (const auto& p : set.profiles) playing |= resolveProfile(set.defaults, p).route;
+    if (playing && !g_routePlaying && g_routeGen) {
+        restartRoute(g_routeRegion, g_routeGen, statsClockNs(CLOCK_BOOTTIME));
+    }
+    g_routePlaying = playing;
+
+    for (size_t i = 0; i < g_profileSlots.size(); i++) {
+        const ConfigProfile* p = i ? findProfile(set, g_profileSlots[i].key) : nullptr;
+        MockConfig cfg = p ? resolveProfile(set.defaults, *p) : set.defaults;
+        cfg.routeGen = cfg.route ? g_routeGen : 0;
+        g_profileSlots[i].page->store(cfg);
+    }
+    pthread_mutex_unlock(&g_profileLock);
+
+    // The slot list only grows in here, so it is safe to walk unlocked
+    for (const auto& s : g_profileSlots) futexWake(&s.page->seq);
+    LOGD("Config published: enabled=%d lat=%.6f lng=%.6f hideDev=%d, %zu profile(s)",
+         set.defaults.enabled, set.defaults.lat, set.defaults.lng, set.defaults.hideDev, keys.size());
+    return g_profileSlots.size();
+}
 
-    int cfd = open(CONFIG_PATH, O_RDONLY);
-    if (cfd >= 0) {
-        char buf[1024];
-        int n = read(cfd, buf, sizeof(buf) - 1);
-        close(cfd);
-        if (n > 0) {
-            buf[n] = 0;
-            cfg = parseConfig(buf);
+// Serializes reading the config and route files with publishing them: the watcher
+// thread reloads on inotify events, the stats thread when `mockgpsctl` asks
+// (kStatsCmdReload). The image last published lets the second of the two, for the
+// same rename, wake no one.
+static pthread_mutex_t      g_reloadLock = PTHREAD_MUTEX_INITIALIZER;
+static std::vector<uint8_t> g_publishedImage;
+
+// Pages woken; 0 if the files are unreadable or unchanged
+static size_t reloadConfig() {
+    ConfigSet set;
+    size_t woken = 0;
+    pthread_mutex_lock(&g_reloadLock);
+    bool routeChanged = loadRoute();
+    if (readConfigFile(&set)) {
+        std::vector<uint8_t> image = encodeConfigFile(set);
+        if (image.empty() || image != g_publishedImage || routeChanged) {
+            woken = publishConfig(set);
+            g_publishedImage = std::move(image);
         }
+    } else if (routeChanged && decodeConfigFile(g_publishedImage.data(), g_publishedImage.size(), &set)) {
+        // The last good config, now with the new route
+        woken = publishConfig(set);
     }
+    pthread_mutex_unlock(&g_reloadLock);
+    return woken;
+}
 
+// Page for a connecting process: its process name, then its package (the name up
+// to ':'), then "uid:<uid>" and "uid:<app id>"; the defaults if none is a profile
+static void findProfilePage(const CompanionRequest& req, int* fd, const ConfigSnapshot** page) {
+    char name[sizeof(req.niceName)];
+    memcpy(name, req.niceName, sizeof(name));
+    name[sizeof(name) - 1] = 0;
+    std::string_view process(name);
+    std::string_view package = process.substr(0, process.find(':'));
+    char uidKey[16], appIdKey[16];
+    snprintf(uidKey, sizeof(uidKey), "uid:%d", req.uid);
+    snprintf(appIdKey, sizeof(appIdKey), "uid:%d", req.uid % 100000);
+
+    pthread_mutex_lock(&g_profileLock);
+    int slot = g_profileTable.find(process);
+    if (slot < 0) slot = g_profileTable.find(package);
+    if (slot < 0) slot = g_profileTable.find(uidKey);
+    if (slot < 0) slot = g_profileTable.find(appIdKey);
+    const ProfileSlot& s = g_profileSlots[slot < 0 ? 0 : slot];
+    *fd   = s.fd;
+    *page = s.page;
+    pthread_mutex_unlock(&g_profileLock);
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Hook Telemetry
+// ═══════════════════════════════════════════════════════════════════
+//
+// One StatsPage per package (the process name up to ':', or "uid:<uid>" for a
+// process without one), handed to every hooked process of the package with its
+// runtime cache. Processes add to the page; the companion only reads it, when
+// `mockgpsconf stats` connects to the stats socket.
+
+struct StatsSlot {
+    std::string key;
+    int         fd;
+    StatsPage*  page;
+};
+
+static constexpr size_t      kMaxStatsSlots = 256;
+static std::vector<StatsSlot> g_statsSlots;
+static pthread_mutex_t       g_statsLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Writable by every holder, so only resizing is sealed
+static int createStatsPage(StatsPage** page) {
+    int fd = memfdCreate("mockgps-stats", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) return -1;
+
+    void* mem = MAP_FAILED;
+    if (ftruncate(fd, kStatsRegionSize) == 0) {
+        mem = mmap(nullptr, kStatsRegionSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (mem == MAP_FAILED || fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0) {
+        if (mem != MAP_FAILED) munmap(mem, kStatsRegionSize);
+        close(fd);
+        return -1;
+    }
+
+    // memfd pages start zeroed, which is every counter's initial value
+    *page = (StatsPage*)mem;
+    (*page)->magic     = kStatsMagic;
+    (*page)->version   = kStatsVersion;
+    (*page)->createdNs = statsClockNs(CLOCK_BOOTTIME);
+    return fd;
+}
+
+// Stats page fd for a hooked process, counted as one more process of its package;
+// -1 without telemetry or once kMaxStatsSlots packages have pages
+static int statsPageFor(const CompanionRequest& req) {
+    if (!MOCKGPS_TELEMETRY) return -1;
+    char name[sizeof(req.niceName)];
+    memcpy(name, req.niceName, sizeof(name));
+    name[sizeof(name) - 1] = 0;
+    std::string key(name, strcspn(name, ":"));
+    if (key.empty()) key = "uid:" + std::to_string(req.uid);
+
+    int fd = -1;
+    pthread_mutex_lock(&g_statsLock);
+    StatsSlot* slot = nullptr;
+    for (auto& s : g_statsSlots) {
+        if (s.key == key) {
+            slot = &s;
+            break;
+        }
+    }
+    if (!slot && g_statsSlots.size() < kMaxStatsSlots) {
+        StatsPage* page = nullptr;
+        int pageFd = createStatsPage(&page);
+        if (pageFd >= 0) {
+            g_statsSlots.push_back(StatsSlot{key, pageFd, page});
+            slot = &g_statsSlots.back();
+        }
+    }
+    if (slot) {
+        slot->page->processes.fetch_add(1, std::memory_order_relaxed);
+        fd = slot->fd;
+    }
+    pthread_mutex_unlock(&g_statsLock);
+    return fd;
+}
+
+static void sendStatsReport(int fd) {
+    std::vector<StatsRecord> records;
+    pthread_mutex_lock(&g_statsLock);
+    records.resize(g_statsSlots.size());
+    for (size_t i = 0; i < g_statsSlots.size(); i++) {
+        snapshotStats(g_statsSlots[i].key.c_str(), *g_statsSlots[i].page, &records[i]);
+    }
+    pthread_mutex_unlock(&g_statsLock);
+
+    StatsReportHeader header = { kStatsMagic, kStatsVersion, (uint32_t)records.size(), sizeof(StatsRecord) };
+    if (send(fd, &header, sizeof(header), MSG_NOSIGNAL) == (ssize_t)sizeof(header) && !records.empty()) {
+        send(fd, records.data(), records.size() * sizeof(StatsRecord), MSG_NOSIGNAL);
+    }
+}
+
+// Flush the companion's own log ring and wake every process on every config page
+// to flush theirs; the reply counts the pages
+static void requestLogFlush(int fd) {
+    flushLogRing();
+    pthread_mutex_lock(&g_profileLock);
+    for (const auto& s : g_profileSlots) {
+        s.page->logFlush.fetch_add(1, std::memory_order_release);
+        futexWake(&s.page->seq);
+    }
+    StatsReportHeader header = { kStatsMagic, kStatsVersion, (uint32_t)g_profileSlots.size(), 0 };
+    pthread_mutex_unlock(&g_profileLock);
+    send(fd, &header, sizeof(header), MSG_NOSIGNAL);
+}
+
+// Publish the config file now rather than on its inotify event, then reply: the
+// caller (`mockgpsctl`) returns only once every process can see the change
+static void reloadForClient(int fd) {
+    StatsReportHeader header = { kStatsMagic, kStatsVersion, (uint32_t)reloadConfig(), 0 };
+    send(fd, &header, sizeof(header), MSG_NOSIGNAL);
+}
+
+// Hook call trace session (trace.hpp), started and stopped by the stats thread only
+static uint64_t g_traceStartNs = 0;
+
+static void setTraceEvery(uint32_t every) {
+    g_traceEvery.store(every, std::memory_order_relaxed);
+    pthread_mutex_lock(&g_profileLock);
+    for (const auto& s : g_profileSlots) {
+        s.page->traceEvery.store(every, std::memory_order_release);
+        futexWake(&s.page->seq);
+    }
+    pthread_mutex_unlock(&g_profileLock);
+}
+
+// Clear every package's trace buffer and have every process sample one hook call
+// in `every` per thread; restarts a session already running
+static void beginTraceSession(int fd, uint32_t every) {
+    pthread_mutex_lock(&g_statsLock);
+    for (const auto& s : g_statsSlots) clearTraceBuffer(traceBufferOf(s.page));
+    pthread_mutex_unlock(&g_statsLock);
+    g_traceStartNs = statsClockNs(CLOCK_BOOTTIME);
+    setTraceEvery(every ? every : 1);
+    LOGI("Hook trace started, 1 in %u calls", every ? every : 1);
+
+    StatsReportHeader header = { kStatsMagic, kStatsVersion, 0, 0 };
+    send(fd, &header, sizeof(header), MSG_NOSIGNAL);
+}
+
+// Stop sampling, give the controller threads time for their last drain, then send
+// the trace file: a header whose count is its size, and the file
+static void endTraceSession(int fd) {
+    uint32_t every = g_traceEvery.load(std::memory_order_relaxed);
+    setTraceEvery(0);
+    usleep(2 * kTraceDrainMs * 1000);
+
+    TraceFileHeader file = { kTraceMagic, kTraceVersion, 0, every, g_traceStartNs, statsClockNs(CLOCK_BOOTTIME) };
+    std::vector<char> out(sizeof(file));
+    std::vector<TraceEvent> events;
+    pthread_mutex_lock(&g_statsLock);
+    for (const auto& s : g_statsSlots) {
+        const TraceBuffer& buf = *traceBufferOf(s.page);
+        events.clear();
+        TracePackage pkg = {};
+        strncpy(pkg.key, s.key.c_str(), sizeof(pkg.key) - 1);
+        pkg.events = collectTraceBuffer(buf, &events);
+        pkg.dropped = buf.dropped.load(std::memory_order_relaxed);
+        if (!pkg.events && !pkg.dropped) continue;
+        out.insert(out.end(), (const char*)&pkg, (const char*)(&pkg + 1));
+        out.insert(out.end(), (const char*)events.data(), (const char*)(events.data() + events.size()));
+        file.packages++;
+    }
+    pthread_mutex_unlock(&g_statsLock);
+    memcpy(out.data(), &file, sizeof(file));
+    LOGI("Hook trace stopped: %u package(s), %zu bytes", file.packages, out.size());
+
+    StatsReportHeader header = { kStatsMagic, kStatsVersion, (uint32_t)out.size(), 0 };
+    if (send(fd, &header, sizeof(header), MSG_NOSIGNAL) == (ssize_t)sizeof(header)) {
+        send(fd, out.data(), out.size(), MSG_NOSIGNAL);
+    }
+}
+
+// Serves one StatsCommand per connection on the abstract stats socket, then closes
+// it. Only root (or the companion's own uid) may connect.
+static void* companionStatsThread(void* arg) {
+    int sock = (int)(intptr_t)arg;
+    while (true) {
+        int fd = accept4(sock, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            LOGE("Stats socket accept failed: %s", strerror(errno));
+            break;
+        }
+
+        struct ucred cred = {};
+        socklen_t len = sizeof(cred);
+        if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0 && (cred.uid == 0 || cred.uid == getuid())) {
+            // A client that stalls must not hold up the next one
+            struct timeval timeout = { 1, 0 };
+            setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            StatsRequest req = {};
+            if (recv(fd, &req, sizeof(req), MSG_WAITALL) == (ssize_t)sizeof(req) && req.magic == kStatsMagic) {
+                if (req.command == kStatsCmdReport) sendStatsReport(fd);
+                if (req.command == kStatsCmdFlushLogs) requestLogFlush(fd);
+                if (req.command == kStatsCmdTraceStart) beginTraceSession(fd, req.arg);
+                if (req.command == kStatsCmdTraceStop) endTraceSession(fd);
+                if (req.command == kStatsCmdReload) reloadForClient(fd);
+            }
+        }
+        close(fd);
+    }
+    close(sock);
+    return nullptr;
+}
+
+static void startStatsServer() {
+    int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_un addr;
+    socklen_t len = statsSocketAddress(&addr);
+    if (sock < 0 || bind(sock, (struct sockaddr*)&addr, len) < 0 || listen(sock, 4) < 0) {
+        LOGE("Stats socket unavailable: %s", strerror(errno));
+        if (sock >= 0) close(sock);
+        return;
+    }
+    pthread_t tid;
+    if (pthread_create(&tid, nullptr, companionStatsThread, (void*)(intptr_t)sock) != 0) {
+        close(sock);
+        return;
+    }
+    pthread_detach(tid);
+}
+
+// Single inotify watch on the module directory. Watching the directory (not the
+// file) also catches the config being created or replaced by rename.
+static void* companionWatcherThread(void* arg) {
+    (void)arg;
+
+    int ifd = inotify_init1(IN_CLOEXEC);
+    if (ifd < 0) {
+        LOGE("inotify_init1 failed: %s", strerror(errno));
+        return nullptr;
+    }
+    if (inotify_add_watch(ifd, CONFIG_DIR, IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE) < 0) {
+        LOGE("inotify_add_watch(%s) failed: %s", CONFIG_DIR, strerror(errno));
+        close(ifd);
+        return nullptr;
+    }
+
+    alignas(struct inotify_event) char buf[4096];
+    while (true) {
+        ssize_t n = read(ifd, buf, sizeof(buf));
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            break;
+        }
+
+        bool changed = false;
+        for (char* p = buf; p < buf + n; ) {
+            auto* ev = (struct inotify_event*)p;
+            if (ev->len && (!strcmp(ev->name, CONFIG_BIN_NAME) || !strcmp(ev->name, CONFIG_NAME) ||
+                            !strcmp(ev->name, ROUTE_NAME))) {
+                changed = true;
+            }
+            p += sizeof(struct inotify_event) + ev->len;
+        }
+        if (changed) reloadConfig();
+    }
+
+    LOGE("Config watcher stopped");
+    close(ifd);
+    return nullptr;
+}
+
+// Create a region the companion writes and hooked processes read: size it, keep our
+// own writable mapping, then seal it so receivers can neither resize it nor (on 5.1+
+// kernels) map it writable
+static int createReadOnlyRegion(const char* name, size_t size, void** mem) {
+    int fd = memfdCreate(name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) return -1;
+
+    void* m = MAP_FAILED;
+    if (ftruncate(fd, size) == 0) {
+        m = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (m == MAP_FAILED) {
+        close(fd);
+        return -1;
+    }
+
+    const int seals = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL;
+    if (fcntl(fd, F_ADD_SEALS, seals | F_SEAL_FUTURE_WRITE) < 0 &&
+        fcntl(fd, F_ADD_SEALS, seals) < 0) {
+        munmap(m, size);
+        close(fd);
+        return -1;
+    }
+    *mem = m;
+    return fd;
+}
+
+static int createConfigPage(ConfigSnapshot** page) {
+    void* mem;
+    int fd = createReadOnlyRegion("mockgps-config", sizeof(ConfigSnapshot), &mem);
+    if (fd >= 0) *page = new (mem) ConfigSnapshot();
+    return fd;
+}
+
+static void startCompanionServer();
+
+static void companionInit() {
+    g_pageFd = createConfigPage(&g_page);
+    if (g_pageFd < 0) {
+        LOGE("Shared config page unavailable: %s", strerror(errno));
+    }
+
+    if (!g_page) {
+        // Still serve one-shot configs from a private snapshot
+        g_page = new ConfigSnapshot();
+    }
+
+    // memfd pages are zero, so both slots start empty (gen 0); only pages a route
+    // is copied into get memory
+    void* routes;
+    g_routeFd = createReadOnlyRegion("mockgps-route", sizeof(RouteRegion), &routes);
+    if (g_routeFd >= 0) {
+        g_routeRegion = (RouteRegion*)routes;
+    } else {
+        LOGE("Route region unavailable, routes will not play: %s", strerror(errno));
+    }
+
+    ConfigSet set;
+    loadRoute();
+    readConfigFile(&set);
+    publishConfig(set);
+    g_publishedImage = encodeConfigFile(set);
+
+    pthread_t tid;
+    if (pthread_create(&tid, nullptr, companionWatcherThread, nullptr) == 0) {
+        pthread_detach(tid);
+    }
+
+    startCompanionServer();
+    startStatsServer();
+}
+
+static ConfigPacket makeConfigPacket(const MockConfig& cfg) {
     ConfigPacket pkt = {};
     pkt.enabled  = cfg.enabled ? 1 : 0;
     pkt.lat      = cfg.lat;
@@ -857,8 +2228,150 @@ static void companion_handler(int fd) {
     pkt.speed    = cfg.speed;
     pkt.bearing  = cfg.bearing;
     pkt.hideDev  = cfg.hideDev ? 1 : 0;
+    pkt.overrides = cfg.overrides;
+    pkt.route    = cfg.route ? 1 : 0;
+    pkt.routeGen = cfg.routeGen;
+    return pkt;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Companion Server
+// ═══════════════════════════════════════════════════════════════════
+//
+// Zygisk runs companion_handler on a new thread for every connecting process, and at
+// boot dozens of processes specialize at once, each blocked in preAppSpecialize until
+// its reply is complete. Clients send their request right after connecting, so the
+// handler answers on its own thread from the in-memory snapshot (no file access, no
+// parsing) without waiting. A connection that has to wait for the client, mostly
+// the first child of a zygote running detection before it reports back, is parked
+// on a single epoll thread instead of holding a handler thread until then.
+
+struct CompanionConn {
+    int          fd;
+    bool         awaitingReport;   // request answered with a cache miss; report comes next
+    size_t       got;              // bytes of the current message received so far
+    CompanionRequest req;
+    RuntimeCache report;
+};
+
+static int g_epollFd = -1;
+
+// Read what is available of a fixed-size message; false on EOF or error
+static bool recvPartial(int fd, void* buf, size_t len, size_t* got) {
+    ssize_t n = recv(fd, (char*)buf + *got, len - *got, MSG_DONTWAIT);
+    if (n > 0) {
+        *got += n;
+        return true;
+    }
+    return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+}
+
+// Advance one connection without blocking; false once it is finished or broken.
+// Replies are a few hundred bytes and always fit an empty socket buffer.
+static bool serveCompanionConn(CompanionConn* c) {
+    if (!c->awaitingReport) {
+        if (!recvPartial(c->fd, &c->req, sizeof(c->req), &c->got)) return false;
+        if (c->got < sizeof(c->req)) return true;
+
+        // Serve the process's own profile from memory; the file is only parsed by the watcher
+        int pageFd;
+        const ConfigSnapshot* page;
+        findProfilePage(c->req, &pageFd, &page);
+        MockConfig cfg = page->load();
+        ConfigPacket pkt = makeConfigPacket(cfg);
+        if (!sendWithFd(c->fd, &pkt, sizeof(pkt), pageFd)) return false;
+        if (!cfg.enabled && !cfg.hideDev) return false;  // client unloads without reading further
+
+        // The route region goes to every hooking process: a route may be turned on later
+        RouteGrant grant = { g_routeFd >= 0 ? (uint32_t)sizeof(RouteRegion) : 0 };
+        if (!sendWithFd(c->fd, &grant, sizeof(grant), g_routeFd)) return false;
+
+        // Hand out this zygote's detection results, with the package's stats page; on a
+        // miss, wait for the client's report
+        RuntimeCache cache = lookupRuntimeCache(c->req.key);
+        if (!sendWithFd(c->fd, &cache, sizeof(cache), statsPageFor(c->req)) || cache.valid) {
+            return false;
+        }
+        c->awaitingReport = true;
+        c->got = 0;
+        return true;
+    }
+
+    if (!recvPartial(c->fd, &c->report, sizeof(c->report), &c->got)) return false;
+    if (c->got < sizeof(c->report)) return true;
+    if (c->report.valid && sameKey(c->report.key, c->req.key)) storeRuntimeCache(c->report);
+    return false;
+}
+
+// Serve a connection to completion on the calling thread
+static void serveCompanionInline(CompanionConn* c) {
+    struct pollfd pfd = { c->fd, POLLIN, 0 };
+    while (serveCompanionConn(c)) poll(&pfd, 1, -1);
+}
+
+static void* companionServerThread(void* arg) {
+    (void)arg;
+    struct epoll_event events[32];
+    while (true) {
+        int n = epoll_wait(g_epollFd, events, 32, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            LOGE("epoll_wait failed: %s", strerror(errno));
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            auto* c = (CompanionConn*)events[i].data.ptr;
+            if (serveCompanionConn(c)) continue;
+            // Zygisk may still hold the original fd, so deregister explicitly
+            epoll_ctl(g_epollFd, EPOLL_CTL_DEL, c->fd, nullptr);
+            close(c->fd);
+            delete c;
+        }
+    }
+    return nullptr;
+}
+
+static void startCompanionServer() {
+    g_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (g_epollFd < 0) {
+        LOGE("epoll_create1 failed: %s, companion connections served inline", strerror(errno));
+        return;
+    }
+    pthread_t tid;
+    if (pthread_create(&tid, nullptr, companionServerThread, nullptr) != 0) {
+        LOGE("Companion server thread not started, connections served inline");
+        close(g_epollFd);
+        g_epollFd = -1;
+        return;
+    }
+    pthread_detach(tid);
+}
+
+// Move a waiting connection to the epoll server; Zygisk closes `c.fd` when the
+// handler returns, so the server gets a duplicate. False if it could not be parked.
+static bool parkCompanionConn(const CompanionConn& c) {
+    if (g_epollFd < 0) return false;
+    auto* parked = new (std::nothrow) CompanionConn(c);
+    if (!parked) return false;
+    parked->fd = fcntl(c.fd, F_DUPFD_CLOEXEC, 0);
+    if (parked->fd >= 0) {
+        struct epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.ptr = parked;
+        if (epoll_ctl(g_epollFd, EPOLL_CTL_ADD, parked->fd, &ev) == 0) return true;
+        close(parked->fd);
+    }
+    delete parked;
+    return false;
+}
+
+static void companion_handler(int fd) {
+    pthread_once(&g_companionOnce, companionInit);
 
-    write(fd, &pkt, sizeof(pkt));
+    CompanionConn conn = {};
+    conn.fd = fd;
+    if (!serveCompanionConn(&conn)) return;
+    if (!parkCompanionConn(conn)) serveCompanionInline(&conn);
 }
 
 REGISTER_ZYGISK_MODULE(MockGPSModule)
@@ -8,11 +8,25 @@ ui_print "  MockGPS v2.0.0"
 ui_print "  GPS Spoofing + Dev Options Hide"
 ui_print "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━"
 
-# Create default config if not exists
-CONFIG="/data/adb/modules/mockgps/location.conf"
-if [ ! -f "$CONFIG" ]; then
+# Config tools for this device's ABI: mockgpsconf (text <-> location.bin) and
+# mockgpsctl (live changes, used by the UIs)
+TOOL="$MODPATH/bin/mockgpsconf"
+for t in mockgpsconf mockgpsctl; do
+    if [ -f "$MODPATH/bin/$ABI/$t" ]; then
+        cp "$MODPATH/bin/$ABI/$t" "$MODPATH/bin/$t"
+        chmod 0755 "$MODPATH/bin/$t"
+    fi
+done
+rm -rf "$MODPATH"/bin/*/
+
+# Create default config if not exists, importing a text config from older versions
+CONFIG="/data/adb/modules/mockgps/location.bin"
+LEGACY="/data/adb/modules/mockgps/location.conf"
+if [ ! -f "$CONFIG" ] && [ -f "$LEGACY" ]; then
+    "$TOOL" import "$LEGACY" && ui_print "  Imported location.conf"
+elif [ ! -f "$CONFIG" ]; then
     mkdir -p /data/adb/modules/mockgps
-    cat > "$CONFIG" <<'EOF'
+    "$TOOL" import <<'EOF'
 enabled=0
 lat=0.0
 lng=0.0
@@ -22,7 +36,6 @@ speed=0.0
 bearing=0.0
 hidedev=1
 EOF
-    chmod 0644 "$CONFIG"
     ui_print "  Created default config"
 fi
 
@@ -31,10 +44,13 @@ set_perm_recursive $MODDIR 0 0 0755 0644
 for f in $MODDIR/zygisk/*.so; do
     [ -f "$f" ] && chmod 0644 "$f"
 done
+for t in mockgpsconf mockgpsctl; do
+    [ -f "$MODPATH/bin/$t" ] && chmod 0755 "$MODPATH/bin/$t"
+done
 
 ui_print ""
 ui_print "  Install companion app for map UI"
-ui_print "  Config: $CONFIG"
+ui_print "  Config: $CONFIG (edit with bin/mockgpsconf)"
 ui_print ""
 ui_print "  Reboot to activate"
 ui_print "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━"
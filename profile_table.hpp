@@ -0,0 +1,171 @@
+// MockGPS - Profile lookup table
+//
+// Maps profile keys (process names, package names, "uid:<n>") to small integers. The
+// companion rebuilds it whenever the config changes and queries it on every app
+// launch, so lookups are a perfect hash: one hash of the key, one displacement per
+// bucket, one key compare, no probing.
+//
+// Construction is hash-and-displace: keys are grouped into buckets by one part of
+// their hash, and each bucket (largest first) searches for a displacement d that
+// sends all its keys to free slots via (a + d * b) mod M. M is a power of two and
+// b is odd, so the d values walk every slot; a bucket whose keys share (a, b) mod M
+// can never separate and triggers a new seed.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Eight bytes per step, then a 64-bit finalizer (fmix64) so every input bit reaches
+// the bucket and slot bits
+inline uint64_t profileKeyHash(std::string_view key, uint64_t seed) {
+    const char* p = key.data();
+    size_t n = key.size();
+    uint64_t h = (0xcbf29ce484222325ull ^ seed) + n * 0x9e3779b97f4a7c15ull;
+    for (; n >= 8; p += 8, n -= 8) {
+        uint64_t w;
+        memcpy(&w, p, 8);
+        h = (h ^ w) * 0xff51afd7ed558ccdull;
+        h ^= h >> 29;
+    }
+    if (n) {
+        uint64_t w = 0;
+        // By hand: a variable-length memcpy is a libc call here
+        for (size_t i = 0; i < n; i++) w |= (uint64_t)(unsigned char)p[i] << (8 * i);
+        h = (h ^ w) * 0xff51afd7ed558ccdull;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+class ProfileTable {
+public:
+    // Build from unique, non-empty keys; values[i] is returned for keys[i].
+    // False (table left empty) if a key is empty or repeated.
+    bool build(const std::vector<std::string>& keys, const std::vector<uint16_t>& values) {
+        clear();
+        const size_t n = keys.size();
+        if (n == 0) return true;
+
+        std::vector<std::string_view> sorted(keys.begin(), keys.end());
+        std::sort(sorted.begin(), sorted.end());
+        if (sorted.front().empty() || std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) return false;
+        for (size_t i = 0; i < n; i++) {
+            if (keys[i].size() > UINT16_MAX) return false;
+            strings_.append(keys[i]);
+        }
+
+        uint32_t slots = 1;
+        while (slots < n + n / 4) slots <<= 1;
+        uint32_t buckets = 1;
+        while (buckets < (n + 1) / 2) buckets <<= 1;
+
+        for (uint64_t attempt = 0; attempt < 64; attempt++) {
+            if (attempt && attempt % 16 == 0) slots <<= 1;  // crowded: give the search room
+            if (place(keys, values, attempt * 0x9e3779b97f4a7c15ull, buckets, slots)) return true;
+        }
+        clear();
+        return false;
+    }
+
+    // Value stored for `key`, or -1
+    int find(std::string_view key) const {
+        if (entries_.empty() || key.empty()) return -1;
+        uint64_t h = profileKeyHash(key, seed_);
+        const Entry& e = entries_[slotFor(h, displace_[bucketFor(h)])];
+        if (e.keyLen != key.size() || memcmp(strings_.data() + e.keyOffset, key.data(), key.size())) return -1;
+        return e.value;
+    }
+
+    size_t size() const { return count_; }
+
+    void clear() {
+        seed_ = 0;
+        count_ = 0;
+        bucketMask_ = slotMask_ = 0;
+        displace_.clear();
+        entries_.clear();
+        strings_.clear();
+    }
+
+private:
+    struct Entry {
+        uint32_t keyOffset;
+        uint16_t keyLen;    // 0: empty slot
+        uint16_t value;
+    };
+
+    uint32_t bucketFor(uint64_t h) const { return (uint32_t)(h >> 40) & bucketMask_; }
+
+    uint32_t slotFor(uint64_t h, uint32_t d) const {
+        uint32_t a = (uint32_t)h;
+        uint32_t b = (uint32_t)(h >> 20) | 1;
+        return (a + d * b) & slotMask_;
+    }
+
+    bool place(const std::vector<std::string>& keys, const std::vector<uint16_t>& values, uint64_t seed,
+               uint32_t buckets, uint32_t slots) {
+        seed_ = seed;
+        bucketMask_ = buckets - 1;
+        slotMask_ = slots - 1;
+        displace_.assign(buckets, 0);
+        entries_.assign(slots, Entry{0, 0, 0});
+
+        std::vector<uint64_t> hashes(keys.size());
+        std::vector<std::vector<uint32_t>> members(buckets);
+        for (uint32_t i = 0; i < keys.size(); i++) {
+            hashes[i] = profileKeyHash(keys[i], seed);
+            members[bucketFor(hashes[i])].push_back(i);
+        }
+        std::vector<uint32_t> order(buckets);
+        for (uint32_t b = 0; b < buckets; b++) order[b] = b;
+        std::stable_sort(order.begin(), order.end(),
+                         [&](uint32_t x, uint32_t y) { return members[x].size() > members[y].size(); });
+
+        std::vector<uint32_t> offsets(keys.size());
+        for (uint32_t i = 0, off = 0; i < keys.size(); off += (uint32_t)keys[i].size(), i++) offsets[i] = off;
+
+        std::vector<uint32_t> taken;
+        for (uint32_t b : order) {
+            const auto& m = members[b];
+            if (m.empty()) break;
+            bool placed = false;
+            for (uint32_t d = 0; d < slots && !placed; d++) {
+                taken.clear();
+                placed = true;
+                for (uint32_t i : m) {
+                    uint32_t s = slotFor(hashes[i], d);
+                    if (entries_[s].keyLen || std::find(taken.begin(), taken.end(), s) != taken.end()) {
+                        placed = false;
+                        break;
+                    }
+                    taken.push_back(s);
+                }
+                if (!placed) continue;
+                displace_[b] = d;
+                for (size_t k = 0; k < m.size(); k++) {
+                    entries_[taken[k]] = Entry{offsets[m[k]], (uint16_t)keys[m[k]].size(), values[m[k]]};
+                }
+            }
+            if (!placed) return false;
+        }
+        count_ = keys.size();
+        return true;
+    }
+
+    uint64_t              seed_ = 0;
+    size_t                count_ = 0;
+    uint32_t              bucketMask_ = 0;
+    uint32_t              slotMask_ = 0;
+    std::vector<uint32_t> displace_;
+    std::vector<Entry>    entries_;
+    std::string           strings_;
+};
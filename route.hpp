@@ -0,0 +1,537 @@
+// MockGPS - Route playback shared by the module, the companion and the tools
+//
+// A route is a timestamped polyline in route.bin next to location.bin. While a
+// config has `route=1`, the getters of lat, lng, speed and bearing report the
+// position on the route at the current CLOCK_BOOTTIME instead of the static values:
+// playback starts when the companion publishes the route and holds the last point
+// once its time has passed.
+//
+// route.bin, little-endian like location.bin:
+//
+//   offset  size  field
+//        0     4  magic     "MGRT"
+//        4     2  version   kRouteFileVersion
+//        6     2  reserved  0
+//        8     4  size      total bytes, header included
+//       12     4  crc       CRC-32 (IEEE) of all `size` bytes with this field zeroed
+//       16     4  points    at least 1
+//       20     4  duration  time of the last point, ms
+//       24     4  blocks    ceil(points / kRouteBlockPoints)
+//       28     4  distance  along the whole route, decimetres
+//       32  24*b  RouteBlock[blocks]: the index, one full point per kRouteBlockPoints
+//         ...     deltas: every point that does not start a block, in order
+//
+// A point is its time (ms since the first, strictly increasing), lat and lng in
+// 1e-7 degrees, the distance covered to reach it in decimetres and the heading of
+// the segment it starts in centidegrees; the compiler works the last two out once
+// so playback only divides. A delta holds five LEB128 varints, the differences to
+// the point before: time, then zigzagged lat, lng (the short way across the
+// antimeridian), distance, and zigzagged heading (the short way round). A walking
+// or driving track at 1 Hz takes ~8 bytes a point.
+//
+// The companion checks the file and copies it into a RouteRegion: a sealed memfd
+// that every hooked process maps read-only next to its config page, so the hooks
+// decode points in place. The region has two slots; publish n writes slot n & 1
+// under a per-slot sequence word and the config pages then carry n
+// (MockConfig::routeGen), so processes still playing n - 1 keep reading an
+// untouched slot.
+//
+// Each thread caches the segment it last used (RouteCursor). A call inside that
+// segment interpolates from the cache without touching the points; moving on
+// decodes forward from there, and anything else binary-searches the index and
+// decodes at most a block, so a call costs the same for a two-point and a
+// million-point route.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "config_file.hpp"
+
+static constexpr uint32_t kRouteFileMagic   = 0x5452474d;  // "MGRT"
+static constexpr uint16_t kRouteFileVersion = 2;
+static constexpr size_t   kRouteImageMax    = 16u << 20;   // per slot
+static constexpr uint32_t kRouteBlockPoints = 64;          // points per index entry
+
+struct RouteFileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t size;
+    uint32_t crc;
+    uint32_t points;
+    uint32_t durationMs;
+    uint32_t blocks;
+    uint32_t distanceDm;
+};
+
+// A point of the index; `offset` is where the deltas of the block's other points start
+struct RouteBlock {
+    uint32_t timeMs;
+    int32_t  latE7;
+    int32_t  lngE7;
+    uint32_t distanceDm;
+    uint32_t offset;
+    uint16_t headingCd;
+    uint16_t points;
+};
+
+static_assert(sizeof(RouteFileHeader) == 32, "route.bin header layout");
+static_assert(sizeof(RouteBlock) == 24, "route.bin index layout");
+
+// What encodeRoute() takes
+struct RoutePoint {
+    uint32_t timeMs;
+    int32_t  latE7;
+    int32_t  lngE7;
+};
+
+// A decoded point
+struct RouteSample {
+    uint32_t timeMs;
+    int32_t  latE7;
+    int32_t  lngE7;
+    uint32_t distanceDm;   // from the first point
+    uint16_t headingCd;    // of the segment starting here; the last point repeats the one before
+};
+
+// A delta is at least five bytes, which leaves room for the index
+static constexpr size_t kRouteMaxPoints = (kRouteImageMax - sizeof(RouteFileHeader)) / 6;
+static constexpr size_t kRouteMaxBlocks = (kRouteImageMax - sizeof(RouteFileHeader)) / sizeof(RouteBlock);
+
+inline uint32_t routeFileCrc(const void* data, size_t size) {
+    static constexpr uint32_t zero = 0;
+    constexpr size_t at = offsetof(RouteFileHeader, crc);
+    uint32_t crc = crc32(data, at);
+    crc = crc32(&zero, sizeof(zero), crc);
+    return crc32((const uint8_t*)data + at + sizeof(zero), size - at - sizeof(zero), crc);
+}
+
+inline bool validRoutePoint(const RoutePoint& p) {
+    return p.latE7 >= -900000000 && p.latE7 <= 900000000 && p.lngE7 >= -1800000000 && p.lngE7 <= 1800000000;
+}
+
+// Longitudes are stored in (-180, 180] so that a wrapped delta decodes to the same value
+inline int64_t wrapLngE7(int64_t lng) {
+    return lng > 1800000000 ? lng - 3600000000ll : lng <= -1800000000 ? lng + 3600000000ll : lng;
+}
+
+inline bool validRouteSample(const RouteSample& s) {
+    return s.latE7 >= -900000000 && s.latE7 <= 900000000 && s.lngE7 > -1800000000 && s.lngE7 <= 1800000000 &&
+           s.headingCd < 36000;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Geometry
+// ═══════════════════════════════════════════════════════════════════
+
+static constexpr double kEarthRadiusM = 6371008.8;   // mean radius
+static constexpr double kDegToRad     = M_PI / 180.0;
+
+// Great-circle distance in metres and initial bearing in [0, 360) degrees
+inline void routeLeg(double lat0, double lng0, double lat1, double lng1, double* meters, double* bearing) {
+    double p0 = lat0 * kDegToRad, p1 = lat1 * kDegToRad, dl = (lng1 - lng0) * kDegToRad;
+    double sp = std::sin((p1 - p0) / 2), sl = std::sin(dl / 2);
+    double h = sp * sp + std::cos(p0) * std::cos(p1) * sl * sl;
+    *meters = 2 * kEarthRadiusM * std::asin(std::sqrt(std::min(1.0, h)));
+    double b = std::atan2(std::sin(dl) * std::cos(p1),
+                          std::cos(p0) * std::sin(p1) - std::sin(p0) * std::cos(p1) * std::cos(dl));
+    b = b / kDegToRad;
+    *bearing = b < 0 ? b + 360.0 : b;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Deltas
+// ═══════════════════════════════════════════════════════════════════
+
+inline void putVarint(std::vector<uint8_t>* out, uint32_t v) {
+    while (v >= 0x80) {
+        out->push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out->push_back((uint8_t)v);
+}
+
+// False if the varint runs past `end` or does not fit 32 bits
+inline bool getVarint(const uint8_t** p, const uint8_t* end, uint32_t* v) {
+    if (*p < end && **p < 0x80) {
+        *v = *(*p)++;
+        return true;
+    }
+    uint32_t x = 0;
+    for (int shift = 0; shift < 35 && *p < end; shift += 7) {
+        uint8_t b = *(*p)++;
+        if (shift == 28 && b > 0x0f) return false;
+        x |= (uint32_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            *v = x;
+            return true;
+        }
+    }
+    return false;
+}
+
+inline uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+inline int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+inline void putRouteDelta(std::vector<uint8_t>* out, const RouteSample& a, const RouteSample& b) {
+    int32_t dHeading = (int32_t)b.headingCd - a.headingCd;
+    if (dHeading >= 18000) dHeading -= 36000;
+    if (dHeading < -18000) dHeading += 36000;
+    putVarint(out, b.timeMs - a.timeMs);
+    putVarint(out, zigzag(b.latE7 - a.latE7));
+    putVarint(out, zigzag((int32_t)wrapLngE7((int64_t)b.lngE7 - a.lngE7)));
+    putVarint(out, b.distanceDm - a.distanceDm);
+    putVarint(out, zigzag(dHeading));
+}
+
+// Apply the delta at `*p` to `s`. False if it runs past `end` or yields a point that
+// could not follow `s`: the same time, or out of range.
+inline bool getRouteDelta(const uint8_t** p, const uint8_t* end, RouteSample* s) {
+    uint32_t dt, dLat, dLng, dDist, dHeading;
+    if (!getVarint(p, end, &dt) || !getVarint(p, end, &dLat) || !getVarint(p, end, &dLng) ||
+        !getVarint(p, end, &dDist) || !getVarint(p, end, &dHeading)) {
+        return false;
+    }
+    int64_t heading = s->headingCd + (int64_t)unzigzag(dHeading);
+    heading += heading < 0 ? 36000 : heading >= 36000 ? -36000 : 0;
+    if (heading < 0 || heading >= 36000) return false;
+    RouteSample next;
+    next.timeMs     = s->timeMs + dt;
+    next.latE7      = (int32_t)std::clamp<int64_t>(s->latE7 + (int64_t)unzigzag(dLat), INT32_MIN, INT32_MAX);
+    next.lngE7      = (int32_t)std::clamp<int64_t>(wrapLngE7(s->lngE7 + (int64_t)unzigzag(dLng)), INT32_MIN, INT32_MAX);
+    next.distanceDm = s->distanceDm + dDist;
+    next.headingCd  = (uint16_t)heading;
+    if (!dt || next.timeMs < s->timeMs || next.distanceDm < s->distanceDm || !validRouteSample(next)) return false;
+    *s = next;
+    return true;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// route.bin
+// ═══════════════════════════════════════════════════════════════════
+
+// Serialize points into a route.bin image, working out the distance and heading of
+// each; empty if they do not form a valid route or do not fit kRouteImageMax
+inline std::vector<uint8_t> encodeRoute(const std::vector<RoutePoint>& points) {
+    std::vector<uint8_t> out;
+    if (points.empty() || points.size() > kRouteMaxPoints || points[0].timeMs != 0) return out;
+    for (size_t i = 0; i < points.size(); i++) {
+        if (!validRoutePoint(points[i]) || (i && points[i].timeMs <= points[i - 1].timeMs)) return out;
+    }
+
+    uint32_t n = (uint32_t)points.size();
+    uint32_t blocks = (n + kRouteBlockPoints - 1) / kRouteBlockPoints;
+    out.resize(sizeof(RouteFileHeader) + (size_t)blocks * sizeof(RouteBlock));
+    out.reserve(out.size() + (size_t)n * 8);
+
+    auto leg = [&](uint32_t i, double* meters, double* bearing) {
+        const RoutePoint& a = points[i];
+        const RoutePoint& b = points[i + 1];
+        double lng0 = a.lngE7 * 1e-7;
+        routeLeg(a.latE7 * 1e-7, lng0, b.latE7 * 1e-7, lng0 + wrapLngE7((int64_t)b.lngE7 - a.lngE7) * 1e-7,
+                 meters, bearing);
+    };
+    RouteSample prev = {};
+    double total = 0, meters = 0, bearing = 0;
+    if (n > 1) leg(0, &meters, &bearing);
+    for (uint32_t i = 0; i < n; i++) {
+        RouteSample s = {points[i].timeMs, points[i].latE7, (int32_t)wrapLngE7(points[i].lngE7), 0, prev.headingCd};
+        if (i) {
+            total += meters;
+            if (i + 1 < n) leg(i, &meters, &bearing);
+        }
+        double dm = std::round(total * 10);
+        if (dm > UINT32_MAX) return {};
+        s.distanceDm = (uint32_t)dm;
+        // A point that does not move keeps the heading it arrived with
+        if (i + 1 < n && (points[i + 1].latE7 != points[i].latE7 || points[i + 1].lngE7 != points[i].lngE7)) {
+            s.headingCd = (uint16_t)(std::lround(bearing * 100) % 36000);
+        }
+
+        if (i % kRouteBlockPoints == 0) {
+            RouteBlock blk = {s.timeMs, s.latE7, s.lngE7, s.distanceDm, (uint32_t)out.size(), s.headingCd,
+                              (uint16_t)std::min(kRouteBlockPoints, n - i)};
+            memcpy(out.data() + sizeof(RouteFileHeader) + (size_t)(i / kRouteBlockPoints) * sizeof(blk), &blk,
+                   sizeof(blk));
+        } else {
+            putRouteDelta(&out, prev, s);
+        }
+        if (out.size() > kRouteImageMax) return {};
+        prev = s;
+    }
+
+    RouteFileHeader head = {};
+    head.magic      = kRouteFileMagic;
+    head.version    = kRouteFileVersion;
+    head.size       = (uint32_t)out.size();
+    head.points     = n;
+    head.durationMs = prev.timeMs;
+    head.blocks     = blocks;
+    head.distanceDm = prev.distanceDm;
+    memcpy(out.data(), &head, sizeof(head));
+    uint32_t crc = routeFileCrc(out.data(), out.size());
+    memcpy(out.data() + offsetof(RouteFileHeader, crc), &crc, sizeof(crc));
+    return out;
+}
+
+inline RouteBlock routeBlock(const uint8_t* image, uint32_t b) {
+    RouteBlock blk;
+    memcpy(&blk, image + sizeof(RouteFileHeader) + (size_t)b * sizeof(RouteBlock), sizeof(blk));
+    return blk;
+}
+
+// Header, checksum, index and a decode of every delta; the hooks trust what passes
+inline bool validateRoute(const void* data, size_t len) {
+    RouteFileHeader head;
+    if (len < sizeof(head) || len > kRouteImageMax) return false;
+    memcpy(&head, data, sizeof(head));
+    if (head.magic != kRouteFileMagic || head.version != kRouteFileVersion || head.size != len ||
+        !head.points || head.points > kRouteMaxPoints ||
+        head.blocks != (head.points + kRouteBlockPoints - 1) / kRouteBlockPoints ||
+        len < sizeof(head) + (size_t)head.blocks * sizeof(RouteBlock) || routeFileCrc(data, len) != head.crc) {
+        return false;
+    }
+    const uint8_t* image = (const uint8_t*)data;
+    size_t offset = sizeof(head) + (size_t)head.blocks * sizeof(RouteBlock);
+    RouteSample last = {};
+    for (uint32_t b = 0; b < head.blocks; b++) {
+        RouteBlock blk = routeBlock(image, b);
+        RouteSample s = {blk.timeMs, blk.latE7, blk.lngE7, blk.distanceDm, blk.headingCd};
+        if (blk.points != std::min(kRouteBlockPoints, head.points - b * kRouteBlockPoints) || blk.offset != offset ||
+            !validRouteSample(s) ||
+            (b ? s.timeMs <= last.timeMs || s.distanceDm < last.distanceDm : s.timeMs || s.distanceDm)) {
+            return false;
+        }
+        const uint8_t* p = image + offset;
+        for (uint32_t i = 1; i < blk.points; i++) {
+            if (!getRouteDelta(&p, image + len, &s)) return false;
+        }
+        offset = p - image;
+        last = s;
+    }
+    return offset == len && last.timeMs == head.durationMs && last.distanceDm == head.distanceDm;
+}
+
+// Read and check a whole route.bin into `image`, like loadConfigFile()
+inline ConfigLoad loadRouteFile(const char* path, std::vector<uint8_t>* image) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return errno == ENOENT ? ConfigLoad::kMissing : ConfigLoad::kInvalid;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(RouteFileHeader) || st.st_size > (off_t)kRouteImageMax) {
+        close(fd);
+        return ConfigLoad::kInvalid;
+    }
+    std::vector<uint8_t> buf(st.st_size + 1);
+    size_t got = 0;
+    ssize_t n;
+    while (got < buf.size() && (n = read(fd, buf.data() + got, buf.size() - got)) > 0) got += n;
+    close(fd);
+    if (!validateRoute(buf.data(), got)) return ConfigLoad::kInvalid;
+    buf.resize(got);
+    *image = std::move(buf);
+    return ConfigLoad::kOk;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Shared Region
+// ═══════════════════════════════════════════════════════════════════
+//
+// Writer (the companion, one publish at a time):
+//   gen → 0, copy image and start time, gen → n (release)
+// Reader:
+//   load gen (acquire), decode from the image, fence, reload gen; the read is only
+//   used if both equal the generation its config names
+
+struct alignas(64) RouteSlot {
+    std::atomic<uint32_t> gen;       // publish held, 0 while written or empty
+    uint32_t              size;
+    std::atomic<uint64_t> startNs;   // CLOCK_BOOTTIME at which time 0 plays
+    alignas(64) uint8_t   image[kRouteImageMax];
+};
+
+struct RouteRegion {
+    RouteSlot slots[2];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "RouteRegion is shared between processes");
+
+// Copy a validated image into the slot of publish `gen` (nonzero); the caller then
+// hands `gen` to readers through the config pages
+inline void publishRoute(RouteRegion* region, uint32_t gen, const void* image, size_t len, uint64_t startNs) {
+    RouteSlot& s = region->slots[gen & 1];
+    s.gen.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(s.image, image, len);
+    s.size = (uint32_t)len;
+    s.startNs.store(startNs, std::memory_order_relaxed);
+    s.gen.store(gen, std::memory_order_release);
+}
+
+// Restart playback of publish `gen` at `startNs`
+inline void restartRoute(RouteRegion* region, uint32_t gen, uint64_t startNs) {
+    RouteSlot& s = region->slots[gen & 1];
+    if (s.gen.load(std::memory_order_relaxed) == gen) s.startNs.store(startNs, std::memory_order_relaxed);
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Playback
+// ═══════════════════════════════════════════════════════════════════
+//
+// Reads may race a publish into the slot, so everything below stays inside the
+// image whatever the bytes say; callers recheck the slot's gen before using a result.
+
+// A decoded point and where the delta of the one after it starts
+struct RoutePos {
+    RouteSample sample;
+    uint32_t    index;
+    uint32_t    block;
+    uint32_t    offset;
+};
+
+// The header with its counts bounded to what fits a slot
+inline RouteFileHeader routeHeader(const uint8_t* image) {
+    RouteFileHeader head;
+    memcpy(&head, image, sizeof(head));
+    head.size   = (uint32_t)std::min<size_t>(head.size, kRouteImageMax);
+    head.points = std::min<uint32_t>(std::max<uint32_t>(head.points, 1), kRouteMaxPoints);
+    head.blocks = std::min<uint32_t>(std::max<uint32_t>(head.blocks, 1), kRouteMaxBlocks);
+    return head;
+}
+
+inline RoutePos routeBlockStart(const uint8_t* image, uint32_t b) {
+    RouteBlock blk = routeBlock(image, b);
+    return {{blk.timeMs, blk.latE7, blk.lngE7, blk.distanceDm, blk.headingCd}, b * kRouteBlockPoints, b, blk.offset};
+}
+
+// Step to the next point; false past the last one or on bytes that do not decode
+inline bool routeAdvance(const uint8_t* image, const RouteFileHeader& head, RoutePos* pos) {
+    uint32_t next = pos->index + 1;
+    if (next >= head.points) return false;
+    if (next % kRouteBlockPoints == 0) {
+        if (pos->block + 1 >= head.blocks) return false;
+        *pos = routeBlockStart(image, pos->block + 1);
+        return true;
+    }
+    if (pos->offset >= head.size) return false;
+    const uint8_t* p = image + pos->offset;
+    if (!getRouteDelta(&p, image + head.size, &pos->sample)) return false;
+    pos->offset = (uint32_t)(p - image);
+    pos->index  = next;
+    return true;
+}
+
+// From `*a`, find the segment holding `tMs` within `steps` points: `*a` its start and
+// `*b` its end. False if the route ends first or is that far ahead.
+inline bool walkRoute(const uint8_t* image, const RouteFileHeader& head, double tMs, uint32_t steps,
+                      RoutePos* a, RoutePos* b) {
+    for (*b = *a; steps--; *a = *b) {
+        if (!routeAdvance(image, head, b)) return false;
+        if (b->sample.timeMs > tMs) return true;
+    }
+    return false;
+}
+
+// The block holding `tMs`: the last whose first point is not after it
+inline uint32_t routeBlockAt(const uint8_t* image, const RouteFileHeader& head, double tMs) {
+    uint32_t lo = 0, hi = head.blocks - 1;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo + 1) / 2;
+        if (routeBlock(image, mid).timeMs <= tMs) lo = mid; else hi = mid - 1;
+    }
+    return lo;
+}
+
+// The segment a thread last played, with everything a call inside it needs
+struct RouteCursor {
+    uint32_t gen = 0;          // 0: nothing cached
+    double   t0 = 0, t1 = 0;   // ms; t1 is infinite past the last point
+    double   lat0 = 0, lng0 = 0, dLat = 0, dLng = 0;   // degrees
+    float    speed = 0, bearing = 0;
+    RoutePos end = {};         // the segment's last point, where the next one starts
+};
+
+struct RouteFix {
+    double lat, lng;
+    float  speed, bearing;
+};
+
+// Point the cursor at the segment holding `tMs` in publish `gen`; false if that
+// publish is no longer in its slot
+inline bool seekRoute(const RouteRegion* region, uint32_t gen, double tMs, RouteCursor* c) {
+    const RouteSlot& s = region->slots[gen & 1];
+    if (s.gen.load(std::memory_order_acquire) != gen) return false;
+    RouteFileHeader head = routeHeader(s.image);
+
+    RouteCursor next;
+    next.gen = gen;
+    RoutePos a, b;
+    if (tMs >= head.durationMs) {
+        // Past the end: stand at the last point, facing the way the route arrived
+        a = routeBlockStart(s.image, head.blocks - 1);
+        while (routeAdvance(s.image, head, &a)) {}
+        next.t0  = a.sample.timeMs;
+        next.t1  = INFINITY;
+        next.end = a;
+    } else {
+        // Onward from the cached segment first when tMs is at most a block further:
+        // playback mostly moves forward a segment at a time. Otherwise decode from
+        // the block holding tMs.
+        bool found = false;
+        uint32_t ahead = c->end.block + 2;
+        if (c->gen == gen && tMs >= c->t1 && (ahead >= head.blocks || tMs < routeBlock(s.image, ahead).timeMs)) {
+            a = c->end;
+            found = walkRoute(s.image, head, tMs, 2 * kRouteBlockPoints, &a, &b);
+        }
+        if (!found) {
+            a = routeBlockStart(s.image, routeBlockAt(s.image, head, tMs));
+            found = walkRoute(s.image, head, tMs, kRouteBlockPoints, &a, &b);
+        }
+        if (!found) return false;
+        uint32_t dt = b.sample.timeMs - a.sample.timeMs;
+        next.t0    = a.sample.timeMs;
+        next.t1    = b.sample.timeMs;
+        next.dLat  = (b.sample.latE7 - (int64_t)a.sample.latE7) * 1e-7;
+        next.dLng  = wrapLngE7((int64_t)b.sample.lngE7 - a.sample.lngE7) * 1e-7;
+        next.speed = dt ? (float)((b.sample.distanceDm - a.sample.distanceDm) * 100.0 / dt) : 0.0f;
+        next.end   = b;
+    }
+    next.lat0    = a.sample.latE7 * 1e-7;
+    next.lng0    = a.sample.lngE7 * 1e-7;
+    next.bearing = a.sample.headingCd / 100.0f;
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (s.gen.load(std::memory_order_relaxed) != gen) return false;
+    *c = next;
+    return true;
+}
+
+// Position on publish `gen` at CLOCK_BOOTTIME `nowNs`. False without a route (gen 0)
+// or while the publish is being replaced; callers then report the static config.
+inline bool locateOnRoute(const RouteRegion* region, uint32_t gen, uint64_t nowNs, RouteCursor* c, RouteFix* fix) {
+    if (!region || !gen) return false;
+    const RouteSlot& s = region->slots[gen & 1];
+    uint64_t startNs = s.startNs.load(std::memory_order_relaxed);
+    double tMs = nowNs > startNs ? (nowNs - startNs) / 1e6 : 0.0;
+    if ((c->gen != gen || tMs < c->t0 || tMs >= c->t1) && !seekRoute(region, gen, tMs, c)) return false;
+
+    double f = c->t1 > c->t0 && c->t1 != INFINITY ? (tMs - c->t0) / (c->t1 - c->t0) : 0.0;
+    double lng = c->lng0 + f * c->dLng;
+    if (lng > 180.0) lng -= 360.0;
+    if (lng < -180.0) lng += 360.0;
+    fix->lat     = c->lat0 + f * c->dLat;
+    fix->lng     = lng;
+    fix->speed   = c->t1 == INFINITY ? 0.0f : c->speed;
+    fix->bearing = c->bearing;
+    return true;
+}
@@ -0,0 +1,380 @@
+// MockGPS - Minimal XZ / LZMA2 decoder
+//
+// Just enough of the .xz format to unpack MiniDebugInfo (.gnu_debugdata): one or more
+// blocks using the LZMA2 filter alone, decoded into memory in one call. There is no
+// streaming, no BCJ/delta filters and integrity checks are skipped; the caller
+// treats the output as untrusted and bounds-checks everything it reads from it.
+//
+// Follows the structure of xz-embedded (public domain). The output buffer since the
+// last dictionary reset is the dictionary, so matches copy straight from earlier output.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace xz {
+
+namespace detail {
+
+constexpr uint32_t kProbBits   = 11;
+constexpr uint16_t kProbInit   = 1 << (kProbBits - 1);
+constexpr uint32_t kMoveBits   = 5;
+constexpr uint32_t kTopValue   = 1u << 24;
+
+constexpr int kStates          = 12;
+constexpr int kPosStatesMax    = 16;
+constexpr int kDistStates      = 4;
+constexpr int kDistSlots       = 64;
+constexpr int kDistModelStart  = 4;
+constexpr int kDistModelEnd    = 14;
+constexpr int kFullDistances   = 128;
+constexpr int kAlignBits       = 4;
+constexpr int kMatchLenMin     = 2;
+constexpr int kLiteralCoderSize = 0x300;
+constexpr int kLiteralCodersMax = 16;  // LZMA2 requires lc + lp <= 4
+
+struct LenDecoder {
+    uint16_t choice;
+    uint16_t choice2;
+    uint16_t low[kPosStatesMax][8];
+    uint16_t mid[kPosStatesMax][8];
+    uint16_t high[256];
+};
+
+struct Probs {
+    uint16_t isMatch[kStates][kPosStatesMax];
+    uint16_t isRep[kStates];
+    uint16_t isRep0[kStates];
+    uint16_t isRep1[kStates];
+    uint16_t isRep2[kStates];
+    uint16_t isRep0Long[kStates][kPosStatesMax];
+    uint16_t distSlot[kDistStates][kDistSlots];
+    uint16_t distSpecial[kFullDistances - kDistModelEnd];
+    uint16_t distAlign[1 << kAlignBits];
+    LenDecoder matchLen;
+    LenDecoder repLen;
+    uint16_t literal[kLiteralCodersMax][kLiteralCoderSize];
+};
+
+// Range decoder over one LZMA2 chunk
+struct RangeDecoder {
+    const uint8_t* in;
+    const uint8_t* end;
+    uint32_t range;
+    uint32_t code;
+    bool     overrun;
+
+    bool init(const uint8_t* p, const uint8_t* e) {
+        in = p;
+        end = e;
+        overrun = false;
+        if (end - in < 5 || in[0] != 0) return false;
+        code = ((uint32_t)in[1] << 24) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 8) | in[4];
+        in += 5;
+        range = 0xFFFFFFFF;
+        return true;
+    }
+
+    void normalize() {
+        if (range < kTopValue) {
+            range <<= 8;
+            if (in < end) {
+                code = (code << 8) | *in++;
+            } else {
+                code <<= 8;
+                overrun = true;
+            }
+        }
+    }
+
+    int bit(uint16_t* prob) {
+        normalize();
+        uint32_t bound = (range >> kProbBits) * *prob;
+        if (code < bound) {
+            range = bound;
+            *prob += ((1u << kProbBits) - *prob) >> kMoveBits;
+            return 0;
+        }
+        range -= bound;
+        code -= bound;
+        *prob -= *prob >> kMoveBits;
+        return 1;
+    }
+
+    // Returns symbol + limit, like xz-embedded's rc_bittree()
+    uint32_t bittree(uint16_t* probs, uint32_t limit) {
+        uint32_t symbol = 1;
+        do {
+            symbol = (symbol << 1) | bit(&probs[symbol]);
+        } while (symbol < limit);
+        return symbol;
+    }
+
+    void bittreeReverse(uint16_t* probs, uint32_t* dest, uint32_t limit) {
+        uint32_t symbol = 1;
+        for (uint32_t i = 0; i < limit; i++) {
+            uint32_t b = bit(&probs[symbol]);
+            symbol = (symbol << 1) | b;
+            *dest += b << i;
+        }
+    }
+
+    void direct(uint32_t* dest, uint32_t limit) {
+        do {
+            normalize();
+            range >>= 1;
+            code -= range;
+            uint32_t mask = 0u - (code >> 31);
+            code += range & mask;
+            *dest = (*dest << 1) + (mask + 1);
+        } while (--limit > 0);
+    }
+};
+
+class Lzma2Decoder {
+public:
+    explicit Lzma2Decoder(std::vector<uint8_t>* out) : out_(out) {}
+
+    // Decode LZMA2 chunks until the end marker; returns bytes consumed or 0 on error
+    size_t run(const uint8_t* in, size_t size) {
+        const uint8_t* p = in;
+        const uint8_t* end = in + size;
+        bool needProps = true;
+
+        while (p < end) {
+            uint8_t ctrl = *p++;
+            if (ctrl == 0x00) return (size_t)(p - in);
+
+            if (ctrl == 0x01 || ctrl >= 0xE0) dictStart_ = out_->size();   // dictionary reset
+
+            if (ctrl == 0x01 || ctrl == 0x02) {          // uncompressed chunk
+                if (end - p < 2) return 0;
+                size_t n = ((size_t)p[0] << 8 | p[1]) + 1;
+                p += 2;
+                if ((size_t)(end - p) < n) return 0;
+                out_->insert(out_->end(), p, p + n);
+                p += n;
+                continue;
+            }
+            if (ctrl < 0x80) return 0;
+
+            if (end - p < 4) return 0;
+            size_t unpacked = (((size_t)ctrl & 0x1F) << 16 | (size_t)p[0] << 8 | p[1]) + 1;
+            size_t packed   = ((size_t)p[2] << 8 | p[3]) + 1;
+            p += 4;
+
+            int reset = (ctrl >> 5) & 3;
+            if (reset >= 2) {                             // new properties
+                if (p >= end || !setProps(*p++)) return 0;
+                needProps = false;
+            }
+            if (needProps) return 0;
+            if (reset >= 1) resetState();
+
+            if ((size_t)(end - p) < packed) return 0;
+            if (!decodeChunk(p, p + packed, unpacked)) return 0;
+            p += packed;
+        }
+        return 0;
+    }
+
+private:
+    std::vector<uint8_t>* out_;
+    size_t   dictStart_ = 0;   // output offset of the last dictionary reset
+    Probs    probs_;
+    RangeDecoder rc_;
+    uint32_t lc_ = 0, lp_ = 0, pb_ = 0;
+    uint32_t state_ = 0;
+    uint32_t rep0_ = 0, rep1_ = 0, rep2_ = 0, rep3_ = 0;
+
+    bool setProps(uint8_t props) {
+        if (props > (4 * 5 + 4) * 9 + 8) return false;
+        lc_ = props % 9;
+        props /= 9;
+        lp_ = props % 5;
+        pb_ = props / 5;
+        return lc_ + lp_ <= 4;
+    }
+
+    void resetState() {
+        uint16_t* p = (uint16_t*)&probs_;
+        for (size_t i = 0; i < sizeof(probs_) / sizeof(uint16_t); i++) p[i] = kProbInit;
+        state_ = 0;
+        rep0_ = rep1_ = rep2_ = rep3_ = 0;
+    }
+
+    uint32_t decodeLen(LenDecoder& l, uint32_t posState) {
+        if (!rc_.bit(&l.choice)) return kMatchLenMin + rc_.bittree(l.low[posState], 8) - 8;
+        if (!rc_.bit(&l.choice2)) return kMatchLenMin + 8 + rc_.bittree(l.mid[posState], 8) - 8;
+        return kMatchLenMin + 16 + rc_.bittree(l.high, 256) - 256;
+    }
+
+    uint32_t decodeDist(uint32_t len) {
+        uint32_t distState = len < kDistStates + kMatchLenMin ? len - kMatchLenMin : kDistStates - 1;
+        uint32_t slot = rc_.bittree(probs_.distSlot[distState], kDistSlots) - kDistSlots;
+        if (slot < kDistModelStart) return slot;
+
+        uint32_t limit = (slot >> 1) - 1;
+        uint32_t dist = 2 + (slot & 1);
+        if (slot < kDistModelEnd) {
+            dist <<= limit;
+            rc_.bittreeReverse(probs_.distSpecial + dist - slot - 1, &dist, limit);
+        } else {
+            rc_.direct(&dist, limit - kAlignBits);
+            dist <<= kAlignBits;
+            rc_.bittreeReverse(probs_.distAlign, &dist, kAlignBits);
+        }
+        return dist;
+    }
+
+    bool decodeChunk(const uint8_t* in, const uint8_t* end, size_t unpacked) {
+        if (!rc_.init(in, end)) return false;
+
+        // Positions are relative to the dictionary reset; `base` maps them into out
+        std::vector<uint8_t>& out = *out_;
+        size_t pos = out.size() - dictStart_;
+        size_t limit = pos + unpacked;
+        out.resize(dictStart_ + limit);
+        uint8_t* base = out.data() + dictStart_;
+        const uint32_t pbMask = (1u << pb_) - 1;
+        const uint32_t lpMask = (1u << lp_) - 1;
+
+        while (pos < limit) {
+            uint32_t posState = pos & pbMask;
+
+            if (!rc_.bit(&probs_.isMatch[state_][posState])) {
+                uint32_t prev = pos ? base[pos - 1] : 0;
+                uint16_t* lit = probs_.literal[((pos & lpMask) << lc_) + (prev >> (8 - lc_))];
+                uint32_t symbol;
+                if (state_ < 7) {
+                    symbol = rc_.bittree(lit, 0x100);
+                } else {
+                    if (rep0_ >= pos) return false;
+                    uint32_t matchByte = (uint32_t)base[pos - rep0_ - 1] << 1;
+                    uint32_t offset = 0x100;
+                    symbol = 1;
+                    do {
+                        uint32_t matchBit = matchByte & offset;
+                        matchByte <<= 1;
+                        if (rc_.bit(&lit[offset + matchBit + symbol])) {
+                            symbol = (symbol << 1) + 1;
+                            offset = matchBit;
+                        } else {
+                            symbol <<= 1;
+                            offset &= ~matchBit;
+                        }
+                    } while (symbol < 0x100);
+                }
+                base[pos++] = (uint8_t)symbol;
+                state_ = state_ < 4 ? 0 : state_ < 10 ? state_ - 3 : state_ - 6;
+                continue;
+            }
+
+            uint32_t len;
+            if (rc_.bit(&probs_.isRep[state_])) {
+                if (!rc_.bit(&probs_.isRep0[state_])) {
+                    if (!rc_.bit(&probs_.isRep0Long[state_][posState])) {
+                        // Short rep: one byte at rep0
+                        if (rep0_ >= pos) return false;
+                        state_ = state_ < 7 ? 9 : 11;
+                        base[pos] = base[pos - rep0_ - 1];
+                        pos++;
+                        continue;
+                    }
+                } else {
+                    uint32_t dist;
+                    if (!rc_.bit(&probs_.isRep1[state_])) {
+                        dist = rep1_;
+                    } else {
+                        if (!rc_.bit(&probs_.isRep2[state_])) {
+                            dist = rep2_;
+                        } else {
+                            dist = rep3_;
+                            rep3_ = rep2_;
+                        }
+                        rep2_ = rep1_;
+                    }
+                    rep1_ = rep0_;
+                    rep0_ = dist;
+                }
+                state_ = state_ < 7 ? 8 : 11;
+                len = decodeLen(probs_.repLen, posState);
+            } else {
+                rep3_ = rep2_;
+                rep2_ = rep1_;
+                rep1_ = rep0_;
+                len = decodeLen(probs_.matchLen, posState);
+                state_ = state_ < 7 ? 7 : 10;
+                rep0_ = decodeDist(len);
+            }
+
+            if (rep0_ >= pos || len > limit - pos) return false;
+            const uint8_t* src = base + pos - rep0_ - 1;
+            uint8_t* dst = base + pos;
+            for (uint32_t i = 0; i < len; i++) dst[i] = src[i];   // may overlap forward
+            pos += len;
+        }
+        return !rc_.overrun;
+    }
+};
+
+// xz multibyte integer (7 bits per byte, little endian)
+inline bool readVarint(const uint8_t*& p, const uint8_t* end, uint64_t* value) {
+    *value = 0;
+    for (int shift = 0; shift < 63 && p < end; shift += 7) {
+        uint8_t b = *p++;
+        *value |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+} // namespace detail
+
+// Decode a complete .xz stream into *out. Returns false on anything unsupported.
+inline bool decode(const uint8_t* in, size_t size, std::vector<uint8_t>* out) {
+    static const uint8_t kMagic[6] = { 0xFD, '7', 'z', 'X', 'Z', 0x00 };
+    static const size_t kCheckSizes[16] = { 0, 4, 4, 4, 8, 8, 8, 16, 16, 16, 32, 32, 32, 64, 64, 64 };
+
+    if (size < 12 || memcmp(in, kMagic, sizeof(kMagic)) != 0 || in[6] != 0) return false;
+    size_t checkSize = kCheckSizes[in[7] & 0x0F];
+
+    const uint8_t* p = in + 12;
+    const uint8_t* end = in + size;
+    out->clear();
+
+    while (p < end) {
+        // Block header, or 0x00 for the index that ends the stream
+        if (*p == 0x00) return true;
+        size_t headerSize = ((size_t)*p + 1) * 4;
+        if ((size_t)(end - p) < headerSize) return false;
+        const uint8_t* h = p + 1;
+        const uint8_t* hEnd = p + headerSize - 4;   // CRC32 not verified
+        uint8_t flags = *h++;
+        if ((flags & 0x03) != 0) return false;      // exactly one filter: LZMA2
+
+        uint64_t v;
+        if ((flags & 0x40) && !detail::readVarint(h, hEnd, &v)) return false;  // compressed size
+        if ((flags & 0x80) && !detail::readVarint(h, hEnd, &v)) return false;  // uncompressed size
+
+        uint64_t filterId, propsSize;
+        if (!detail::readVarint(h, hEnd, &filterId) || filterId != 0x21) return false;
+        if (!detail::readVarint(h, hEnd, &propsSize) || propsSize != 1 || h >= hEnd) return false;
+
+        p += headerSize;
+        detail::Lzma2Decoder lzma2(out);
+        size_t used = lzma2.run(p, (size_t)(end - p));
+        if (!used) return false;
+        p += used;
+
+        // Block padding to a multiple of four, then the check
+        while ((size_t)(p - in) & 3) p++;
+        p += checkSize;
+    }
+    return false;
+}
+
+} // namespace xz
@@ -0,0 +1,159 @@
+// MockGPS - Configuration types shared by the module, the companion and host tools
+//
+// The live config is published through a ConfigSnapshot: a single cache line guarded
+// by a sequence lock. Hook functions read the whole MockConfig in one consistent copy
+// without taking locks, so a getter can never observe a lat from one config and a lng
+// (or enabled flag) from another.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+// Location values a config spoofs while enabled (MockConfig::overrides). Getters of
+// the other fields are left unhooked and return the real values.
+enum LocationField : uint16_t {
+    kFieldLat      = 1u << 0,
+    kFieldLng      = 1u << 1,
+    kFieldAccuracy = 1u << 2,
+    kFieldAltitude = 1u << 3,
+    kFieldSpeed    = 1u << 4,
+    kFieldBearing  = 1u << 5,
+    kFieldTime     = 1u << 6,   // getTime/getElapsedRealtimeNanos report "now"
+    kAllLocationFields = (1u << 7) - 1,
+};
+
+// Fields are ordered largest-first so the struct packs into 48 bytes on every ABI
+struct MockConfig {
+    double   lat       = 0.0;
+    double   lng       = 0.0;
+    double   altitude  = 0.0;
+    float    accuracy  = 5.0f;
+    float    speed     = 0.0f;
+    float    bearing   = 0.0f;
+    uint32_t routeGen  = 0;   // route region generation to play (route.hpp); set by the companion
+    uint16_t overrides = kAllLocationFields;   // LocationField bits
+    bool     enabled   = false;
+    bool     hideDev   = true;   // hide developer options
+    bool     route     = false;  // follow route.bin instead of lat/lng/speed/bearing
+
+    // Whether a getter of `field` returns the configured value
+    bool spoofs(uint16_t field) const { return enabled && (overrides & field); }
+};
+
+static_assert(sizeof(MockConfig) == 48, "MockConfig must stay 48 bytes");
+
+static_assert(std::is_trivially_copyable<MockConfig>::value, "MockConfig is copied as raw words");
+
+// ═══════════════════════════════════════════════════════════════════
+// Seqlock Snapshot
+// ═══════════════════════════════════════════════════════════════════
+//
+// Writer (single thread at a time):
+//   seq → odd, store payload words, seq → even (release)
+// Reader:
+//   load seq (acquire), copy payload words, fence, reload seq; retry if odd or changed
+//
+// Payload words are relaxed atomics so the protocol is race-free under the C++ memory
+// model; on arm64/x86 they compile to plain loads and stores.
+
+struct alignas(64) ConfigSnapshot {
+    using Word = uintptr_t;
+    static constexpr size_t kWords = (sizeof(MockConfig) + sizeof(Word) - 1) / sizeof(Word);
+
+    std::atomic<uint32_t> seq{0};
+    std::atomic<Word>     words[kWords];
+    // Not part of the config, both followed by the hook controller thread after a
+    // wake on seq: bumped to have the log ring flushed, and the hook call tracer's
+    // sampling (one call in traceEvery per thread; 0 while no trace runs)
+    std::atomic<uint32_t> logFlush{0};
+    std::atomic<uint32_t> traceEvery{0};
+
+    ConfigSnapshot() { store(MockConfig{}); }
+
+    ConfigSnapshot(const ConfigSnapshot&) = delete;
+    ConfigSnapshot& operator=(const ConfigSnapshot&) = delete;
+
+    // Publish a new config. Callers must not run store() concurrently.
+    void store(const MockConfig& cfg) {
+        Word buf[kWords] = {};
+        memcpy(buf, &cfg, sizeof(cfg));
+
+        uint32_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        storeWords(buf, std::make_index_sequence<kWords>{});
+        seq.store(s + 2, std::memory_order_release);
+    }
+
+    // Copy out a consistent config. Lock-free; spins only while a store is in flight.
+    void load(MockConfig& out) const {
+        Word buf[kWords];
+        uint32_t s0, s1;
+        do {
+            s0 = seq.load(std::memory_order_acquire);
+            loadWords(buf, std::make_index_sequence<kWords>{});
+            std::atomic_thread_fence(std::memory_order_acquire);
+            s1 = seq.load(std::memory_order_relaxed);
+        } while ((s0 & 1) || s0 != s1);
+        memcpy(&out, buf, sizeof(out));
+    }
+
+    MockConfig load() const {
+        MockConfig cfg;
+        load(cfg);
+        return cfg;
+    }
+
+    // Even value that changes on every store; lets callers detect updates cheaply
+    uint32_t generation() const {
+        return seq.load(std::memory_order_acquire) & ~1u;
+    }
+
+private:
+    // Word copies are expanded at compile time; a runtime loop here costs ~3x on the read path
+    template <size_t... I>
+    void storeWords(const Word* buf, std::index_sequence<I...>) {
+        (words[I].store(buf[I], std::memory_order_relaxed), ...);
+    }
+
+    template <size_t... I>
+    void loadWords(Word* buf, std::index_sequence<I...>) const {
+        ((buf[I] = words[I].load(std::memory_order_relaxed)), ...);
+    }
+};
+
+static_assert(sizeof(ConfigSnapshot) == 64, "ConfigSnapshot must fit one cache line");
+static_assert(std::atomic<ConfigSnapshot::Word>::is_always_lock_free, "seqlock needs lock-free words");
+
+// One thread's copy for the lat and lng getters. A snapshot makes each getter
+// consistent on its own, but an app reads lat and lng in two calls, and a publish
+// between them would pair a new lat with an old lng. The second of the two is
+// answered from the copy the first used; a copy answers each field once, and one
+// older than kHoldNs is not reused, so a lone getter is never more than that stale.
+struct ConfigPair {
+    static constexpr uint64_t kHoldNs = 10000000;   // 10 ms
+
+    MockConfig cfg;
+    uint64_t   atNs   = 0;   // when cfg was loaded
+    uint16_t   served = 0;   // kFieldLat / kFieldLng answered from cfg
+
+    // The config to answer `field` (kFieldLat or kFieldLng) from at `nowNs`
+    const MockConfig& get(const ConfigSnapshot& snap, uint16_t field, uint64_t nowNs) {
+        bool second = served && !(served & field);
+        if (second && nowNs - atNs < kHoldNs) {
+            served |= field;
+        } else {
+            snap.load(cfg);
+            atNs = nowNs;
+            // A second call past the hold ends its pair; otherwise the next pair
+            // would start on this copy and every pair after it would straddle two
+            served = second ? (kFieldLat | kFieldLng) : field;
+        }
+        return cfg;
+    }
+};
@@ -0,0 +1,301 @@
+// MockGPS - In-process ELF symbol resolver
+//
+// Looks up symbols of an already loaded library without going through the dynamic
+// linker, so hidden and local symbols (like libart's art_quick_* entry points) can
+// be found too:
+//
+//   1. dl_iterate_phdr gives the load bias and on-disk path; no /proc/self/maps scan
+//   2. the file is mapped read-only and its section headers are parsed
+//   3. lookup order: .dynsym (GNU hash, SysV hash fallback), .symtab, then the
+//      .symtab inside .gnu_debugdata (MiniDebugInfo, xz-compressed; see xz.hpp)
+//
+// Every offset read from the file is bounds-checked, the decompressed MiniDebugInfo
+// included. Symbol versions are ignored and IFUNC symbols are skipped. Works on any
+// ELF of the host's class, so it can be exercised off-device (host/tools/elf_lookup).
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <elf.h>
+#include <fcntl.h>
+#include <link.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "xz.hpp"
+
+namespace elf {
+
+// One symbol table (entries + string table) inside a buffer, plus optional hash tables
+struct SymbolTable {
+    const ElfW(Sym)*  syms     = nullptr;
+    size_t            count    = 0;
+    const char*       strtab   = nullptr;
+    size_t            strSize  = 0;
+    const uint32_t*   gnuHash  = nullptr;
+    size_t            gnuWords = 0;     // 32-bit words available at gnuHash
+    const uint32_t*   sysvHash = nullptr;
+    size_t            sysvWords = 0;
+
+    explicit operator bool() const { return syms && strtab; }
+
+    // st_value of a defined symbol, or 0
+    ElfW(Addr) find(const char* name) const {
+        if (!*this) return 0;
+        if (gnuHash) return findGnu(name);
+        if (sysvHash) return findSysv(name);
+        return findLinear(name);
+    }
+
+private:
+    bool matches(size_t idx, const char* name) const {
+        if (idx >= count) return false;
+        const ElfW(Sym)& s = syms[idx];
+        if (s.st_shndx == SHN_UNDEF || !s.st_value || s.st_name >= strSize) return false;
+        if ((s.st_info & 0xF) == STT_GNU_IFUNC) return false;   // st_value is the resolver
+        return strncmp(strtab + s.st_name, name, strSize - s.st_name) == 0;
+    }
+
+    ElfW(Addr) findLinear(const char* name) const {
+        for (size_t i = 0; i < count; i++) {
+            if (matches(i, name)) return syms[i].st_value;
+        }
+        return 0;
+    }
+
+    ElfW(Addr) findGnu(const char* name) const {
+        uint32_t h = 5381;
+        for (const uint8_t* c = (const uint8_t*)name; *c; c++) h = h * 33 + *c;
+
+        if (gnuWords < 4) return 0;
+        uint32_t nbuckets = gnuHash[0], symoffset = gnuHash[1];
+        uint32_t bloomSize = gnuHash[2], bloomShift = gnuHash[3];
+        constexpr uint32_t kWordBits = sizeof(ElfW(Addr)) * 8;
+        constexpr size_t kBloomWords = sizeof(ElfW(Addr)) / sizeof(uint32_t);
+
+        size_t header = 4 + (size_t)bloomSize * kBloomWords;
+        if (!nbuckets || !bloomSize || header + nbuckets > gnuWords) return 0;
+        const ElfW(Addr)* bloom = (const ElfW(Addr)*)(gnuHash + 4);
+        const uint32_t* buckets = gnuHash + header;
+        const uint32_t* chain = buckets + nbuckets;
+        size_t chainWords = gnuWords - header - nbuckets;
+
+        ElfW(Addr) word = bloom[(h / kWordBits) % bloomSize];
+        ElfW(Addr) mask = ((ElfW(Addr))1 << (h % kWordBits)) |
+                          ((ElfW(Addr))1 << ((h >> bloomShift) % kWordBits));
+        if ((word & mask) != mask) return 0;
+
+        uint32_t idx = buckets[h % nbuckets];
+        if (idx < symoffset) return 0;
+        for (; idx - symoffset < chainWords; idx++) {
+            uint32_t h2 = chain[idx - symoffset];
+            if ((h | 1) == (h2 | 1) && matches(idx, name)) return syms[idx].st_value;
+            if (h2 & 1) break;
+        }
+        return 0;
+    }
+
+    ElfW(Addr) findSysv(const char* name) const {
+        uint32_t h = 0;
+        for (const uint8_t* c = (const uint8_t*)name; *c; c++) {
+            h = (h << 4) + *c;
+            uint32_t g = h & 0xF0000000;
+            h ^= g ^ (g >> 24);
+        }
+
+        if (sysvWords < 2) return 0;
+        uint32_t nbucket = sysvHash[0], nchain = sysvHash[1];
+        if (!nbucket || 2 + (size_t)nbucket + nchain > sysvWords) return 0;
+        const uint32_t* bucket = sysvHash + 2;
+        const uint32_t* chain = bucket + nbucket;
+
+        uint32_t steps = 0;
+        for (uint32_t i = bucket[h % nbucket]; i && i < nchain && steps++ < nchain; i = chain[i]) {
+            if (matches(i, name)) return syms[i].st_value;
+        }
+        return 0;
+    }
+};
+
+// Section lookup over an in-memory ELF image (the mapped file or decompressed debugdata)
+class SectionView {
+public:
+    SectionView(const uint8_t* data, size_t size) : data_(data), size_(size) {
+        if (size_ < sizeof(ElfW(Ehdr))) return;
+        const auto* eh = (const ElfW(Ehdr)*)data_;
+        if (memcmp(eh->e_ident, ELFMAG, SELFMAG) != 0) return;
+        if (eh->e_ident[EI_CLASS] != (sizeof(void*) == 8 ? ELFCLASS64 : ELFCLASS32)) return;
+        if (eh->e_shentsize != sizeof(ElfW(Shdr)) || !inBounds(eh->e_shoff, (size_t)eh->e_shnum * sizeof(ElfW(Shdr)))) return;
+        shdrs_ = (const ElfW(Shdr)*)(data_ + eh->e_shoff);
+        shnum_ = eh->e_shnum;
+        if (eh->e_shstrndx < shnum_) shstr_ = &shdrs_[eh->e_shstrndx];
+    }
+
+    explicit operator bool() const { return shdrs_ != nullptr; }
+
+    const ElfW(Shdr)* byType(uint32_t type) const {
+        for (size_t i = 0; i < shnum_; i++) {
+            if (shdrs_[i].sh_type == type) return &shdrs_[i];
+        }
+        return nullptr;
+    }
+
+    const ElfW(Shdr)* byName(const char* name) const {
+        if (!shstr_ || !inBounds(shstr_->sh_offset, shstr_->sh_size)) return nullptr;
+        const char* names = (const char*)data_ + shstr_->sh_offset;
+        size_t len = strlen(name);
+        for (size_t i = 0; i < shnum_; i++) {
+            size_t off = shdrs_[i].sh_name;
+            if (off + len < shstr_->sh_size && !memcmp(names + off, name, len + 1)) return &shdrs_[i];
+        }
+        return nullptr;
+    }
+
+    // Contents of a section that occupies file space, or nullptr
+    const uint8_t* contents(const ElfW(Shdr)* sh) const {
+        if (!sh || sh->sh_type == SHT_NOBITS || !inBounds(sh->sh_offset, sh->sh_size)) return nullptr;
+        return data_ + sh->sh_offset;
+    }
+
+    const ElfW(Shdr)* link(const ElfW(Shdr)* sh) const {
+        return sh && sh->sh_link < shnum_ ? &shdrs_[sh->sh_link] : nullptr;
+    }
+
+    // Symbol table of `type` (SHT_DYNSYM / SHT_SYMTAB) with its linked string table
+    SymbolTable symbols(uint32_t type) const {
+        SymbolTable t;
+        const ElfW(Shdr)* sym = byType(type);
+        const ElfW(Shdr)* str = link(sym);
+        const uint8_t* symData = contents(sym);
+        const uint8_t* strData = contents(str);
+        if (!symData || !strData) return t;
+        t.syms    = (const ElfW(Sym)*)symData;
+        t.count   = sym->sh_size / sizeof(ElfW(Sym));
+        t.strtab  = (const char*)strData;
+        t.strSize = str->sh_size;
+        return t;
+    }
+
+private:
+    const uint8_t*     data_;
+    size_t             size_;
+    const ElfW(Shdr)*  shdrs_ = nullptr;
+    size_t             shnum_ = 0;
+    const ElfW(Shdr)*  shstr_ = nullptr;
+
+    bool inBounds(uint64_t off, uint64_t len) const {
+        return off <= size_ && len <= size_ - off;
+    }
+};
+
+class Image {
+public:
+    // Find a loaded library whose path ends with `name` ("libart.so") and map its file
+    explicit Image(const char* name) {
+        struct Search {
+            const char* name;
+            size_t      len;
+            std::string path;
+            uintptr_t   bias;
+            bool        found;
+        } search = { name, strlen(name), {}, 0, false };
+
+        dl_iterate_phdr([](struct dl_phdr_info* info, size_t, void* arg) -> int {
+            auto* s = (Search*)arg;
+            const char* path = info->dlpi_name;
+            size_t len = path ? strlen(path) : 0;
+            if (len < s->len || strcmp(path + len - s->len, s->name) != 0) return 0;
+            if (len > s->len && path[len - s->len - 1] != '/') return 0;
+            s->path = path;
+            s->bias = info->dlpi_addr;
+            s->found = true;
+            return 1;
+        }, &search);
+        if (!search.found) return;
+
+        int fd = open(search.path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* map = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map != MAP_FAILED) {
+                file_ = (const uint8_t*)map;
+                fileSize_ = (size_t)st.st_size;
+            }
+        }
+        close(fd);
+        if (!file_) return;
+
+        path_ = std::move(search.path);
+        bias_ = search.bias;
+        SectionView view(file_, fileSize_);
+        if (!view) return;
+
+        dynsym_ = view.symbols(SHT_DYNSYM);
+        if (const ElfW(Shdr)* gnu = view.byType(SHT_GNU_HASH)) {
+            dynsym_.gnuHash  = (const uint32_t*)view.contents(gnu);
+            dynsym_.gnuWords = dynsym_.gnuHash ? gnu->sh_size / 4 : 0;
+        }
+        if (const ElfW(Shdr)* sysv = view.byType(SHT_HASH)) {
+            dynsym_.sysvHash  = (const uint32_t*)view.contents(sysv);
+            dynsym_.sysvWords = dynsym_.sysvHash ? sysv->sh_size / 4 : 0;
+        }
+        symtab_ = view.symbols(SHT_SYMTAB);
+
+        const ElfW(Shdr)* dbg = view.byName(".gnu_debugdata");
+        if (const uint8_t* packed = view.contents(dbg)) {
+            debugPacked_ = packed;
+            debugPackedSize_ = dbg->sh_size;
+        }
+    }
+
+    ~Image() {
+        if (file_) munmap((void*)file_, fileSize_);
+    }
+
+    Image(const Image&) = delete;
+    Image& operator=(const Image&) = delete;
+
+    bool valid() const { return file_ != nullptr; }
+    const std::string& path() const { return path_; }
+    uintptr_t bias() const { return bias_; }
+
+    // Runtime address of `name`, or nullptr. MiniDebugInfo is only unpacked when the
+    // symbol is in neither .dynsym nor .symtab.
+    void* symbol(const char* name) {
+        if (!file_) return nullptr;
+        ElfW(Addr) value = dynsym_.find(name);
+        if (!value) value = symtab_.find(name);
+        if (!value && loadDebugData()) value = debugSymtab_.find(name);
+        return value ? (void*)(bias_ + value) : nullptr;
+    }
+
+private:
+    const uint8_t* file_ = nullptr;
+    size_t         fileSize_ = 0;
+    std::string    path_;
+    uintptr_t      bias_ = 0;
+    SymbolTable    dynsym_;
+    SymbolTable    symtab_;
+
+    const uint8_t*       debugPacked_ = nullptr;
+    size_t               debugPackedSize_ = 0;
+    bool                 debugTried_ = false;
+    std::vector<uint8_t> debugData_;
+    SymbolTable          debugSymtab_;
+
+    bool loadDebugData() {
+        if (debugTried_) return (bool)debugSymtab_;
+        debugTried_ = true;
+        if (!debugPacked_ || !xz::decode(debugPacked_, debugPackedSize_, &debugData_)) return false;
+        SectionView view(debugData_.data(), debugData_.size());
+        if (view) debugSymtab_ = view.symbols(SHT_SYMTAB);
+        return (bool)debugSymtab_;
+    }
+};
+
+} // namespace elf
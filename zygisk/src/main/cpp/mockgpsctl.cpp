@@ -0,0 +1,439 @@
+// mockgpsctl - change the live config, for the UIs and scripts
+//
+//   mockgpsctl set [-p PROFILE] KEY=VALUE...  change these keys of the defaults (or
+//                                             of PROFILE); the rest of the config stays
+//   mockgpsctl set [-p PROFILE]               the same with KEY=VALUE lines from stdin
+//   mockgpsctl get [-p PROFILE] [KEY...]      print the keys (all by default) as
+//                                             KEY=VALUE lines, PROFILE resolved
+//   mockgpsctl toggle [-p PROFILE] KEY        flip enabled, hidedev or route, print KEY=VALUE
+//   mockgpsctl stats                          per-package hook call rates and latency
+//   mockgpsctl serve                          answer binary requests on stdin until it
+//                                             closes (the app's root helper, see below)
+//
+// set and toggle validate the change, merge it into location.bin under its lock and
+// replace the file atomically, then have the companion publish it over its control
+// socket: when they exit 0, every hooked process already sees the change. Without a
+// reachable companion the file is still written and applies on its next reload.
+// Exit status: 0 ok, 1 invalid input or config, 2 usage or I/O error.
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include <poll.h>
+#include <sys/inotify.h>
+
+#include "config_file.hpp"
+#include "stats.hpp"
+
+#ifndef MOCKGPS_MODULE_DIR
+#define MOCKGPS_MODULE_DIR "/data/adb/modules/mockgps"
+#endif
+
+static const char* BIN_PATH  = MOCKGPS_MODULE_DIR "/location.bin";
+static const char* TEXT_PATH = MOCKGPS_MODULE_DIR "/location.conf";
+
+// Where diagnostics go: stderr, or while serving the current request's reply
+static FILE* g_err = stderr;
+
+static int usage() {
+    fprintf(stderr,
+            "usage: mockgpsctl set [-p PROFILE] [KEY=VALUE...]\n"
+            "       mockgpsctl get [-p PROFILE] [KEY...]\n"
+            "       mockgpsctl toggle [-p PROFILE] enabled|hidedev|route\n"
+            "       mockgpsctl stats\n"
+            "       mockgpsctl serve\n");
+    return 2;
+}
+
+static int loadCurrent(ConfigSet* set) {
+    if (loadCurrentConfig(BIN_PATH, TEXT_PATH, set) == ConfigLoad::kOk) return 0;
+    fprintf(g_err, "mockgpsctl: %s: bad header or checksum\n", BIN_PATH);
+    return 1;
+}
+
+// The keys of `profile` (a canonical profile key, empty for the defaults) as a
+// process using it gets them
+static MockConfig effectiveConfig(const ConfigSet& set, const std::string& profile) {
+    const ConfigProfile* p = profile.empty() ? nullptr : findProfile(set, profile);
+    return p ? resolveProfile(set.defaults, *p) : set.defaults;
+}
+
+// Config text that sets keys of `profile`
+static std::string profileHeader(const std::string& profile) {
+    return profile.empty() ? std::string() : "[" + profile + "]\n";
+}
+
+// Under the lock: load the current config, let makeChange(current, &text) produce
+// the change as config text, merge it, write the file. Then ask the companion to
+// publish it.
+template <class MakeChange>
+static int commit(MakeChange makeChange) {
+    int lock = lockConfigFile(BIN_PATH);
+    if (lock < 0) {
+        fprintf(g_err, "mockgpsctl: lock %s failed: %s\n", BIN_PATH, strerror(errno));
+        return 2;
+    }
+    ConfigSet current, change;
+    std::string text;
+    int r = loadCurrent(&current);
+    if (!r) r = makeChange(current, &text);
+    if (!r) {
+        ConfigErrors errors;
+        parseConfigSet(text, &change, &errors);
+        if (printConfigErrors(g_err, "mockgpsctl", errors)) r = 1;
+    }
+    if (!r && !mergeConfigSet(&current, change)) {
+        fprintf(g_err, "mockgpsctl: more than %zu profiles\n", kMaxProfiles);
+        r = 1;
+    }
+    if (!r && !writeConfigFileAtomic(BIN_PATH, current)) {
+        fprintf(g_err, "mockgpsctl: write %s failed: %s\n", BIN_PATH, strerror(errno));
+        r = 2;
+    }
+    close(lock);
+    if (r) return r;
+
+    uint32_t pages;
+    if (!requestReload(&pages)) {
+        fprintf(g_err, "mockgpsctl: companion not reachable on @%s; written, applies on its next reload\n",
+                MOCKGPS_STATS_SOCKET);
+    }
+    return 0;
+}
+
+// Every argument checked on its own first, so an error names it
+static bool checkAssignment(const char* arg) {
+    const char* eq = strchr(arg, '=');
+    if (!eq || strchr(arg, '\n')) {
+        fprintf(g_err, "mockgpsctl: expected KEY=VALUE, got '%s'\n", arg);
+        return false;
+    }
+    int key = configKeyIndex(trimConfigField(std::string_view(arg, eq - arg)));
+    if (key < 0) {
+        fprintf(g_err, "mockgpsctl: unknown key in '%s'\n", arg);
+        return false;
+    }
+    MockConfig scratch;
+    ConfigError e = setConfigValue(&scratch, key, trimConfigField(eq + 1));
+    if (e != ConfigError::kNone) {
+        fprintf(g_err, "mockgpsctl: %s: %s\n", arg, configErrorName(e));
+        return false;
+    }
+    return true;
+}
+
+// Config text from outside (stdin, a serve request): every line must parse, since
+// the merge would keep a bad value's old setting silently
+static int checkText(const char* name, const std::string& text) {
+    ConfigSet parsed;
+    ConfigErrors errors;
+    parseConfigSet(text, &parsed, &errors);
+    if (printConfigErrors(g_err, name, errors)) return 1;
+    if (errors.unknownKeys) {
+        fprintf(g_err, "%s: %u line(s) with an unknown key\n", name, errors.unknownKeys);
+        return 1;
+    }
+    return 0;
+}
+
+static int setText(std::string body) {
+    return commit([&](const ConfigSet&, std::string* text) {
+        *text = std::move(body);
+        return 0;
+    });
+}
+
+static int set(const std::string& profile, char** args, int count) {
+    std::string body = profileHeader(profile);
+    if (count) {
+        for (int i = 0; i < count; i++) {
+            if (!checkAssignment(args[i])) return 1;
+            body.append(args[i]).push_back('\n');
+        }
+    } else {
+        char buf[4096];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), stdin)) > 0) body.append(buf, n);
+        if (ferror(stdin)) {
+            fprintf(g_err, "mockgpsctl: read stdin failed\n");
+            return 2;
+        }
+        if (int r = checkText("<stdin>", body)) return r;
+    }
+    return setText(std::move(body));
+}
+
+static void printKey(int key, const MockConfig& cfg) {
+    char line[256];
+    int n = formatConfigKey(line, line + sizeof(line), key, cfg);
+    if (n > 0) fwrite(line, 1, n, stdout);
+}
+
+static int get(const std::string& profile, char** keys, int count) {
+    std::vector<int> which;
+    for (int i = 0; i < count; i++) {
+        int key = configKeyIndex(keys[i]);
+        if (key < 0) {
+            fprintf(g_err, "mockgpsctl: unknown key '%s'\n", keys[i]);
+            return 1;
+        }
+        which.push_back(key);
+    }
+    if (which.empty()) {
+        for (int i = 0; i < kConfigKeyCount; i++) which.push_back(i);
+    }
+
+    ConfigSet set;
+    if (int r = loadCurrent(&set)) return r;
+    MockConfig cfg = effectiveConfig(set, profile);
+    for (int key : which) printKey(key, cfg);
+    return 0;
+}
+
+// Flip enabled, hidedev or route of `profile`; `now` gets its config after the change
+static int toggleKey(const std::string& profile, int key, MockConfig* now) {
+    if (key != kKeyEnabled && key != kKeyHideDev && key != kKeyRoute) {
+        fprintf(g_err, "mockgpsctl: only enabled, hidedev and route can be toggled\n");
+        return 1;
+    }
+    return commit([&](const ConfigSet& current, std::string* text) {
+        *now = effectiveConfig(current, profile);
+        bool& flag = key == kKeyEnabled ? now->enabled : key == kKeyHideDev ? now->hideDev : now->route;
+        flag = !flag;
+        *text = profileHeader(profile) + kConfigKeyNames[key] + (flag ? "=1\n" : "=0\n");
+        return 0;
+    });
+}
+
+static int toggle(const std::string& profile, const char* name) {
+    int key = configKeyIndex(name);
+    MockConfig now;
+    int r = toggleKey(profile, key, &now);
+    if (!r) printKey(key, now);
+    return r;
+}
+
+static int stats() {
+    std::vector<StatsRecord> records;
+    if (!fetchStats(&records)) {
+        fprintf(g_err, "mockgpsctl: no reply from the companion on @%s\n", MOCKGPS_STATS_SOCKET);
+        return 2;
+    }
+    if (records.empty()) {
+        printf(MOCKGPS_TELEMETRY ? "no hooked processes yet\n" : "telemetry compiled out\n");
+    }
+    for (size_t i = 0; i < records.size(); i++) {
+        if (i) putchar('\n');
+        printStats(stdout, records[i]);
+    }
+    return 0;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// serve: the companion app's root helper
+// ═══════════════════════════════════════════════════════════════════
+//
+// The app starts `su -c "mockgpsctl serve"` once and keeps it, so no tap spawns a
+// process. Each request is a CtlFrame and `length` payload bytes on stdin; each
+// reply is one frame on stdout with the request's op and the exit status a command
+// line run would have had. All fields little-endian.
+//
+//   op             request payload           reply payload
+//   kCtlGet        [profile]                 ConfigRecord, the profile resolved
+//   kCtlSet        config text               -
+//   kCtlToggle     u8 ConfigKey, [profile]   ConfigRecord after the change
+//   kCtlSubscribe  -                         ConfigRecord of the defaults
+//
+// A failed request's reply carries the error text instead. After kCtlSubscribe the
+// helper also pushes a kCtlChanged frame with the new defaults whenever
+// location.bin or location.conf changes, whoever wrote it. The helper exits when
+// stdin closes.
+
+enum CtlOp : uint8_t {
+    kCtlGet = 1,
+    kCtlSet,
+    kCtlToggle,
+    kCtlSubscribe,
+    kCtlChanged,
+};
+
+struct CtlFrame {
+    uint8_t  op;
+    uint8_t  status;   // replies: 0, 1 or 2 as the exit status; 0 in requests
+    uint16_t length;   // payload bytes that follow
+};
+
+static_assert(sizeof(CtlFrame) == 4, "serve frame layout");
+
+static bool readFull(int fd, void* p, size_t n) {
+    for (char* at = (char*)p; n;) {
+        ssize_t r = read(fd, at, n);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        at += r;
+        n -= r;
+    }
+    return true;
+}
+
+static bool writeFrame(uint8_t op, int status, const void* payload, size_t len) {
+    if (len > UINT16_MAX) len = UINT16_MAX;
+    std::string out(sizeof(CtlFrame) + len, '\0');
+    CtlFrame frame{op, (uint8_t)status, (uint16_t)len};
+    memcpy(&out[0], &frame, sizeof(frame));
+    if (len) memcpy(&out[sizeof(frame)], payload, len);
+    for (size_t at = 0; at < out.size();) {
+        ssize_t r = write(STDOUT_FILENO, out.data() + at, out.size() - at);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        at += r;
+    }
+    return true;
+}
+
+static int getRecord(const std::string& profile, ConfigRecord* rec) {
+    ConfigSet set;
+    if (int r = loadCurrent(&set)) return r;
+    *rec = toConfigRecord(effectiveConfig(set, profile));
+    return 0;
+}
+
+static int profileArg(const char* p, size_t n, std::string* profile) {
+    profile->clear();
+    if (!n) return 0;
+    std::string name(p, n);
+    if (canonicalProfileKey(name.c_str(), profile)) return 0;
+    fprintf(g_err, "mockgpsctl: invalid profile name '%s'\n", name.c_str());
+    return 1;
+}
+
+// One request; fills `rec` and sets `withRecord` when the reply carries a config
+static int serveRequest(uint8_t op, const std::string& payload, ConfigRecord* rec, bool* withRecord) {
+    std::string profile;
+    int r;
+    switch (op) {
+    case kCtlGet:
+        r = profileArg(payload.data(), payload.size(), &profile);
+        if (!r) r = getRecord(profile, rec);
+        *withRecord = !r;
+        return r;
+    case kCtlSet:
+        r = checkText("<request>", payload);
+        return r ? r : setText(payload);
+    case kCtlToggle: {
+        if (payload.empty()) {
+            fprintf(g_err, "mockgpsctl: toggle without a key\n");
+            return 2;
+        }
+        r = profileArg(payload.data() + 1, payload.size() - 1, &profile);
+        MockConfig now;
+        if (!r) r = toggleKey(profile, (uint8_t)payload[0], &now);
+        if (!r) *rec = toConfigRecord(now);
+        *withRecord = !r;
+        return r;
+    }
+    case kCtlSubscribe:
+        r = getRecord(profile, rec);
+        *withRecord = !r;
+        return r;
+    default:
+        fprintf(g_err, "mockgpsctl: unknown request %u\n", op);
+        return 2;
+    }
+}
+
+// After kCtlSubscribe: push the defaults if a write to the module dir changed them
+static bool pushIfChanged(int watch, ConfigRecord* pushed) {
+    alignas(struct inotify_event) char buf[4096];
+    bool relevant = false;
+    ssize_t n;
+    while ((n = read(watch, buf, sizeof(buf))) > 0) {
+        for (char* p = buf; p < buf + n;) {
+            auto* e = (struct inotify_event*)p;
+            if (e->len && (!strcmp(e->name, strrchr(BIN_PATH, '/') + 1) ||
+                           !strcmp(e->name, strrchr(TEXT_PATH, '/') + 1))) {
+                relevant = true;
+            }
+            p += sizeof(*e) + e->len;
+        }
+    }
+    // Quietly: a file mid-replace is read again on the next event
+    ConfigSet set;
+    if (!relevant || loadCurrentConfig(BIN_PATH, TEXT_PATH, &set) != ConfigLoad::kOk) return true;
+    ConfigRecord now = toConfigRecord(set.defaults);
+    if (!memcmp(&now, pushed, sizeof(now))) return true;
+    *pushed = now;
+    return writeFrame(kCtlChanged, 0, &now, sizeof(now));
+}
+
+static int serve() {
+    signal(SIGPIPE, SIG_IGN);
+    int watch = -1;
+    ConfigRecord pushed = {};
+    std::string payload;
+    for (;;) {
+        struct pollfd fds[2] = {{STDIN_FILENO, POLLIN, 0}, {watch, POLLIN, 0}};
+        if (poll(fds, watch >= 0 ? 2 : 1, -1) < 0) {
+            if (errno == EINTR) continue;
+            return 2;
+        }
+        if (watch >= 0 && (fds[1].revents & POLLIN) && !pushIfChanged(watch, &pushed)) return 0;
+        if (!fds[0].revents) continue;
+
+        CtlFrame req;
+        if (!readFull(STDIN_FILENO, &req, sizeof(req))) return 0;   // the app closed the session
+        payload.resize(req.length);
+        if (req.length && !readFull(STDIN_FILENO, &payload[0], req.length)) return 0;
+
+        char* msg = nullptr;
+        size_t msgLen = 0;
+        g_err = open_memstream(&msg, &msgLen);
+        if (!g_err) return 2;
+        ConfigRecord rec;
+        bool withRecord = false;
+        int r = serveRequest(req.op, payload, &rec, &withRecord);
+        fclose(g_err);
+        g_err = stderr;
+
+        if (req.op == kCtlSubscribe && !r) {
+            if (watch < 0) {
+                watch = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+                if (watch >= 0 && inotify_add_watch(watch, MOCKGPS_MODULE_DIR, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+                    close(watch);
+                    watch = -1;
+                }
+            }
+            pushed = rec;
+        }
+        bool ok = withRecord ? writeFrame(req.op, r, &rec, sizeof(rec))
+                             : writeFrame(req.op, r, msg, r ? msgLen : 0);
+        free(msg);
+        if (!ok) return 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) return usage();
+    const char* cmd = argv[1];
+    if (!strcmp(cmd, "stats")) return argc == 2 ? stats() : usage();
+    if (!strcmp(cmd, "serve")) return argc == 2 ? serve() : usage();
+
+    std::string profile;
+    int i = 2;
+    if (i + 1 < argc && !strcmp(argv[i], "-p")) {
+        if (!canonicalProfileKey(argv[i + 1], &profile)) {
+            fprintf(stderr, "mockgpsctl: invalid profile name '%s'\n", argv[i + 1]);
+            return 1;
+        }
+        i += 2;
+    }
+    if (!strcmp(cmd, "set")) return set(profile, argv + i, argc - i);
+    if (!strcmp(cmd, "get")) return get(profile, argv + i, argc - i);
+    if (!strcmp(cmd, "toggle")) return argc - i == 1 ? toggle(profile, argv[i]) : usage();
+    return usage();
+}
@@ -0,0 +1,358 @@
+// MockGPS - Hook telemetry shared by app processes, the companion and the tools
+//
+// The companion keeps one StatsPage per package: a sealed memfd (writable, but it
+// can never be resized) that every hooked process of the package maps read-write.
+// Processes only add to it with relaxed atomics, so counts from concurrent threads
+// and processes merge without locks. `mockgpsconf stats` asks the companion for a
+// snapshot of every page over a root-only abstract socket.
+//
+// Hook calls are counted per thread and added to the page on a thread's first call
+// of a hook and then every kLatencySampleEvery calls, so the hot path touches no
+// shared cache line; a thread's last few calls may not be published yet. The call
+// that publishes is also timed with CLOCK_MONOTONIC into a log2 histogram. Every
+// run of a specialize phase is timed the same way (module.cpp also marks it as an
+// ATrace section). Building with MOCKGPS_TELEMETRY=0 compiles the timers away and
+// the companion hands out no pages; the socket stays and reports nothing.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#ifndef MOCKGPS_TELEMETRY
+#define MOCKGPS_TELEMETRY 1
+#endif
+
+// Abstract socket name; host builds use their own
+#ifndef MOCKGPS_STATS_SOCKET
+#define MOCKGPS_STATS_SOCKET "mockgps.stats"
+#endif
+
+static constexpr uint32_t kStatsMagic   = 0x5453474d;  // "MGST"
+static constexpr uint32_t kStatsVersion = 4;
+
+// Same order as HookId in module.cpp
+static constexpr int kStatsHookCount = 13;
+static constexpr const char* kStatsHookNames[kStatsHookCount] = {
+    "isFromMockProvider", "isMock", "getLatitude", "getLongitude", "getAccuracy", "getAltitude",
+    "getSpeed", "getBearing", "getTime", "getElapsedRealtimeNanos",
+    "Secure.getInt(3)", "Secure.getInt(2)", "Global.getInt(3)",
+};
+
+// Startup phases of a hooked process, in the order they run; those with an
+// indented comment run inside the phase above them (phaseNested)
+enum StatsPhase {
+    kPhasePreSpecialize,     // all of preAppSpecialize
+    kPhaseCompanionWait,     //   connect, request, config reply
+    kPhaseCacheAdopt,        //   taking over the zygote's detection results
+    kPhaseLayoutDetect,      //   ArtMethod layout detection (cache miss)
+    kPhaseTrampolineFind,    //   JNI trampoline discovery (cache miss)
+    kPhaseHookResolve,       //   hook target lookup (cache miss)
+    kPhasePostSpecialize,    // all of postAppSpecialize
+    kPhaseHookInstall,       //   first applyHookState
+    kPhaseControllerStart,   //   hook controller thread creation
+    kStatsPhaseCount
+};
+
+static constexpr const char* kStatsPhaseNames[kStatsPhaseCount] = {
+    "preAppSpecialize", "companion wait", "cache adopt", "layout detection", "trampoline discovery",
+    "hook resolve", "postAppSpecialize", "hook install", "controller start",
+};
+
+inline bool phaseNested(int phase) {
+    return phase != kPhasePreSpecialize && phase != kPhasePostSpecialize;
+}
+
+static constexpr uint32_t kLatencySampleEvery = 64;   // at most 256
+static constexpr int      kLatencyBuckets     = 32;   // bucket i: [2^i, 2^(i+1)) ns, last open
+
+inline int latencyBucket(uint64_t ns) {
+    int b = ns ? 63 - __builtin_clzll(ns) : 0;
+    return b < kLatencyBuckets ? b : kLatencyBuckets - 1;
+}
+
+struct LatencyHistogram {
+    std::atomic<uint32_t> buckets[kLatencyBuckets];
+
+    void record(uint64_t ns) { buckets[latencyBucket(ns)].fetch_add(1, std::memory_order_relaxed); }
+};
+
+struct HookStats {
+    std::atomic<uint64_t> calls;
+    std::atomic<uint64_t> sampledNs;    // total time of the sampled calls
+    std::atomic<uint32_t> sampled;
+    LatencyHistogram      latency;
+};
+
+struct PhaseStats {
+    std::atomic<uint64_t> totalNs;
+    std::atomic<uint32_t> count;
+    LatencyHistogram      latency;
+};
+
+struct StatsPage {
+    uint32_t              magic;
+    uint32_t              version;
+    uint64_t              createdNs;    // CLOCK_BOOTTIME when the companion created the page
+    std::atomic<uint32_t> processes;    // hooked processes handed this page
+    HookStats             hooks[kStatsHookCount];
+    PhaseStats            phases[kStatsPhaseCount];
+};
+
+static_assert(sizeof(StatsPage) <= 4096, "StatsPage must fit one page");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "StatsPage is shared between processes");
+
+inline uint64_t statsClockNs(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Recording
+// ═══════════════════════════════════════════════════════════════════
+
+#if MOCKGPS_TELEMETRY
+
+// Calls of each hook on this thread not yet added to the page, and calls left
+// until the next publish (0: the next call publishes)
+struct ThreadHookCounts {
+    uint32_t unpublished[kStatsHookCount];
+    uint8_t  untilPublish[kStatsHookCount];
+};
+
+inline thread_local ThreadHookCounts t_hookCounts;
+
+// Counts one call of `id`; publishes and times it if it is the sampled one
+class HookTimer {
+public:
+    HookTimer(StatsPage* page, int id) {
+        if (!page) return;
+        ThreadHookCounts& t = t_hookCounts;
+        t.unpublished[id]++;
+        if (t.untilPublish[id]) {
+            t.untilPublish[id]--;
+            return;
+        }
+        t.untilPublish[id] = kLatencySampleEvery - 1;
+        stats_ = &page->hooks[id];
+        stats_->calls.fetch_add(t.unpublished[id], std::memory_order_relaxed);
+        t.unpublished[id] = 0;
+        start_ = statsClockNs(CLOCK_MONOTONIC);
+    }
+
+    ~HookTimer() {
+        if (!start_) return;
+        uint64_t ns = statsClockNs(CLOCK_MONOTONIC) - start_;
+        stats_->sampled.fetch_add(1, std::memory_order_relaxed);
+        stats_->sampledNs.fetch_add(ns, std::memory_order_relaxed);
+        stats_->latency.record(ns);
+    }
+
+    HookTimer(const HookTimer&) = delete;
+    HookTimer& operator=(const HookTimer&) = delete;
+
+private:
+    HookStats* stats_ = nullptr;
+    uint64_t   start_ = 0;
+};
+
+inline void recordPhase(StatsPage* page, StatsPhase phase, uint64_t ns) {
+    PhaseStats& p = page->phases[phase];
+    p.count.fetch_add(1, std::memory_order_relaxed);
+    p.totalNs.fetch_add(ns, std::memory_order_relaxed);
+    p.latency.record(ns);
+}
+
+#endif  // MOCKGPS_TELEMETRY
+
+// ═══════════════════════════════════════════════════════════════════
+// Report
+// ═══════════════════════════════════════════════════════════════════
+//
+// A client sends one StatsRequest. kStatsCmdReport is answered with a
+// StatsReportHeader and `count` StatsRecords, plain copies of the pages, so the tool
+// formats them and the companion only copies. kStatsCmdFlushLogs makes every hooked
+// process (and the companion) flush its log ring (log.hpp); the reply is a header
+// whose `count` is the number of config pages signalled. kStatsCmdTraceStart starts
+// a hook call trace sampling one call in `arg` (trace.hpp), answered with a bare
+// header; kStatsCmdTraceStop ends it and answers with a header whose `count` is the
+// size of the trace file that follows. kStatsCmdReload has the companion read the
+// config file and publish it before replying (`count`: config pages woken, 0 if
+// the file was unchanged or unreadable), so `mockgpsctl` need not wait for inotify.
+
+static constexpr size_t kStatsKeyMax = 128;
+
+struct StatsHistogram {
+    uint32_t buckets[kLatencyBuckets];
+};
+
+struct StatsRecord {
+    char     key[kStatsKeyMax];    // package or "uid:<n>", NUL-terminated
+    uint64_t ageNs;                // since the page was created
+    uint32_t processes;
+    uint32_t reserved;
+    struct {
+        uint64_t       calls;
+        uint64_t       sampledNs;
+        uint32_t       sampled;
+        uint32_t       reserved;
+        StatsHistogram latency;
+    } hooks[kStatsHookCount];
+    struct {
+        uint64_t       totalNs;
+        uint32_t       count;
+        uint32_t       reserved;
+        StatsHistogram latency;
+    } phases[kStatsPhaseCount];
+};
+
+enum StatsCommand : uint32_t {
+    kStatsCmdReport,
+    kStatsCmdFlushLogs,
+    kStatsCmdTraceStart,
+    kStatsCmdTraceStop,
+    kStatsCmdReload,
+};
+
+struct StatsRequest {
+    uint32_t magic;
+    uint32_t command;   // StatsCommand
+    uint32_t arg;
+};
+
+struct StatsReportHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t recordSize;
+};
+
+inline void copyHistogram(const LatencyHistogram& h, StatsHistogram* out) {
+    for (int i = 0; i < kLatencyBuckets; i++) out->buckets[i] = h.buckets[i].load(std::memory_order_relaxed);
+}
+
+inline void snapshotStats(const char* key, const StatsPage& page, StatsRecord* out) {
+    memset(out, 0, sizeof(*out));
+    strncpy(out->key, key, sizeof(out->key) - 1);
+    out->ageNs     = statsClockNs(CLOCK_BOOTTIME) - page.createdNs;
+    out->processes = page.processes.load(std::memory_order_relaxed);
+    for (int i = 0; i < kStatsHookCount; i++) {
+        out->hooks[i].calls     = page.hooks[i].calls.load(std::memory_order_relaxed);
+        out->hooks[i].sampledNs = page.hooks[i].sampledNs.load(std::memory_order_relaxed);
+        out->hooks[i].sampled   = page.hooks[i].sampled.load(std::memory_order_relaxed);
+        copyHistogram(page.hooks[i].latency, &out->hooks[i].latency);
+    }
+    for (int i = 0; i < kStatsPhaseCount; i++) {
+        out->phases[i].totalNs = page.phases[i].totalNs.load(std::memory_order_relaxed);
+        out->phases[i].count   = page.phases[i].count.load(std::memory_order_relaxed);
+        copyHistogram(page.phases[i].latency, &out->phases[i].latency);
+    }
+}
+
+// Upper bound (ns) of the bucket holding quantile q
+inline uint64_t histogramQuantile(const StatsHistogram& h, double q) {
+    uint64_t total = 0;
+    for (uint32_t b : h.buckets) total += b;
+    if (!total) return 0;
+    uint64_t rank = (uint64_t)(q * (double)(total - 1)) + 1, seen = 0;
+    for (int i = 0; i < kLatencyBuckets; i++) {
+        seen += h.buckets[i];
+        if (seen >= rank) return 2ull << i;
+    }
+    return 2ull << (kLatencyBuckets - 1);
+}
+
+inline socklen_t statsSocketAddress(struct sockaddr_un* addr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    // Abstract namespace: leading NUL, no file to clean up
+    memcpy(addr->sun_path + 1, MOCKGPS_STATS_SOCKET, sizeof(MOCKGPS_STATS_SOCKET) - 1);
+    return (socklen_t)(offsetof(struct sockaddr_un, sun_path) + 1 + sizeof(MOCKGPS_STATS_SOCKET) - 1);
+}
+
+// Connect, send `command` and read the reply header; the socket to read the rest
+// of the reply from, or -1 on any failure
+inline int statsCommand(StatsCommand command, StatsReportHeader* header, uint32_t arg = 0) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    struct sockaddr_un addr;
+    socklen_t len = statsSocketAddress(&addr);
+    StatsRequest req = { kStatsMagic, command, arg };
+    if (connect(fd, (struct sockaddr*)&addr, len) == 0 &&
+        send(fd, &req, sizeof(req), MSG_NOSIGNAL) == (ssize_t)sizeof(req) &&
+        recv(fd, header, sizeof(*header), MSG_WAITALL) == (ssize_t)sizeof(*header) &&
+        header->magic == kStatsMagic && header->version == kStatsVersion) {
+        return fd;
+    }
+    close(fd);
+    return -1;
+}
+
+// Fetch every record from the companion; false if it is not reachable or the reply is bad
+inline bool fetchStats(std::vector<StatsRecord>* out) {
+    StatsReportHeader header;
+    int fd = statsCommand(kStatsCmdReport, &header);
+    if (fd < 0) return false;
+    bool ok = header.recordSize == sizeof(StatsRecord);
+    if (ok) {
+        out->resize(header.count);
+        size_t bytes = header.count * sizeof(StatsRecord);
+        ok = !bytes || recv(fd, out->data(), bytes, MSG_WAITALL) == (ssize_t)bytes;
+    }
+    close(fd);
+    return ok;
+}
+
+// Ask the companion to have every process flush its log ring; false if unreachable
+inline bool flushLogs(uint32_t* pages) {
+    StatsReportHeader header;
+    int fd = statsCommand(kStatsCmdFlushLogs, &header);
+    if (fd < 0) return false;
+    close(fd);
+    *pages = header.count;
+    return true;
+}
+
+// Have the companion publish the config file now; false if unreachable
+inline bool requestReload(uint32_t* pages) {
+    StatsReportHeader header;
+    int fd = statsCommand(kStatsCmdReload, &header);
+    if (fd < 0) return false;
+    close(fd);
+    *pages = header.count;
+    return true;
+}
+
+inline void printStats(FILE* out, const StatsRecord& r) {
+    double seconds = r.ageNs / 1e9;
+    fprintf(out, "%s  processes=%u  window=%.1fs\n", r.key, r.processes, seconds);
+    fprintf(out, "  %-26s %12s %10s %9s %9s %9s\n", "hook", "calls", "calls/s", "mean ns", "p50 ns", "p99 ns");
+    for (int i = 0; i < kStatsHookCount; i++) {
+        const auto& h = r.hooks[i];
+        if (!h.calls) continue;
+        fprintf(out, "  %-26s %12llu %10.1f %9llu %9llu %9llu\n", kStatsHookNames[i], (unsigned long long)h.calls,
+                seconds > 0 ? h.calls / seconds : 0.0,
+                (unsigned long long)(h.sampled ? h.sampledNs / h.sampled : 0),
+                (unsigned long long)histogramQuantile(h.latency, 0.5),
+                (unsigned long long)histogramQuantile(h.latency, 0.99));
+    }
+    fprintf(out, "  %-26s %12s %10s %9s %9s %9s\n", "phase", "runs", "", "mean us", "p50 us", "p99 us");
+    for (int i = 0; i < kStatsPhaseCount; i++) {
+        const auto& p = r.phases[i];
+        if (!p.count) continue;
+        fprintf(out, "  %s%-*s %12u %10s %9.1f %9.1f %9.1f\n", phaseNested(i) ? "  " : "",
+                phaseNested(i) ? 24 : 26, kStatsPhaseNames[i], p.count, "",
+                p.totalNs / 1e3 / p.count, histogramQuantile(p.latency, 0.5) / 1e3,
+                histogramQuantile(p.latency, 0.99) / 1e3);
+    }
+}
@@ -0,0 +1,273 @@
+// MockGPS - Sampled hook call tracer
+//
+// Opt-in (`mockgpsconf trace start`): while a session runs, each hook records one
+// call in `every` per thread as an event {CLOCK_BOOTTIME time, thread, hook} into a
+// ring owned by the calling thread, so the hook path takes no lock and shares no
+// cache line. The process's hook controller thread drains the rings every
+// kTraceDrainMs into the package's TraceBuffer, which follows the StatsPage in the
+// same memfd. `mockgpsconf trace stop FILE` collects every buffer into one compact
+// binary trace (TraceFileHeader, then per package a TracePackage and its
+// TraceEvents), and host/tools/trace2perfetto turns that into a Perfetto trace.
+//
+// Outside a session a hook pays one load and one branch (traceEnabled()).
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "stats.hpp"
+
+static constexpr uint32_t kTraceMagic   = 0x5254474d;  // "MGTR"
+static constexpr uint32_t kTraceVersion = 1;
+
+static constexpr uint32_t kTraceBufferEvents = 16384;   // per package and session
+static constexpr uint32_t kTraceRingEvents   = 256;     // per thread, power of two
+static constexpr uint32_t kTraceRings        = 32;      // threads per process that can trace at once
+static constexpr int      kTraceDrainMs      = 50;
+
+// ═══════════════════════════════════════════════════════════════════
+// Trace file
+// ═══════════════════════════════════════════════════════════════════
+
+struct TraceEvent {
+    uint64_t timeNs;   // CLOCK_BOOTTIME, Perfetto's default trace clock
+    uint32_t pid;
+    uint32_t tidHook;  // tid << 8 | hook id (kStatsHookNames)
+};
+
+inline uint32_t traceTid(const TraceEvent& e) { return e.tidHook >> 8; }
+inline int traceHook(const TraceEvent& e) { return (int)(e.tidHook & 0xff); }
+
+struct TraceFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t packages;
+    uint32_t every;      // sampling: one call in `every` per thread
+    uint64_t startNs;    // CLOCK_BOOTTIME at trace start
+    uint64_t stopNs;
+};
+
+struct TracePackage {
+    char     key[kStatsKeyMax];   // as in StatsRecord
+    uint32_t events;              // TraceEvents that follow
+    uint32_t dropped;             // lost to full rings or a full buffer
+};
+
+// ═══════════════════════════════════════════════════════════════════
+// Shared buffer
+// ═══════════════════════════════════════════════════════════════════
+//
+// Filled front to back by every process of the package: a drain claims a range
+// with one fetch_add on `head`, writes the events, and commits each by storing its
+// time last. Slots past the end count as dropped. The companion clears the buffer
+// when a session starts and reads the committed slots when it stops.
+
+struct TraceSlot {
+    std::atomic<uint64_t> timeNs;   // 0 until committed
+    std::atomic<uint32_t> pid;
+    std::atomic<uint32_t> tidHook;
+};
+
+struct TraceBuffer {
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> dropped;
+    TraceSlot             slots[kTraceBufferEvents];
+};
+
+// The per-package memfd: the StatsPage, then the TraceBuffer from the next page on
+static constexpr size_t kTraceBufferOffset = 4096;
+static constexpr size_t kStatsRegionSize   = kTraceBufferOffset + sizeof(TraceBuffer);
+
+static_assert(sizeof(StatsPage) <= kTraceBufferOffset, "StatsPage overlaps the trace buffer");
+
+inline TraceBuffer* traceBufferOf(StatsPage* page) {
+    return (TraceBuffer*)((char*)page + kTraceBufferOffset);
+}
+
+inline void clearTraceBuffer(TraceBuffer* buf) {
+    for (auto& s : buf->slots) s.timeNs.store(0, std::memory_order_relaxed);
+    buf->dropped.store(0, std::memory_order_relaxed);
+    buf->head.store(0, std::memory_order_release);
+}
+
+// Committed events of a buffer, appended to `out`; returns how many
+inline uint32_t collectTraceBuffer(const TraceBuffer& buf, std::vector<TraceEvent>* out) {
+    uint32_t end = buf.head.load(std::memory_order_acquire);
+    if (end > kTraceBufferEvents) end = kTraceBufferEvents;
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < end; i++) {
+        uint64_t t = buf.slots[i].timeNs.load(std::memory_order_acquire);
+        if (!t) continue;
+        out->push_back(TraceEvent{t, buf.slots[i].pid.load(std::memory_order_relaxed),
+                                  buf.slots[i].tidHook.load(std::memory_order_relaxed)});
+        n++;
+    }
+    return n;
+}
+
+// Start a session sampling one call in `every` per thread; false if unreachable
+inline bool startTrace(uint32_t every) {
+    StatsReportHeader header;
+    int fd = statsCommand(kStatsCmdTraceStart, &header, every);
+    if (fd < 0) return false;
+    close(fd);
+    return true;
+}
+
+// End the session and fetch the trace file; false if unreachable or the reply is bad
+inline bool stopTrace(std::vector<char>* out) {
+    StatsReportHeader header;
+    int fd = statsCommand(kStatsCmdTraceStop, &header);
+    if (fd < 0) return false;
+    out->resize(header.count);
+    bool ok = header.count >= sizeof(TraceFileHeader) &&
+              recv(fd, out->data(), out->size(), MSG_WAITALL) == (ssize_t)out->size();
+    close(fd);
+    return ok;
+}
+
+#if MOCKGPS_TELEMETRY
+
+// ═══════════════════════════════════════════════════════════════════
+// Per-thread rings (app processes)
+// ═══════════════════════════════════════════════════════════════════
+//
+// Single producer (the owning thread, in the hooks) and single consumer (the
+// controller thread, in drainTraceRings). A full ring drops the event. A thread
+// claims a free ring on its first sampled call and gives it back when it exits;
+// events left in it are still drained, and the next owner appends after them.
+
+struct TraceRing {
+    std::atomic<uint32_t> owner;     // tid of the thread producing into it, 0 while free
+    std::atomic<uint32_t> head;      // written by the producer
+    std::atomic<uint32_t> tail;      // written by the consumer
+    std::atomic<uint32_t> dropped;
+    uint32_t              tid;
+    struct {
+        uint64_t timeNs;
+        uint32_t tidHook;
+    } events[kTraceRingEvents];
+};
+
+inline void releaseTraceRing(void* ring);
+
+struct TraceRings {
+    std::atomic<uint32_t> unringed{0};   // events of threads that found every ring taken
+    std::atomic<uint32_t> released{0};   // rings given back so far
+    pthread_key_t         exitKey;       // its destructor gives a thread's ring back
+    TraceRing             rings[kTraceRings];
+
+    TraceRings() { pthread_key_create(&exitKey, releaseTraceRing); }
+};
+
+inline TraceRings& traceRings() {
+    static TraceRings rings;
+    return rings;
+}
+
+inline void releaseTraceRing(void* ring) {
+    static_cast<TraceRing*>(ring)->owner.store(0, std::memory_order_release);
+    traceRings().released.fetch_add(1, std::memory_order_relaxed);
+}
+
+// One call in this many per thread is traced; 0 outside a session. Constant
+// initialized, so testing it needs no guard.
+inline std::atomic<uint32_t> g_traceSampleEvery{0};
+
+// The single branch a hook pays outside a session
+inline bool traceEnabled() {
+    return __builtin_expect(g_traceSampleEvery.load(std::memory_order_relaxed) != 0, 0);
+}
+
+struct TraceThread {
+    TraceRing* ring;
+    bool       noRing;      // every ring was taken when this thread last looked
+    uint32_t   released;    // traceRings().released then; look again once it moves
+    uint32_t   untilSample;
+};
+
+inline thread_local TraceThread t_trace;
+
+// A free ring for the calling thread, or null while all kTraceRings are owned
+inline TraceRing* claimTraceRing(TraceRings& all) {
+    uint32_t tid = (uint32_t)syscall(SYS_gettid);
+    for (TraceRing& r : all.rings) {
+        uint32_t free = 0;
+        if (r.owner.load(std::memory_order_relaxed) == 0 &&
+            r.owner.compare_exchange_strong(free, tid, std::memory_order_acquire)) {
+            r.tid = tid;
+            pthread_setspecific(all.exitKey, &r);
+            return &r;
+        }
+    }
+    return nullptr;
+}
+
+__attribute__((noinline)) inline void traceHookCall(int id) {
+    TraceThread& t = t_trace;
+    if (t.untilSample) {
+        t.untilSample--;
+        return;
+    }
+    uint32_t every = g_traceSampleEvery.load(std::memory_order_relaxed);
+    t.untilSample = every ? every - 1 : 0;
+
+    TraceRings& all = traceRings();
+    if (!t.ring) {
+        uint32_t released = all.released.load(std::memory_order_relaxed);
+        if (!t.noRing || t.released != released) t.ring = claimTraceRing(all);
+        if (!t.ring) {
+            t.noRing = true;
+            t.released = released;
+            all.unringed.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    TraceRing& r = *t.ring;
+    uint32_t head = r.head.load(std::memory_order_relaxed);
+    if (head - r.tail.load(std::memory_order_acquire) == kTraceRingEvents) {
+        r.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    auto& e = r.events[head & (kTraceRingEvents - 1)];
+    e.timeNs = statsClockNs(CLOCK_BOOTTIME);
+    e.tidHook = r.tid << 8 | (uint32_t)id;
+    r.head.store(head + 1, std::memory_order_release);
+}
+
+// Move every ring's events into the package buffer; controller thread only
+inline void drainTraceRings(TraceBuffer* buf, uint32_t pid) {
+    TraceRings& all = traceRings();
+    uint32_t unringed = all.unringed.exchange(0, std::memory_order_relaxed);
+    if (unringed) buf->dropped.fetch_add(unringed, std::memory_order_relaxed);
+    for (TraceRing& r : all.rings) {
+        uint32_t tail = r.tail.load(std::memory_order_relaxed);
+        uint32_t n = r.head.load(std::memory_order_acquire) - tail;
+        uint32_t lost = r.dropped.exchange(0, std::memory_order_relaxed);
+        if (lost) buf->dropped.fetch_add(lost, std::memory_order_relaxed);
+        if (!n) continue;
+
+        uint32_t at = buf->head.fetch_add(n, std::memory_order_relaxed);
+        for (uint32_t k = 0; k < n; k++, at++) {
+            const auto& e = r.events[(tail + k) & (kTraceRingEvents - 1)];
+            if (at >= kTraceBufferEvents) {
+                buf->dropped.fetch_add(n - k, std::memory_order_relaxed);
+                break;
+            }
+            TraceSlot& s = buf->slots[at];
+            s.pid.store(pid, std::memory_order_relaxed);
+            s.tidHook.store(e.tidHook, std::memory_order_relaxed);
+            s.timeNs.store(e.timeNs, std::memory_order_release);
+        }
+        r.tail.store(tail + n, std::memory_order_release);
+    }
+}
+
+#endif  // MOCKGPS_TELEMETRY